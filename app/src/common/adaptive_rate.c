@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+#include <stdlib.h>
+#include <string.h>
+#include "adaptive_rate.h"
+
+static const uint16_t adaptive_rate_invalid[AGGREGATE_CHANNELS] = {
+    SENSOR_FLAG_TEMP_INVALID,
+    SENSOR_FLAG_HUMIDITY_INVALID,
+    SENSOR_FLAG_PRESSURE_INVALID,
+};
+
+static int32_t adaptive_rate_value(const struct sensor_data_msg *msg, int channel)
+{
+    switch (channel) {
+    case 0:
+        return msg->temperature_centi_c;
+    case 1:
+        return msg->humidity_deci_pct;
+    default:
+        return msg->pressure_pa_off;
+    }
+}
+
+void adaptive_rate_init(struct adaptive_rate *ar, const struct adaptive_rate_config *config,
+                        uint32_t period_ms)
+{
+    memset(ar, 0, sizeof(*ar));
+    ar->config = *config;
+    ar->period_ms = CLAMP(period_ms, config->min_ms, config->max_ms);
+}
+
+/* Fastest change between two samples of one sensor, in percent of its threshold */
+static uint32_t adaptive_rate_activity(const struct adaptive_rate *ar,
+                                       const struct sensor_data_msg *prev,
+                                       const struct sensor_data_msg *msg)
+{
+    uint32_t elapsed_ms = msg->timestamp - prev->timestamp;
+    uint32_t activity = 0;
+
+    if (elapsed_ms == 0) {
+        return 0;
+    }
+
+    for (int c = 0; c < AGGREGATE_CHANNELS; c++) {
+        if (ar->config.threshold[c] == 0 ||
+            ((prev->flags | msg->flags) & adaptive_rate_invalid[c])) {
+            continue;
+        }
+
+        uint32_t delta = (uint32_t)abs(adaptive_rate_value(msg, c) - adaptive_rate_value(prev, c));
+
+        /* One count is quantisation, otherwise short periods would never look quiet */
+        delta = (delta > 1U) ? delta - 1U : 0U;
+
+        uint64_t per_minute = (uint64_t)delta * 60000U / elapsed_ms;
+        uint64_t pct = per_minute * 100U / ar->config.threshold[c];
+
+        activity = MAX(activity, (uint32_t)MIN(pct, UINT32_MAX));
+    }
+
+    return activity;
+}
+
+void adaptive_rate_add(struct adaptive_rate *ar, const struct sensor_data_msg *msg)
+{
+    uint8_t id = sensor_data_id(msg);
+
+    if (msg->flags & SENSOR_FLAG_ERROR) {
+        return;
+    }
+
+    if (ar->present & BIT(id)) {
+        uint32_t activity = adaptive_rate_activity(ar, &ar->last[id], msg);
+
+        ar->peak_pct = MAX(ar->peak_pct, activity);
+        ar->measured = true;
+    }
+
+    ar->present |= BIT(id);
+    ar->last[id] = *msg;
+}
+
+uint32_t adaptive_rate_update(struct adaptive_rate *ar, const struct sensor_data_msg *msg)
+{
+    adaptive_rate_add(ar, msg);
+
+    // Nothing to decide on before a second sample of some sensor
+    if (!ar->measured) {
+        return ar->period_ms;
+    }
+
+    ar->activity_pct = ar->peak_pct;
+    ar->peak_pct = 0;
+    ar->measured = false;
+
+    if (ar->activity_pct >= 100U) {
+        ar->quiet = 0;
+        ar->period_ms = MAX(ar->period_ms / 2U, ar->config.min_ms);
+    } else if (ar->activity_pct < ADAPTIVE_RATE_QUIET_PCT) {
+        if (++ar->quiet >= ADAPTIVE_RATE_QUIET_SAMPLES) {
+            ar->quiet = 0;
+            ar->period_ms = (uint32_t)MIN((uint64_t)ar->period_ms + ar->period_ms / 2U,
+                                          ar->config.max_ms);
+        }
+    } else {
+        ar->quiet = 0;
+    }
+
+    return ar->period_ms;
+}
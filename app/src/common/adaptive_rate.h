@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_ADAPTIVE_RATE_H
+#define WEATHER_STATION_ADAPTIVE_RATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "messages.h"
+
+/*
+ * Sampling period controller driven by the rate of change of the samples.
+ *
+ * Every sample is compared with the previous one of the same sensor and
+ * the change of each channel is scaled to a rate per minute. The period is
+ * decided once per read of all sensors, from the fastest change seen since
+ * the previous decision: halved as soon as one channel reaches its
+ * threshold, so a passing front is followed closely, and stretched by half
+ * only after ADAPTIVE_RATE_QUIET_SAMPLES decisions in a row stayed below a
+ * quarter of every threshold. The period never leaves [min_ms, max_ms].
+ */
+
+/* Consecutive quiet decisions before the period is stretched */
+#define ADAPTIVE_RATE_QUIET_SAMPLES 4
+
+/* Activity below this percentage of the thresholds counts as quiet */
+#define ADAPTIVE_RATE_QUIET_PCT 25
+
+struct adaptive_rate_config {
+    uint32_t min_ms;
+    uint32_t max_ms;
+    /* Change per minute that calls for a faster rate, in channel units, 0 ignores the channel */
+    uint32_t threshold[AGGREGATE_CHANNELS];
+};
+
+struct adaptive_rate {
+    struct adaptive_rate_config config;
+    uint32_t period_ms;
+    uint32_t activity_pct;  /* Fastest channel at the last decision, percent of its threshold */
+    uint32_t peak_pct;      /* Fastest channel since the last decision */
+    bool measured;          /* A change was measured since the last decision */
+    uint32_t quiet;         /* Quiet decisions in a row */
+    uint32_t present;       /* BIT(sensor id) of the ids in last */
+    struct sensor_data_msg last[SENSOR_ID_MAX + 1];
+};
+
+/* Start from period_ms, clamped to the configured bounds */
+void adaptive_rate_init(struct adaptive_rate *ar, const struct adaptive_rate_config *config,
+                        uint32_t period_ms);
+
+/* Account for a published sample without deciding on the period */
+void adaptive_rate_add(struct adaptive_rate *ar, const struct sensor_data_msg *msg);
+
+/*
+ * Account for a published sample, decide on the period and return the one
+ * to sample at from now on. Called for one sample per read, the others go
+ * through adaptive_rate_add.
+ */
+uint32_t adaptive_rate_update(struct adaptive_rate *ar, const struct sensor_data_msg *msg);
+
+#endif /* WEATHER_STATION_ADAPTIVE_RATE_H */
@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_AGGREGATOR_H
+#define WEATHER_STATION_AGGREGATOR_H
+
+#include "messages.h"
+
+/* Short window name as used by the shell ("1m", "1h", "24h", "all") */
+const char *aggregator_window_name(enum aggregate_window window);
+
+/* Look up a window by name, returns the window or -ENOENT */
+int aggregator_window_by_name(const char *name);
+
+/**
+ * @brief Statistics of a window, ending now
+ *
+ * @return 0 on success, -EINVAL on an unknown window
+ */
+int aggregator_query(enum aggregate_window window, struct aggregate_msg *out);
+
+#endif /* WEATHER_STATION_AGGREGATOR_H */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+#include "block_index.h"
+
+static inline struct block_index_entry *block_index_at(const struct block_index *idx,
+                                                       uint32_t pos)
+{
+    return &idx->entries[pos % idx->size];
+}
+
+void block_index_reset(struct block_index *idx)
+{
+    idx->head = 0;
+    idx->tail = 0;
+}
+
+void block_index_push(struct block_index *idx, const struct block_index_entry *entry)
+{
+    if (block_index_count(idx) == idx->size) {
+        idx->tail++;
+    }
+
+    *block_index_at(idx, idx->head) = *entry;
+    idx->head++;
+}
+
+bool block_index_extend(struct block_index *idx, uint64_t last_time)
+{
+    if (block_index_count(idx) == 0) {
+        return false;
+    }
+
+    struct block_index_entry *newest = block_index_at(idx, idx->head - 1);
+
+    newest->last_time = MAX(newest->last_time, last_time);
+    return true;
+}
+
+void block_index_drop_sector(struct block_index *idx, uint8_t sector)
+{
+    while (idx->tail != idx->head && block_index_at(idx, idx->tail)->sector == sector) {
+        idx->tail++;
+    }
+}
+
+uint32_t block_index_find(const struct block_index *idx, uint64_t time)
+{
+    uint32_t lo = idx->tail;
+    uint32_t hi = idx->head;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (block_index_at(idx, mid)->last_time < time) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+bool block_index_get(const struct block_index *idx, uint32_t pos,
+                     struct block_index_entry *entry)
+{
+    if (pos - idx->tail >= block_index_count(idx)) {
+        return false;
+    }
+
+    *entry = *block_index_at(idx, pos);
+    return true;
+}
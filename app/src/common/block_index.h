@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_BLOCK_INDEX_H
+#define WEATHER_STATION_BLOCK_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Sparse time index of stored sample blocks: one entry per block, or per
+ * group of consecutive blocks such as a flash sector, with its time range
+ * and location, oldest first.
+ *
+ * Blocks are appended in time order, so the entries are sorted by time
+ * and the first block of a range is found by binary search. Entries are
+ * addressed by absolute position, which stays valid while older entries
+ * are dropped. When the index is full the oldest entry is dropped.
+ *
+ * None of this locks; callers serialise access.
+ */
+
+struct block_index_entry {
+    uint64_t first_time;    /* ms */
+    uint64_t last_time;
+    uint32_t offset;        /* Location of the block in its storage */
+    uint16_t len;
+    uint8_t sector;         /* Erase unit the block lives in */
+    uint8_t reserved;
+};
+
+struct block_index {
+    struct block_index_entry *entries;
+    uint32_t size;
+    uint32_t head;          /* Position after the newest entry */
+    uint32_t tail;          /* Position of the oldest entry */
+};
+
+/* Define the entry storage of an index and initialise it */
+#define BLOCK_INDEX_DEFINE(_name, _size)                                             \
+    static struct block_index_entry _name##_entries[_size];                          \
+    static struct block_index _name = {                                              \
+        .entries = _name##_entries,                                                  \
+        .size = (_size),                                                             \
+    }
+
+void block_index_reset(struct block_index *idx);
+
+static inline uint32_t block_index_count(const struct block_index *idx)
+{
+    return idx->head - idx->tail;
+}
+
+/* Append the newest block, dropping the oldest entry when full */
+void block_index_push(struct block_index *idx, const struct block_index_entry *entry);
+
+/* Extend the time range of the newest entry to last_time; false if the index is empty */
+bool block_index_extend(struct block_index *idx, uint64_t last_time);
+
+/* Drop the oldest entries that live in sector, after it has been erased */
+void block_index_drop_sector(struct block_index *idx, uint8_t sector);
+
+/*
+ * Position of the first block that may hold samples at or after time,
+ * i.e. the first whose last_time is not before it. Returns head if none.
+ */
+uint32_t block_index_find(const struct block_index *idx, uint64_t time);
+
+/* Entry at an absolute position; false if it is not held anymore or yet */
+bool block_index_get(const struct block_index *idx, uint32_t pos,
+                     struct block_index_entry *entry);
+
+#endif /* WEATHER_STATION_BLOCK_INDEX_H */
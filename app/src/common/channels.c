@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/zbus/zbus.h>
+#include "messages.h"
+#include "pub_policy.h"
+
+/*
+ * Channels live apart from main() so test and benchmark images can link
+ * the real subsystems without the application entry point.
+ */
+
+// Define zbus channels (must be global)
+ZBUS_CHAN_DEFINE(ws_trigger,
+                struct trigger_msg,
+                NULL,
+                NULL,
+                ZBUS_OBSERVERS(pub_policy_lis),
+                ZBUS_MSG_INIT());
+
+ZBUS_CHAN_DEFINE(ws_sensor_data,
+                struct sensor_data_msg,
+                NULL,
+                NULL,
+                ZBUS_OBSERVERS(pub_policy_lis),
+                ZBUS_MSG_INIT());
+
+ZBUS_CHAN_DEFINE(ws_sensor_batch,
+                struct sensor_batch_msg,
+                NULL,
+                NULL,
+                ZBUS_OBSERVERS(pub_policy_lis),
+                ZBUS_MSG_INIT(.count = 0));
+
+ZBUS_CHAN_DEFINE(ws_aggregate,
+                struct aggregate_msg,
+                NULL,
+                NULL,
+                ZBUS_OBSERVERS_EMPTY,
+                ZBUS_MSG_INIT(.window = AGGREGATE_WINDOW_1M));
+
+ZBUS_CHAN_DEFINE(ws_derived,
+                struct derived_data_msg,
+                NULL,
+                NULL,
+                ZBUS_OBSERVERS_EMPTY,
+                ZBUS_MSG_INIT(.flags = DERIVED_FLAG_DEW_POINT_INVALID |
+                                       DERIVED_FLAG_HEAT_INDEX_INVALID |
+                                       DERIVED_FLAG_ABS_HUMIDITY_INVALID |
+                                       DERIVED_FLAG_SEA_LEVEL_INVALID));
+
+/* Overload policy of each channel, see pub_policy.h */
+#define PUB_POLICY(sym)                                                                      \
+    (IS_ENABLED(CONFIG_WEATHER_STATION_PUB_##sym##_DROP_NEWEST) ? PUB_POLICY_DROP_NEWEST :   \
+     IS_ENABLED(CONFIG_WEATHER_STATION_PUB_##sym##_DROP_OLDEST) ? PUB_POLICY_DROP_OLDEST :   \
+                                                                  PUB_POLICY_BLOCK)
+
+#define PUB_CHANNEL(chan_name, sym)                                                          \
+    {                                                                                        \
+        .chan = &chan_name,                                                                  \
+        .name = #chan_name,                                                                  \
+        .policy = PUB_POLICY(sym),                                                           \
+        .timeout_ms = CONFIG_WEATHER_STATION_PUB_##sym##_TIMEOUT_MS,                         \
+        .depth = CONFIG_WEATHER_STATION_PUB_##sym##_QUEUE_DEPTH,                             \
+    }
+
+/* Channels with subscribers, ws_aggregate and ws_derived are published without a policy */
+struct pub_channel pub_channels[] = {
+    PUB_CHANNEL(ws_trigger, TRIGGER),
+    PUB_CHANNEL(ws_sensor_data, SENSOR_DATA),
+    PUB_CHANNEL(ws_sensor_batch, SENSOR_BATCH),
+};
+
+const size_t pub_channel_count = ARRAY_SIZE(pub_channels);
+
+PUB_SUBSCRIBER_DECLARE(sensor_mgr_sub);
+PUB_SUBSCRIBER_DECLARE(shell_iface_sub);
+PUB_SUBSCRIBER_DECLARE(aggregator_sub);
+PUB_SUBSCRIBER_DECLARE(display_mgr_sub);
+#if defined(CONFIG_WEATHER_STATION_FLASH_LOG)
+PUB_SUBSCRIBER_DECLARE(flash_log_sub);
+#endif
+#if defined(CONFIG_WEATHER_STATION_DERIVED)
+PUB_SUBSCRIBER_DECLARE(derived_mgr_sub);
+#endif
+
+/* A queue holds up to the channel depth of its messages */
+#define PUB_QUEUE(chan_name, sym, msg_type, sub_name)                                        \
+    {                                                                                        \
+        .chan = &chan_name,                                                                  \
+        .sub = &sub_name,                                                                    \
+        .ring = MSG_RING_INIT(msg_type, CONFIG_WEATHER_STATION_PUB_##sym##_QUEUE_DEPTH),     \
+        .enabled = true,                                                                     \
+    }
+
+/* Every subscriber of every channel above */
+struct pub_queue pub_queues[] = {
+    PUB_QUEUE(ws_trigger, TRIGGER, struct trigger_msg, sensor_mgr_sub),
+    PUB_QUEUE(ws_sensor_data, SENSOR_DATA, struct sensor_data_msg, shell_iface_sub),
+    PUB_QUEUE(ws_sensor_data, SENSOR_DATA, struct sensor_data_msg, sensor_mgr_sub),
+    PUB_QUEUE(ws_sensor_data, SENSOR_DATA, struct sensor_data_msg, aggregator_sub),
+#if defined(CONFIG_WEATHER_STATION_DERIVED)
+    PUB_QUEUE(ws_sensor_data, SENSOR_DATA, struct sensor_data_msg, derived_mgr_sub),
+#endif
+    PUB_QUEUE(ws_sensor_batch, SENSOR_BATCH, struct sensor_batch_msg, display_mgr_sub),
+#if defined(CONFIG_WEATHER_STATION_FLASH_LOG)
+    PUB_QUEUE(ws_sensor_batch, SENSOR_BATCH, struct sensor_batch_msg, flash_log_sub),
+#endif
+};
+
+const size_t pub_queue_count = ARRAY_SIZE(pub_queues);
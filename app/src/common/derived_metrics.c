@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <stdlib.h>
+#include "derived_metrics.h"
+
+/*
+ * Saturation vapour pressure over water in centi-Pa from -40 °C to 60 °C in
+ * 1 °C steps, 610.94 * exp(17.625 * T / (T + 243.04)) Pa (Alduchov and
+ * Eskridge). The function is convex, so linear interpolation overestimates
+ * it by at most 0.12 % between two entries.
+ */
+static const uint32_t derived_svp_table[] = {
+    1897, 2103, 2330, 2579, 2851, 3149, 3475, 3832, 4220, 4644, 5106, 5609, 6156, 6751, 7397,
+    8098, 8857, 9681, 10572, 11536, 12578, 13704, 14919, 16230, 17643, 19165, 20803, 22565,
+    24459, 26493, 28677, 31020, 33533, 36224, 39106, 42191, 45490, 49016, 52782, 56803, 61094,
+    65670, 70546, 75741, 81271, 87156, 93414, 100066, 107134, 114638, 122602, 131050, 140007,
+    149500, 159554, 170198, 181462, 193377, 205973, 219284, 233344, 248189, 263855, 280381,
+    297807, 316174, 335523, 355901, 377352, 399924, 423665, 448627, 474862, 502424, 531370,
+    561757, 593645, 627096, 662173, 698942, 737472, 777831, 820093, 864331, 910622, 959045,
+    1009680, 1062612, 1117926, 1175711, 1236058, 1299059, 1364812, 1433415, 1504969, 1579579,
+    1657350, 1738394, 1822823, 1910752, 2002300,
+};
+
+#define DERIVED_SVP_STEP    100     /* centi-°C between entries */
+
+BUILD_ASSERT(ARRAY_SIZE(derived_svp_table) ==
+             (DERIVED_TEMP_MAX - DERIVED_TEMP_MIN) / DERIVED_SVP_STEP + 1,
+             "Vapour pressure table does not cover the temperature range");
+
+#define Q30_ONE (1LL << 30)
+
+/* Round to nearest, d must be positive */
+static int64_t derived_div_round(int64_t n, int64_t d)
+{
+    return (n >= 0) ? (n + d / 2) / d : (n - d / 2) / d;
+}
+
+static uint32_t derived_isqrt(uint32_t value)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1U << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/* ln(1 + x) in Q30 for |x| < 0.5, Mercator series */
+static int64_t derived_ln1p_q30(int64_t x)
+{
+    int64_t sum = 0;
+    int64_t power = x;
+
+    for (int n = 1; power != 0; n++) {
+        sum += power / n;
+        power = -power * x / Q30_ONE;
+    }
+    return sum;
+}
+
+/* exp(x) in Q30 for |x| < 2, Taylor series */
+static int64_t derived_exp_q30(int64_t x)
+{
+    int64_t sum = Q30_ONE;
+    int64_t term = Q30_ONE;
+
+    for (int n = 1; term != 0; n++) {
+        term = term * x / Q30_ONE / n;
+        sum += term;
+    }
+    return sum;
+}
+
+void derived_station_init(struct derived_station *station, int32_t altitude_m)
+{
+    altitude_m = CLAMP(altitude_m, DERIVED_ALTITUDE_MIN, DERIVED_ALTITUDE_MAX);
+
+    /*
+     * ISA barometric formula, p0 = p * (1 - 2.25577e-5 * h) ^ -5.25588.
+     * Only the altitude changes the factor, so the series run once here.
+     */
+    int64_t x = -(int64_t)altitude_m * 225577 * Q30_ONE / 10000000000LL;
+    int64_t exponent = -derived_ln1p_q30(x) * 525588 / 100000;
+
+    station->altitude_m = altitude_m;
+    station->sea_level_q28 = (uint32_t)derived_div_round(derived_exp_q30(exponent), 4);
+}
+
+uint32_t derived_vapour_pressure(int32_t temp_centi_c)
+{
+    uint32_t offset = (uint32_t)(CLAMP(temp_centi_c, DERIVED_TEMP_MIN, DERIVED_TEMP_MAX) -
+                                 DERIVED_TEMP_MIN);
+    uint32_t i = offset / DERIVED_SVP_STEP;
+    uint32_t frac = offset % DERIVED_SVP_STEP;
+
+    if (frac == 0) {
+        return derived_svp_table[i];
+    }
+    return derived_svp_table[i] +
+           (derived_svp_table[i + 1] - derived_svp_table[i]) * frac / DERIVED_SVP_STEP;
+}
+
+/* Actual vapour pressure in centi-Pa */
+static uint32_t derived_vapour(int32_t temp_centi_c, uint32_t humidity_deci_pct)
+{
+    return (uint32_t)derived_div_round((int64_t)derived_vapour_pressure(temp_centi_c) *
+                                       MIN(humidity_deci_pct, 1000U), 1000);
+}
+
+int derived_dew_point(int32_t temp_centi_c, uint32_t humidity_deci_pct, int32_t *dew_centi_c)
+{
+    if (humidity_deci_pct == 0 || temp_centi_c < DERIVED_TEMP_MIN ||
+        temp_centi_c > DERIVED_TEMP_MAX) {
+        return -EDOM;
+    }
+
+    uint32_t vapour = derived_vapour(temp_centi_c, humidity_deci_pct);
+
+    if (vapour < derived_svp_table[0]) {
+        return -EDOM;
+    }
+
+    // Last entry at or below the vapour pressure, the table is increasing
+    size_t lo = 0;
+    size_t hi = ARRAY_SIZE(derived_svp_table) - 1;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi + 1) / 2;
+
+        if (derived_svp_table[mid] <= vapour) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    int32_t dew = DERIVED_TEMP_MIN + (int32_t)lo * DERIVED_SVP_STEP;
+
+    if (lo + 1 < ARRAY_SIZE(derived_svp_table)) {
+        dew += (int32_t)derived_div_round((int64_t)(vapour - derived_svp_table[lo]) *
+                                          DERIVED_SVP_STEP,
+                                          derived_svp_table[lo + 1] - derived_svp_table[lo]);
+    }
+
+    // Interpolation error must not put the dew point above the temperature
+    *dew_centi_c = MIN(dew, temp_centi_c);
+    return 0;
+}
+
+uint32_t derived_abs_humidity(int32_t temp_centi_c, uint32_t humidity_deci_pct)
+{
+    // rho = e / (Rv * T), Rv = 461.5 J/(kg K), scaled to centi-Pa, centi-K and centi-g/m³
+    int64_t kelvin = (int64_t)CLAMP(temp_centi_c, DERIVED_TEMP_MIN, DERIVED_TEMP_MAX) + 27315;
+
+    return (uint32_t)derived_div_round((int64_t)derived_vapour(temp_centi_c,
+                                                               humidity_deci_pct) * 200000,
+                                       923 * kelvin);
+}
+
+int32_t derived_heat_index(int32_t temp_centi_c, uint32_t humidity_deci_pct)
+{
+    /*
+     * The regression is defined in °F and percent: f in centi-°F, rh in
+     * deci-%. Its branches are not continuous, so they are chosen on the
+     * exact temperature, f500 = °F * 500, not on the rounded f.
+     */
+    int64_t f500 = (int64_t)temp_centi_c * 9 + 16000;
+    int64_t f = derived_div_round(f500, 5);
+    int64_t rh = MIN(humidity_deci_pct, 1000U);
+
+    // Steadman's simple formula unless its mean with the temperature reaches 80 °F
+    if (378 * (int64_t)temp_centi_c + 47 * rh < 1031000) {
+        int64_t hi = derived_div_round(f * 110 - 103000 + rh * 47, 100);
+
+        return (int32_t)derived_div_round((hi - 3200) * 5, 9);
+    }
+
+    // Coefficients scaled by 1e8, each term scaled back to °F * 1e8
+    int64_t sum = -4237900000LL +
+                  204901523LL * f / 100 +
+                  1014333127LL * rh / 10 -
+                  22475541LL * f * rh / 1000 -
+                  683783LL * f * f / 10000 -
+                  5481717LL * rh * rh / 100 +
+                  122874LL * f * f * rh / 100000 +
+                  85282LL * f * rh * rh / 10000 -
+                  199LL * f * f * rh * rh / 1000000;
+    int64_t hi = derived_div_round(sum, 1000000);
+
+    if (rh < 130 && f500 > 40000 && f500 < 56000) {
+        // ((13 - RH) / 4) * sqrt((17 - |T - 95|) / 17), the root scaled by 1e4
+        uint32_t root = derived_isqrt((uint32_t)((1700 - llabs(f - 9500)) * 100000000LL /
+                                                 1700));
+
+        hi -= derived_div_round((130 - rh) * 25 * root, 100000);
+    } else if (rh > 850 && f500 >= 40000 && f500 <= 43500) {
+        hi += derived_div_round((rh - 850) * (8700 - f), 500);
+    }
+
+    return (int32_t)derived_div_round((hi - 3200) * 5, 9);
+}
+
+uint32_t derived_sea_level(const struct derived_station *station, uint32_t pressure_pa)
+{
+    return (uint32_t)(((uint64_t)pressure_pa * station->sea_level_q28 + (1U << 27)) >> 28);
+}
+
+void derived_metrics_compute(const struct derived_station *station,
+                             const struct sensor_data_msg *sample,
+                             struct derived_data_msg *out)
+{
+    bool temp_ok = !(sample->flags & SENSOR_FLAG_TEMP_INVALID);
+    bool humidity_ok = !(sample->flags & SENSOR_FLAG_HUMIDITY_INVALID);
+    int32_t temp = sample->temperature_centi_c;
+    uint32_t humidity = sample->humidity_deci_pct;
+    int32_t dew = 0;
+
+    *out = (struct derived_data_msg){
+        .timestamp = sample->timestamp,
+        .sequence = sample->sequence,
+        .flags = sample->flags & SENSOR_ID_MASK,
+    };
+
+    if (temp_ok && humidity_ok && derived_dew_point(temp, humidity, &dew) == 0) {
+        out->dew_point_centi_c = (int16_t)dew;
+    } else {
+        out->flags |= DERIVED_FLAG_DEW_POINT_INVALID;
+    }
+
+    if (temp_ok && humidity_ok) {
+        int32_t heat = derived_heat_index(temp, humidity);
+
+        out->heat_index_centi_c = (int16_t)CLAMP(heat, INT16_MIN, INT16_MAX);
+    } else {
+        out->flags |= DERIVED_FLAG_HEAT_INDEX_INVALID;
+    }
+
+    if (temp_ok && humidity_ok && temp >= DERIVED_TEMP_MIN && temp <= DERIVED_TEMP_MAX) {
+        out->abs_humidity_centi_g_m3 = (uint16_t)derived_abs_humidity(temp, humidity);
+    } else {
+        out->flags |= DERIVED_FLAG_ABS_HUMIDITY_INVALID;
+    }
+
+    if (!(sample->flags & SENSOR_FLAG_PRESSURE_INVALID)) {
+        out->sea_level_pa = derived_sea_level(station, sensor_data_pressure(sample));
+    } else {
+        out->flags |= DERIVED_FLAG_SEA_LEVEL_INVALID;
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_DERIVED_METRICS_H
+#define WEATHER_STATION_DERIVED_METRICS_H
+
+#include <stdint.h>
+#include "messages.h"
+
+/*
+ * Meteorological metrics derived from one sample, in integer arithmetic.
+ *
+ * Inputs and outputs use the fixed-point units of the messages. Maximum
+ * errors against the floating-point formulas, checked by the unit tests
+ * and measured by the benchmark against libm (absolute humidity in g/m³):
+ *
+ *   saturation vapour pressure  0.12 %          Magnus over water, table in
+ *                                               1 °C steps, linear interpolation
+ *   dew point                   0.03 °C         inverse lookup in the same table
+ *   absolute humidity           0.12 % + 0.01   ideal gas law on the table value
+ *   heat index                  0.03 °C         NWS Rothfusz regression and its
+ *                                               adjustments, integer square root,
+ *                                               for heat indices up to 70 °C
+ *   sea-level pressure          1 Pa            ISA reduction, altitude factor
+ *                                               computed once per station
+ *
+ * Vapour pressure, dew point and absolute humidity are only defined for
+ * temperatures and dew points from DERIVED_TEMP_MIN to DERIVED_TEMP_MAX.
+ */
+
+#define DERIVED_TEMP_MIN    (-4000)     /* centi-°C */
+#define DERIVED_TEMP_MAX    6000        /* centi-°C */
+
+/* Altitude range of the sea-level reduction, metres */
+#define DERIVED_ALTITUDE_MIN    (-500)
+#define DERIVED_ALTITUDE_MAX    9000
+
+/* Per-station constants, computed once by derived_station_init() */
+struct derived_station {
+    int32_t altitude_m;
+    uint32_t sea_level_q28;     /* Sea-level over station pressure, Q4.28 */
+};
+
+/* Clamps the altitude to the supported range */
+void derived_station_init(struct derived_station *station, int32_t altitude_m);
+
+/* Saturation vapour pressure over water in centi-Pa, temp_centi_c must be in range */
+uint32_t derived_vapour_pressure(int32_t temp_centi_c);
+
+/**
+ * @brief Dew point in centi-°C
+ *
+ * @return 0 on success, -EDOM if humidity is 0 or the temperature or the
+ *         dew point is out of range
+ */
+int derived_dew_point(int32_t temp_centi_c, uint32_t humidity_deci_pct, int32_t *dew_centi_c);
+
+/* Absolute humidity in centi-g/m³, temp_centi_c must be in range */
+uint32_t derived_abs_humidity(int32_t temp_centi_c, uint32_t humidity_deci_pct);
+
+/* NWS heat index in centi-°C, close to the temperature in cool weather */
+int32_t derived_heat_index(int32_t temp_centi_c, uint32_t humidity_deci_pct);
+
+/* Station pressure reduced to sea level, Pa */
+uint32_t derived_sea_level(const struct derived_station *station, uint32_t pressure_pa);
+
+/* All metrics of a sample, fields the sample cannot give are flagged invalid */
+void derived_metrics_compute(const struct derived_station *station,
+                             const struct sensor_data_msg *sample,
+                             struct derived_data_msg *out);
+
+#endif /* WEATHER_STATION_DERIVED_METRICS_H */
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_DISPLAY_FB_H
+#define WEATHER_STATION_DISPLAY_FB_H
+
+#include "messages.h"
+
+/*
+ * Sample rendering on the chosen zephyr,display device.
+ *
+ * Fields are laid out on a fixed character grid drawn with a built-in
+ * 5x7 font. The text on screen is cached per field, and a render only
+ * writes the glyph cells whose character changed, so a steady reading
+ * costs nothing but a string compare.
+ */
+
+/**
+ * @brief Set up the display and draw the static layout
+ *
+ * @return 0 on success, -ENODEV if the display is not ready, -ENOTSUP if
+ *         no usable pixel format or the layout does not fit
+ */
+int display_fb_init(void);
+
+/**
+ * @brief Draw the fields of a sample that differ from what is on screen
+ *
+ * @return Number of fields redrawn, or a negative errno from the display
+ */
+int display_fb_render(const struct sensor_data_msg *msg);
+
+#endif /* WEATHER_STATION_DISPLAY_FB_H */
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_FAKE_SENSOR_H
+#define WEATHER_STATION_FAKE_SENSOR_H
+
+#include <zephyr/device.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "messages.h"
+
+/*
+ * Every enabled "ws,fake-sensor" devicetree node is an instance, readable
+ * through the sensor API and RTIO. Its sensor-id property is tagged on
+ * the samples it produces.
+ */
+
+/* First instance */
+#define FAKE_SENSOR_DEV DEVICE_DT_GET_ONE(ws_fake_sensor)
+
+/* Signal shape produced by a fake sensor instance */
+enum fake_sensor_waveform {
+    FAKE_SENSOR_WAVE_RANDOM_WALK,   /* Small random steps, bounded (default) */
+    FAKE_SENSOR_WAVE_SINE,          /* Sine around the nominal values */
+    FAKE_SENSOR_WAVE_STEP,          /* Square wave between low and high */
+    FAKE_SENSOR_WAVE_RAMP,          /* Sawtooth from low to high */
+    FAKE_SENSOR_WAVE_NOISE,         /* Uniform noise around the nominal values */
+};
+
+struct fake_sensor_config {
+    enum fake_sensor_waveform waveform;
+    uint32_t seed;          /* simple_prng seed, 0 keeps the current state */
+    uint32_t period;        /* Samples per cycle for sine, step and ramp */
+    bool quiet;             /* Do not print every sample to the console */
+};
+
+/**
+ * @brief Reconfigure a fake sensor instance and restart its waveform
+ *
+ * @return 0 on success, -EINVAL on a bad waveform or zero period
+ */
+int fake_sensor_configure(const struct device *dev, const struct fake_sensor_config *cfg);
+
+/**
+ * @brief Generate count samples in one call, without console output
+ *
+ * Samples are stamped with the current uptime and consecutive sequence
+ * numbers. Meant to drive the pipeline at rates a real sensor never would.
+ *
+ * @return 0 on success, -EINVAL on bad arguments
+ */
+int fake_sensor_fill(const struct device *dev, struct sensor_data_msg *samples, size_t count);
+
+/* Latest readings of an instance */
+int fake_sensor_get_readings(const struct device *dev, float *temperature, float *humidity,
+                             float *pressure);
+
+#endif /* WEATHER_STATION_FAKE_SENSOR_H */
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_FLASH_LOG_H
+#define WEATHER_STATION_FLASH_LOG_H
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "log_block.h"
+#include "sample_query.h"
+
+/*
+ * Persistent sample log on the storage partition.
+ *
+ * Samples from ws_sensor_batch are compressed with the sample codec into a
+ * RAM block and appended to a flash circular buffer (FCB) as one entry once
+ * the block is full, so the flash sees one write per
+ * CONFIG_WEATHER_STATION_FLASH_LOG_BLOCK_SIZE bytes, a few dozen samples,
+ * and a sector erase only when the log wraps. The oldest sector is dropped
+ * when the partition is full.
+ *
+ * Every block carries a sequence number, see log_block.h for the block
+ * format. FCB checks each entry with a CRC, so a block torn by a reset is
+ * skipped, and only samples still in RAM are lost. At boot the newest
+ * block is found by scanning the sector headers and the entries of the
+ * active sector, and the query index by reading the first block of each
+ * sector, whatever the log size.
+ *
+ * Log time is the sample uptime plus the end of the log found at boot, so
+ * it keeps increasing across reboots. It counts ms the device has been
+ * sampling, not wall clock time, in 64 bits so it never wraps.
+ */
+
+struct flash_log_info {
+    bool ready;             /* Recovery has completed */
+    uint32_t sector_count;
+    uint32_t sector_size;
+    uint32_t used_sectors;
+    bool has_blocks;
+    uint32_t oldest_sequence;
+    uint64_t oldest_time;
+    uint32_t newest_sequence;
+    uint64_t newest_time;
+    uint32_t pending;       /* Samples buffered in RAM */
+    uint32_t blocks_written;    /* Since boot */
+    uint32_t bytes_written;
+    uint32_t sectors_erased;
+    uint32_t write_errors;
+    uint32_t recovery_blocks;   /* Blocks read by the boot scan */
+    uint32_t recovery_us;
+    uint32_t index_sectors;     /* Sectors the query index covers */
+    uint32_t index_us;          /* Time taken to build the index at boot */
+};
+
+/* Called for each logged sample, oldest first; return false to stop */
+typedef bool (*sample_record_cb)(const struct sample_record *rec, void *user_data);
+
+#if defined(CONFIG_WEATHER_STATION_FLASH_LOG)
+
+int flash_log_get_info(struct flash_log_info *info);
+
+/* Write the samples buffered in RAM as a (partial) block */
+int flash_log_flush(void);
+
+/* Erase the whole log; sequence numbers and log time carry on, across reboots too */
+int flash_log_clear(void);
+
+/* Current log time, ms */
+uint64_t flash_log_now(void);
+
+/**
+ * @brief Hand the logged samples of [from, to] to the callback
+ *
+ * Only one block is held in RAM at a time, whatever the range. Samples not
+ * yet written to flash are included.
+ *
+ * @return 0 on success, -EINVAL on a bad range, -EAGAIN while the log is
+ *         being recovered, or a flash read error
+ */
+int flash_log_read(uint64_t from, uint64_t to, sample_record_cb cb, void *user_data);
+
+/**
+ * @brief Aggregate the logged samples of [from, to] into step-sized buckets
+ *
+ * Reading starts at the sector found by binary search in the sector
+ * index, and the blocks overlapping the range are decoded one at a time.
+ * Buckets are handed to the callback as they complete, oldest first.
+ * Samples not yet written to flash are included.
+ *
+ * @return 0 on success, -EINVAL on a bad range or aggregate, -EAGAIN while
+ *         the log is being recovered, or a flash read error
+ */
+int flash_log_query(uint64_t from, uint64_t to, uint32_t step, enum sample_agg agg,
+                    sample_bucket_cb cb, void *user_data);
+
+#else
+
+static inline int flash_log_get_info(struct flash_log_info *info)
+{
+    *info = (struct flash_log_info){0};
+    return -ENOTSUP;
+}
+
+static inline int flash_log_flush(void)
+{
+    return -ENOTSUP;
+}
+
+static inline int flash_log_clear(void)
+{
+    return -ENOTSUP;
+}
+
+static inline uint64_t flash_log_now(void)
+{
+    return (uint64_t)k_uptime_get();
+}
+
+static inline int flash_log_read(uint64_t from, uint64_t to, sample_record_cb cb,
+                                 void *user_data)
+{
+    ARG_UNUSED(from);
+    ARG_UNUSED(to);
+    ARG_UNUSED(cb);
+    ARG_UNUSED(user_data);
+    return -ENOTSUP;
+}
+
+static inline int flash_log_query(uint64_t from, uint64_t to, uint32_t step,
+                                  enum sample_agg agg, sample_bucket_cb cb, void *user_data)
+{
+    ARG_UNUSED(from);
+    ARG_UNUSED(to);
+    ARG_UNUSED(step);
+    ARG_UNUSED(agg);
+    ARG_UNUSED(cb);
+    ARG_UNUSED(user_data);
+    return -ENOTSUP;
+}
+
+#endif /* CONFIG_WEATHER_STATION_FLASH_LOG */
+
+#endif /* WEATHER_STATION_FLASH_LOG_H */
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include "latency_stats.h"
+
+/* Publish stamps kept per sequence number, enough for the samples in flight */
+#define LATENCY_STATS_SLOTS 16
+#define LATENCY_SLOT_VALID  BIT(16)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(LATENCY_STATS_SLOTS));
+
+struct latency_histogram {
+    atomic_t buckets[LATENCY_STATS_BUCKETS];
+    atomic_t max;
+};
+
+struct latency_slot {
+    atomic_t sequence;      /* Sequence | LATENCY_SLOT_VALID, 0 while written */
+    atomic_t stamp;
+};
+
+static struct latency_histogram latency_histograms[LATENCY_STAGE_COUNT];
+static struct latency_slot latency_slots[LATENCY_STATS_SLOTS];
+
+static const char *const latency_stage_names[LATENCY_STAGE_COUNT] = {
+    [LATENCY_STAGE_TRIGGER] = "trigger",
+    [LATENCY_STAGE_ACQUIRE] = "acquire",
+    [LATENCY_STAGE_DECODE] = "decode",
+    [LATENCY_STAGE_SHELL] = "shell",
+    [LATENCY_STAGE_BATCHER] = "batcher",
+    [LATENCY_STAGE_DISPLAY] = "display",
+};
+
+const char *latency_stats_stage_name(enum latency_stage stage)
+{
+    return (stage < LATENCY_STAGE_COUNT) ? latency_stage_names[stage] : "?";
+}
+
+static uint32_t latency_bucket(uint32_t cycles)
+{
+    return (cycles == 0) ? 0 : 32U - (uint32_t)__builtin_clz(cycles);
+}
+
+/* Largest latency that falls into a bucket */
+static uint32_t latency_bucket_bound(uint32_t bucket)
+{
+    if (bucket == 0) {
+        return 0;
+    }
+
+    return (bucket >= 32U) ? UINT32_MAX : (uint32_t)BIT(bucket) - 1U;
+}
+
+void latency_stats_record(enum latency_stage stage, uint32_t start)
+{
+    if (start == 0 || stage >= LATENCY_STAGE_COUNT) {
+        return;
+    }
+
+    struct latency_histogram *hist = &latency_histograms[stage];
+    uint32_t cycles = k_cycle_get_32() - start;
+
+    atomic_inc(&hist->buckets[latency_bucket(cycles)]);
+
+    atomic_val_t max = atomic_get(&hist->max);
+
+    while ((uint32_t)max < cycles && !atomic_cas(&hist->max, max, (atomic_val_t)cycles)) {
+        max = atomic_get(&hist->max);
+    }
+}
+
+void latency_stats_mark_published(uint16_t sequence)
+{
+    struct latency_slot *slot = &latency_slots[sequence & (LATENCY_STATS_SLOTS - 1)];
+
+    // Invalidate first so a reader never pairs the new stamp with an old sequence
+    atomic_set(&slot->sequence, 0);
+    atomic_set(&slot->stamp, (atomic_val_t)latency_stamp());
+    atomic_set(&slot->sequence, (atomic_val_t)(sequence | LATENCY_SLOT_VALID));
+}
+
+void latency_stats_delivered(enum latency_stage stage, uint16_t sequence)
+{
+    struct latency_slot *slot = &latency_slots[sequence & (LATENCY_STATS_SLOTS - 1)];
+    atomic_val_t expected = (atomic_val_t)(sequence | LATENCY_SLOT_VALID);
+
+    if (atomic_get(&slot->sequence) != expected) {
+        return;
+    }
+
+    uint32_t stamp = (uint32_t)atomic_get(&slot->stamp);
+
+    // Rewritten under us by a newer sample, the stamp is not ours
+    if (atomic_get(&slot->sequence) != expected) {
+        return;
+    }
+
+    latency_stats_record(stage, stamp);
+}
+
+void latency_stats_summary(enum latency_stage stage, struct latency_summary *summary)
+{
+    uint32_t counts[LATENCY_STATS_BUCKETS];
+    uint64_t total = 0;
+
+    *summary = (struct latency_summary){0};
+    if (stage >= LATENCY_STAGE_COUNT) {
+        return;
+    }
+
+    struct latency_histogram *hist = &latency_histograms[stage];
+
+    // Snapshot without stopping the writers, a sample may land mid-copy
+    for (uint32_t b = 0; b < LATENCY_STATS_BUCKETS; b++) {
+        counts[b] = (uint32_t)atomic_get(&hist->buckets[b]);
+        total += counts[b];
+    }
+    if (total == 0) {
+        return;
+    }
+
+    const uint32_t pcts[] = {50, 90, 99};
+    uint32_t *out[] = {&summary->p50, &summary->p90, &summary->p99};
+    uint64_t seen = 0;
+    uint32_t b = 0;
+
+    summary->max = (uint32_t)atomic_get(&hist->max);
+    summary->count = (uint32_t)MIN(total, UINT32_MAX);
+
+    for (size_t p = 0; p < ARRAY_SIZE(pcts); p++) {
+        while (b < LATENCY_STATS_BUCKETS &&
+               (seen + counts[b]) * 100U < total * pcts[p]) {
+            seen += counts[b++];
+        }
+        *out[p] = MIN(latency_bucket_bound(MIN(b, LATENCY_STATS_BUCKETS - 1U)),
+                      summary->max);
+    }
+}
+
+void latency_stats_reset(void)
+{
+    for (size_t s = 0; s < LATENCY_STAGE_COUNT; s++) {
+        for (size_t b = 0; b < LATENCY_STATS_BUCKETS; b++) {
+            atomic_clear(&latency_histograms[s].buckets[b]);
+        }
+        atomic_clear(&latency_histograms[s].max);
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_LATENCY_STATS_H
+#define WEATHER_STATION_LATENCY_STATS_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <stdint.h>
+
+/*
+ * Per-stage pipeline latency, in hardware cycles.
+ *
+ * Each stage keeps a log2 histogram: bucket b counts latencies in
+ * [2^(b-1), 2^b) cycles. Recording is O(1), lock-free and ISR safe, so it
+ * can sit on the hot path of every stage. Percentiles are resolved to a
+ * bucket, i.e. within a factor of two, which is enough to see where the
+ * time goes.
+ *
+ * sensor_data_msg has no room for stamps, so data publish times are kept
+ * in a small table indexed by the sample sequence number, where the
+ * observers pick them up.
+ */
+
+enum latency_stage {
+    LATENCY_STAGE_TRIGGER,      /* Trigger publish -> acquisition start */
+    LATENCY_STAGE_ACQUIRE,      /* Acquisition start -> read complete */
+    LATENCY_STAGE_DECODE,       /* Read complete -> ws_sensor_data publish */
+    LATENCY_STAGE_SHELL,        /* Data publish -> shell interface */
+    LATENCY_STAGE_BATCHER,      /* Data publish -> sensor_mgr batcher */
+    LATENCY_STAGE_DISPLAY,      /* Data publish -> display, through the batch */
+    LATENCY_STAGE_COUNT
+};
+
+#define LATENCY_STATS_BUCKETS 33
+
+/* Percentiles of one stage, in cycles, rounded up to the bucket bound */
+struct latency_summary {
+    uint32_t count;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t max;
+};
+
+#if defined(CONFIG_WEATHER_STATION_LATENCY_STATS)
+
+/* Cycle stamp, 0 means "not stamped" */
+static inline uint32_t latency_stamp(void)
+{
+    uint32_t now = k_cycle_get_32();
+
+    return (now != 0) ? now : 1U;
+}
+
+const char *latency_stats_stage_name(enum latency_stage stage);
+
+/* Record the cycles elapsed since start, ignored when start is 0 */
+void latency_stats_record(enum latency_stage stage, uint32_t start);
+
+/* Remember when the sample with this sequence number was published */
+void latency_stats_mark_published(uint16_t sequence);
+
+/* Record the delivery of a sample to an observer stage */
+void latency_stats_delivered(enum latency_stage stage, uint16_t sequence);
+
+void latency_stats_summary(enum latency_stage stage, struct latency_summary *summary);
+
+void latency_stats_reset(void);
+
+#else
+
+static inline uint32_t latency_stamp(void)
+{
+    return 0;
+}
+
+static inline const char *latency_stats_stage_name(enum latency_stage stage)
+{
+    ARG_UNUSED(stage);
+    return "";
+}
+
+static inline void latency_stats_record(enum latency_stage stage, uint32_t start)
+{
+    ARG_UNUSED(stage);
+    ARG_UNUSED(start);
+}
+
+static inline void latency_stats_mark_published(uint16_t sequence)
+{
+    ARG_UNUSED(sequence);
+}
+
+static inline void latency_stats_delivered(enum latency_stage stage, uint16_t sequence)
+{
+    ARG_UNUSED(stage);
+    ARG_UNUSED(sequence);
+}
+
+static inline void latency_stats_summary(enum latency_stage stage,
+                                         struct latency_summary *summary)
+{
+    ARG_UNUSED(stage);
+    *summary = (struct latency_summary){0};
+}
+
+static inline void latency_stats_reset(void)
+{
+}
+
+#endif /* CONFIG_WEATHER_STATION_LATENCY_STATS */
+
+#endif /* WEATHER_STATION_LATENCY_STATS_H */
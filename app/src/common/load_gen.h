@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_LOAD_GEN_H
+#define WEATHER_STATION_LOAD_GEN_H
+
+#include <stdint.h>
+#include "messages.h"
+
+/*
+ * Load generator for a running image, driven from "ws bench".
+ *
+ * A dedicated thread publishes either TRIGGER_BENCH triggers on ws_trigger
+ * at a fixed rate, or copies of the latest sample on ws_sensor_data back
+ * to back. Both end up as samples marked SENSOR_FLAG_SYNTHETIC, which no
+ * consumer stores or counts: the sensor manager marks the reads it does
+ * for bench triggers only. A bench trigger folded into a read started by
+ * any other source yields a real sample.
+ *
+ * Each message is stamped with the cycle counter and matched when a
+ * synthetic sample reaches the shell interface thread: by sequence for
+ * samples, by the primary probe's trigger_seq and coalesced count for
+ * triggers, so the triggers folded into a read are served by it. A trigger
+ * folded into a real read is served by the next sample of the run. The
+ * matching lives in load_match.h.
+ *
+ * Bench triggers carry their own numbering. Generated samples start half
+ * the 16-bit range away from the sequence numbers the pipeline is using.
+ */
+
+#define LOAD_GEN_MAX_RATE_HZ    1000U
+
+enum load_gen_mode {
+    LOAD_GEN_TRIGGER,       /* Triggers on ws_trigger at a fixed rate */
+    LOAD_GEN_PUBLISH,       /* Samples on ws_sensor_data, back to back */
+};
+
+struct load_gen_result {
+    uint32_t sent;          /* Messages published */
+    uint32_t dropped;       /* Publishes failed with -ENOBUFS */
+    uint32_t timeouts;      /* Publishes failed with -EAGAIN */
+    uint32_t errors;        /* Publishes failed otherwise */
+    uint32_t delivered;     /* Messages matched by a sample at the shell interface */
+    uint32_t send_us;       /* First to last publish */
+    uint32_t elapsed_us;    /* First publish to the last delivery or publish, if later */
+    uint32_t p50_us;        /* End-to-end latency percentiles of the delivered ones */
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    int32_t cpu_permille;   /* Non-idle CPU time during the run, -1 if not measured */
+};
+
+/**
+ * @brief Run the generator and wait for it to finish
+ *
+ * After the last publish the run waits up to
+ * CONFIG_WEATHER_STATION_LOAD_GEN_DRAIN_MS for the outstanding messages.
+ *
+ * @param mode Messages to generate
+ * @param count Number of messages, 1 to CONFIG_WEATHER_STATION_LOAD_GEN_MAX_COUNT
+ * @param rate_hz Publish rate for LOAD_GEN_TRIGGER, 1 to LOAD_GEN_MAX_RATE_HZ, ignored otherwise
+ * @param result Filled in on success
+ * @return 0 on success, -EINVAL if count or rate is out of range, -EBUSY if
+ *         a run is in progress
+ */
+int load_gen_run(enum load_gen_mode mode, uint32_t count, uint32_t rate_hz,
+                 struct load_gen_result *result);
+
+/* Match a sample delivered to the shell interface against the running load */
+void load_gen_delivered(const struct sensor_data_msg *msg);
+
+#endif /* WEATHER_STATION_LOAD_GEN_H */
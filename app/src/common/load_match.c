@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <stdlib.h>
+#include "load_match.h"
+
+void load_match_start(struct load_match *match, uint16_t base, uint16_t seq_mask, bool folded)
+{
+    match->base = base;
+    match->seq_mask = seq_mask;
+    match->folded = folded;
+    match->sent = 0;
+    match->next = 0;
+    match->outstanding = 0;
+}
+
+int load_match_sent(struct load_match *match, uint32_t index, uint32_t stamp)
+{
+    if (index >= match->capacity) {
+        return -ENOSPC;
+    }
+
+    match->cycles[index] = stamp;
+    match->state[index] = LOAD_MATCH_PENDING;
+    match->sent = index + 1;
+    match->outstanding++;
+    return 0;
+}
+
+void load_match_failed(struct load_match *match, uint32_t index)
+{
+    if (index < match->sent && match->state[index] == LOAD_MATCH_PENDING) {
+        match->state[index] = LOAD_MATCH_FAILED;
+        match->outstanding--;
+    }
+}
+
+uint32_t load_match_delivered(struct load_match *match, uint16_t seq, uint32_t extra,
+                              uint32_t now)
+{
+    // Distance from the oldest matchable message within the sequence bits,
+    // so runs across the wrap still match and passed messages land past sent
+    uint32_t ahead = (uint16_t)(seq - match->base - match->next) & match->seq_mask;
+    uint32_t index = match->next + ahead;
+    uint32_t served = 0;
+
+    if (index >= match->sent) {
+        return 0;
+    }
+
+    uint32_t last = MIN(index + extra, match->sent - 1U);
+
+    for (uint32_t i = match->folded ? match->next : index; i <= last; i++) {
+        if (match->state[i] == LOAD_MATCH_PENDING) {
+            match->cycles[i] = now - match->cycles[i];
+            match->state[i] = LOAD_MATCH_DONE;
+            match->outstanding--;
+            served++;
+        }
+    }
+    match->next = last + 1;
+
+    return served;
+}
+
+static int load_match_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+uint32_t load_match_collect(struct load_match *match)
+{
+    uint32_t delivered = 0;
+
+    for (uint32_t i = 0; i < match->sent; i++) {
+        if (match->state[i] == LOAD_MATCH_DONE) {
+            match->cycles[delivered++] = match->cycles[i];
+        }
+    }
+    match->next = match->sent;
+
+    qsort(match->cycles, delivered, sizeof(match->cycles[0]), load_match_cmp);
+    return delivered;
+}
+
+uint32_t load_match_percentile(const uint32_t *sorted, size_t count, uint32_t pct)
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t index = (count * pct + 99U) / 100U;
+
+    index = CLAMP(index, 1U, count);
+    return sorted[index - 1U];
+}
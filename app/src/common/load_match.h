@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_LOAD_MATCH_H
+#define WEATHER_STATION_LOAD_MATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Bookkeeping of the messages of one load generator run.
+ *
+ * Message index of a run carries the sequence base + index, truncated to
+ * the bits of seq_mask, so a run may wrap around zero. Each message is
+ * stamped when it is sent and matched by the sample that names its
+ * sequence, counting from the oldest message still matchable. A sample
+ * also serves the messages folded into its read after the one it names,
+ * and with folded set, as for triggers, every earlier message still
+ * pending: those folded into reads the run did not start. A sample naming
+ * a message already passed or not yet sent is ignored. Messages neither
+ * failed nor delivered by the end of a run were lost.
+ *
+ * Stamps are cycle counts, differences are taken modulo 2^32. Not thread
+ * safe, callers serialise access with their own lock.
+ */
+
+enum load_match_state {
+    LOAD_MATCH_PENDING,
+    LOAD_MATCH_FAILED,
+    LOAD_MATCH_DONE,
+};
+
+struct load_match {
+    uint32_t *cycles;       /* Send stamp while pending, latency once delivered */
+    uint8_t *state;         /* enum load_match_state of each message */
+    uint32_t capacity;
+    uint16_t base;          /* Sequence of message 0 */
+    uint16_t seq_mask;      /* Bits of the sequence samples carry */
+    bool folded;
+    uint32_t sent;          /* Messages stamped so far */
+    uint32_t next;          /* Oldest message a sample can still match */
+    uint32_t outstanding;   /* Sent, neither failed nor delivered */
+};
+
+/* Initializer with static storage for n messages */
+#define LOAD_MATCH_INIT(n)                                                                   \
+    {                                                                                        \
+        .cycles = (uint32_t[(n)]){0},                                                        \
+        .state = (uint8_t[(n)]){0},                                                          \
+        .capacity = (n),                                                                     \
+    }
+
+/* Start a run whose first message carries sequence base */
+void load_match_start(struct load_match *match, uint16_t base, uint16_t seq_mask, bool folded);
+
+/* Message index, the next one, is being sent at stamp. Returns 0 or -ENOSPC */
+int load_match_sent(struct load_match *match, uint32_t index, uint32_t stamp);
+
+/* Sending message index failed, it will not be delivered */
+void load_match_failed(struct load_match *match, uint32_t index);
+
+/*
+ * Match a sample naming sequence seq, with extra messages folded in after
+ * it, delivered at stamp now. Returns the messages it served.
+ */
+uint32_t load_match_delivered(struct load_match *match, uint16_t seq, uint32_t extra,
+                              uint32_t now);
+
+/*
+ * Move the latencies of the delivered messages to the front of cycles,
+ * sorted in ascending order, and return their count. Ends the run.
+ */
+uint32_t load_match_collect(struct load_match *match);
+
+/* Nearest-rank percentile pct of count ascending values, 0 if count is 0 */
+uint32_t load_match_percentile(const uint32_t *sorted, size_t count, uint32_t pct);
+
+#endif /* WEATHER_STATION_LOAD_MATCH_H */
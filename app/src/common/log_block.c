@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+#include "log_block.h"
+
+int log_block_check(const uint8_t *prefix, uint32_t prefix_len, uint32_t entry_len,
+                    struct flash_log_block_hdr *hdr)
+{
+    struct sample_codec_decoder dec;
+
+    if (prefix_len < sizeof(*hdr) || entry_len < sizeof(*hdr)) {
+        return -EBADMSG;
+    }
+
+    memcpy(hdr, prefix, sizeof(*hdr));
+
+    if (hdr->first_time > hdr->last_time) {
+        return -EBADMSG;
+    }
+
+    if (hdr->format == FLASH_LOG_FORMAT_MARK) {
+        return (hdr->count == 0) ? -ENODATA : -EBADMSG;
+    }
+
+    if (hdr->format != FLASH_LOG_FORMAT_CODEC || hdr->count == 0 ||
+        prefix_len < LOG_BLOCK_PREFIX_SIZE) {
+        return -EBADMSG;
+    }
+
+    // The codec header must agree and its whole block must be in the entry
+    if (sample_codec_decoder_init(&dec, prefix + sizeof(*hdr), entry_len - sizeof(*hdr)) != 0 ||
+        dec.count != hdr->count || dec.prev.time != hdr->first_time) {
+        return -EBADMSG;
+    }
+
+    return 0;
+}
+
+void log_block_scan_init(struct log_block_scan *scan)
+{
+    memset(scan, 0, sizeof(*scan));
+}
+
+void log_block_scan_add(struct log_block_scan *scan, const uint8_t *prefix,
+                        uint32_t prefix_len, uint32_t entry_len)
+{
+    struct flash_log_block_hdr hdr;
+    int rc = log_block_check(prefix, prefix_len, entry_len, &hdr);
+
+    scan->blocks++;
+    if (rc != 0 && rc != -ENODATA) {
+        scan->invalid++;
+        return;
+    }
+
+    if (!scan->found || hdr.sequence > scan->newest.sequence) {
+        scan->newest = hdr;
+        scan->found = true;
+    }
+}
+
+void log_block_scan_resume(const struct log_block_scan *scan, uint32_t *next_sequence,
+                           uint64_t *time_base)
+{
+    if (scan->found) {
+        *next_sequence = scan->newest.sequence + 1;
+        *time_base = scan->newest.last_time + 1;
+    } else {
+        *next_sequence = 0;
+        *time_base = 0;
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_LOG_BLOCK_H
+#define WEATHER_STATION_LOG_BLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sample_codec.h"
+
+/*
+ * Blocks of the flash log and the checks of its boot scan.
+ *
+ * A sample block is a header followed by a sample_codec block. A marker
+ * block is a header alone: "ws log clear" writes one after erasing the
+ * log, so the sequence number and log time survive a reboot.
+ *
+ * FCB already skips entries that fail their CRC, such as one torn by a
+ * reset. Anything else the scan does not recognise, a header without a
+ * whole codec block behind it for instance, is skipped as well.
+ *
+ * Log time is kept in 64 bits, so it does not wrap in the life of a
+ * device. Formats 2 and 3 were the same blocks with 32-bit times; they are
+ * no longer recognised.
+ *
+ * None of this touches flash; the caller reads the entries.
+ */
+
+/* Block payload formats */
+#define FLASH_LOG_FORMAT_CODEC  4   /* A sample_codec block */
+#define FLASH_LOG_FORMAT_MARK   5   /* No payload, count is 0 */
+
+/* Header at the start of every block, followed by the payload */
+struct flash_log_block_hdr {
+    uint32_t sequence;      /* +1 per block, never reused */
+    uint16_t count;         /* Samples in the block */
+    uint8_t format;         /* FLASH_LOG_FORMAT_* */
+    uint8_t reserved;
+    uint64_t first_time;    /* Log time of the first sample, ms */
+    uint64_t last_time;     /* Log time of the last sample, ms */
+};
+
+/* Bytes read from the start of an entry to check it */
+#define LOG_BLOCK_PREFIX_SIZE   (sizeof(struct flash_log_block_hdr) + SAMPLE_CODEC_HDR_SIZE)
+
+/* Newest block seen by a scan */
+struct log_block_scan {
+    struct flash_log_block_hdr newest;
+    bool found;
+    uint32_t blocks;        /* Entries looked at */
+    uint32_t invalid;       /* Entries that are not blocks */
+};
+
+/**
+ * @brief Check an entry of the log
+ *
+ * @param prefix First bytes of the entry, up to LOG_BLOCK_PREFIX_SIZE
+ * @param prefix_len Bytes in prefix
+ * @param entry_len Length of the whole entry
+ * @param hdr Filled in with the block header unless the entry is invalid
+ * @return 0 for a sample block, -ENODATA for a marker block, -EBADMSG if
+ *         the entry is not a block
+ */
+int log_block_check(const uint8_t *prefix, uint32_t prefix_len, uint32_t entry_len,
+                    struct flash_log_block_hdr *hdr);
+
+void log_block_scan_init(struct log_block_scan *scan);
+
+/* Check one entry, keeping the block with the highest sequence number */
+void log_block_scan_add(struct log_block_scan *scan, const uint8_t *prefix,
+                        uint32_t prefix_len, uint32_t entry_len);
+
+/* A scan whose newest block holds samples, not a marker */
+static inline bool log_block_scan_has_samples(const struct log_block_scan *scan)
+{
+    return scan->found && scan->newest.format == FLASH_LOG_FORMAT_CODEC;
+}
+
+/* Sequence number and log time base to carry on from after the scan */
+void log_block_scan_resume(const struct log_block_scan *scan, uint32_t *next_sequence,
+                           uint64_t *time_base);
+
+#endif /* WEATHER_STATION_LOG_BLOCK_H */
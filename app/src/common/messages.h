@@ -10,6 +10,7 @@
 #include <zephyr/zbus/zbus.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <math.h>
 
 /* Message definitions for zbus communication */
 
@@ -18,27 +19,221 @@ struct trigger_msg {
     enum trigger_source {
         TRIGGER_MANUAL,     /* Shell command */
         TRIGGER_TIMER,      /* Periodic update */
-        TRIGGER_EXTERNAL    /* External request */
+        TRIGGER_EXTERNAL,   /* External request */
+        TRIGGER_BENCH       /* Load generator, "ws bench trigger" */
     } source;
     uint32_t sequence;      /* Request sequence number */
+    uint32_t stamp;         /* Cycle counter at publish, 0 if not stamped */
 };
 
-/* Sensor data message - publish sensor readings */
+/*
+ * Sensor data message - publish sensor readings
+ *
+ * Fixed-point wire format, 16 bytes so every observer copy stays cheap.
+ * Use the helpers below to convert from or to floating point.
+ */
 struct sensor_data_msg {
-    uint64_t timestamp;     /* k_uptime_get() value */
-    float temperature_c;    /* Celsius, NaN if invalid */
-    float humidity_percent; /* Relative humidity 0-100, NaN if invalid */
-    float pressure_pa;      /* Pascals, NaN if invalid */
-    uint32_t source_flags;  /* Bitmask: INTERNAL/EXTERNAL/etc */
-    uint32_t sequence;      /* Monotonic counter */
-    int status;            /* Error code or 0 for success */
+    uint32_t timestamp;             /* k_uptime_get_32() value, ms */
+    uint16_t sequence;              /* Monotonic counter, wraps */
+    uint8_t trigger_seq;            /* Low bits of the trigger_msg sequence the read was for */
+    uint8_t coalesced;              /* Triggers folded in after it, see below */
+    int16_t temperature_centi_c;    /* Celsius * 100 */
+    uint16_t humidity_deci_pct;     /* Relative humidity 0-1000 (percent * 10) */
+    uint16_t pressure_pa_off;       /* Pascals - SENSOR_PRESSURE_BASE_PA */
+    uint16_t flags;                 /* SENSOR_SOURCE_* and SENSOR_FLAG_* bits */
 };
 
+BUILD_ASSERT(sizeof(struct sensor_data_msg) <= 16, "sensor_data_msg must stay compact");
+
+/* Source bits */
 #define SENSOR_SOURCE_INTERNAL  BIT(0)
 #define SENSOR_SOURCE_EXTERNAL  BIT(1)
 
+/* Status bits, a field whose invalid bit is set must be ignored */
+#define SENSOR_FLAG_TEMP_INVALID        BIT(2)
+#define SENSOR_FLAG_HUMIDITY_INVALID    BIT(3)
+#define SENSOR_FLAG_PRESSURE_INVALID    BIT(4)
+#define SENSOR_FLAG_ERROR               BIT(5)  /* Acquisition failed */
+#define SENSOR_FLAG_SYNTHETIC           BIT(6)  /* Made up or read for the load generator */
+
+/* Id of the probe that took the sample, its sensor-id devicetree property */
+#define SENSOR_ID_SHIFT 8
+#define SENSOR_ID_MASK  (0xFU << SENSOR_ID_SHIFT)
+#define SENSOR_ID_MAX   15
+
+static inline uint16_t sensor_id_flags(uint8_t id)
+{
+    return (uint16_t)(((uint32_t)id << SENSOR_ID_SHIFT) & SENSOR_ID_MASK);
+}
+
+static inline uint8_t sensor_data_id(const struct sensor_data_msg *msg)
+{
+    return (uint8_t)((msg->flags & SENSOR_ID_MASK) >> SENSOR_ID_SHIFT);
+}
+
+/* Synthetic samples only exercise the pipeline, they are never stored or counted */
+static inline bool sensor_data_synthetic(const struct sensor_data_msg *msg)
+{
+    return (msg->flags & SENSOR_FLAG_SYNTHETIC) != 0;
+}
+
+/*
+ * Flags of a sample read for a trigger of source. A read serving bench
+ * triggers only is synthetic; AND in the flags of every trigger folded
+ * into it, so a real trigger among them keeps the sample.
+ */
+static inline uint16_t trigger_sample_flags(enum trigger_source source)
+{
+    return (source == TRIGGER_BENCH) ? SENSOR_FLAG_SYNTHETIC : 0;
+}
+
+/*
+ * A read serves the trigger it was started for, trigger_seq, and the
+ * triggers folded into it while in flight. Those may come from any source,
+ * each numbering its triggers on its own, so only their count is carried.
+ * It saturates at SENSOR_COALESCED_MAX.
+ */
+#define SENSOR_COALESCED_MAX    UINT8_MAX
+
+static inline void sensor_data_set_served(struct sensor_data_msg *msg, uint32_t trigger_seq,
+                                          uint32_t coalesced)
+{
+    msg->trigger_seq = (uint8_t)trigger_seq;
+    msg->coalesced = (uint8_t)MIN(coalesced, SENSOR_COALESCED_MAX);
+}
+
+/* Pressure offset, covers 500.00 hPa to 1155.34 hPa at 1 Pa resolution */
+#define SENSOR_PRESSURE_BASE_PA 50000U
+
+/* Round to the nearest integer and clamp to [min, max] */
+static inline int32_t sensor_data_to_fixed(float value, int32_t min, int32_t max)
+{
+    value += (value >= 0.0f) ? 0.5f : -0.5f;
+    if (value <= (float)min) {
+        return min;
+    }
+    if (value >= (float)max) {
+        return max;
+    }
+    return (int32_t)value;
+}
+
+/* Fill the measurement fields from floats, NaN marks a field invalid */
+static inline void sensor_data_from_float(struct sensor_data_msg *msg, float temperature_c,
+                                          float humidity_percent, float pressure_pa)
+{
+    msg->flags &= ~(SENSOR_FLAG_TEMP_INVALID | SENSOR_FLAG_HUMIDITY_INVALID |
+                    SENSOR_FLAG_PRESSURE_INVALID);
+
+    if (isnan(temperature_c)) {
+        msg->temperature_centi_c = 0;
+        msg->flags |= SENSOR_FLAG_TEMP_INVALID;
+    } else {
+        msg->temperature_centi_c = (int16_t)sensor_data_to_fixed(temperature_c * 100.0f,
+                                                                 INT16_MIN, INT16_MAX);
+    }
+
+    if (isnan(humidity_percent)) {
+        msg->humidity_deci_pct = 0;
+        msg->flags |= SENSOR_FLAG_HUMIDITY_INVALID;
+    } else {
+        msg->humidity_deci_pct = (uint16_t)sensor_data_to_fixed(humidity_percent * 10.0f,
+                                                                0, 1000);
+    }
+
+    if (isnan(pressure_pa)) {
+        msg->pressure_pa_off = 0;
+        msg->flags |= SENSOR_FLAG_PRESSURE_INVALID;
+    } else {
+        msg->pressure_pa_off = (uint16_t)sensor_data_to_fixed(
+            pressure_pa - (float)SENSOR_PRESSURE_BASE_PA, 0, UINT16_MAX);
+    }
+}
+
+/* Pressure in whole Pascals */
+static inline uint32_t sensor_data_pressure(const struct sensor_data_msg *msg)
+{
+    return (uint32_t)msg->pressure_pa_off + SENSOR_PRESSURE_BASE_PA;
+}
+
+static inline float sensor_data_temperature_c(const struct sensor_data_msg *msg)
+{
+    return (msg->flags & SENSOR_FLAG_TEMP_INVALID) ? NAN :
+           (float)msg->temperature_centi_c / 100.0f;
+}
+
+static inline float sensor_data_humidity_percent(const struct sensor_data_msg *msg)
+{
+    return (msg->flags & SENSOR_FLAG_HUMIDITY_INVALID) ? NAN :
+           (float)msg->humidity_deci_pct / 10.0f;
+}
+
+static inline float sensor_data_pressure_pa(const struct sensor_data_msg *msg)
+{
+    return (msg->flags & SENSOR_FLAG_PRESSURE_INVALID) ? NAN :
+           (float)sensor_data_pressure(msg);
+}
+
+#define SENSOR_BATCH_SIZE CONFIG_WEATHER_STATION_BATCH_SIZE
+
+/* Sensor batch message - consecutive samples, oldest first */
+struct sensor_batch_msg {
+    uint32_t count;         /* Valid entries in samples */
+    struct sensor_data_msg samples[SENSOR_BATCH_SIZE];
+};
+
+/* Aggregation windows, see the aggregator */
+enum aggregate_window {
+    AGGREGATE_WINDOW_1M,        /* Last minute */
+    AGGREGATE_WINDOW_1H,        /* Last hour */
+    AGGREGATE_WINDOW_24H,       /* Last 24 hours */
+    AGGREGATE_WINDOW_ALL,       /* Since boot */
+    AGGREGATE_WINDOW_COUNT
+};
+
+/* Temperature (centi-°C), humidity (deci-%) and pressure (Pa), in that order */
+#define AGGREGATE_CHANNELS 3
+
+/* Statistics of one channel, in the channel unit; all zero when count is 0 */
+struct aggregate_stats {
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+    uint32_t stddev;        /* Sample standard deviation */
+};
+
+/* Aggregate message - statistics of one window */
+struct aggregate_msg {
+    uint32_t timestamp;     /* ms, end of the window */
+    uint32_t window;        /* enum aggregate_window */
+    struct aggregate_stats channels[AGGREGATE_CHANNELS];
+};
+
+/*
+ * Derived data message - metrics computed from one sensor_data_msg, see
+ * derived_metrics.h
+ */
+struct derived_data_msg {
+    uint32_t timestamp;                 /* Of the source sample, ms */
+    uint32_t sea_level_pa;              /* Pressure reduced to sea level */
+    uint16_t sequence;                  /* Of the source sample */
+    int16_t dew_point_centi_c;          /* Celsius * 100 */
+    int16_t heat_index_centi_c;         /* Celsius * 100 */
+    uint16_t abs_humidity_centi_g_m3;   /* Water vapour, g/m³ * 100 */
+    uint16_t flags;                     /* DERIVED_FLAG_* bits, SENSOR_ID_* of the source */
+};
+
+#define DERIVED_FLAG_DEW_POINT_INVALID      BIT(0)
+#define DERIVED_FLAG_HEAT_INDEX_INVALID     BIT(1)
+#define DERIVED_FLAG_ABS_HUMIDITY_INVALID   BIT(2)
+#define DERIVED_FLAG_SEA_LEVEL_INVALID      BIT(3)
+
 /* Zbus channel declarations */
 ZBUS_CHAN_DECLARE(ws_trigger);
 ZBUS_CHAN_DECLARE(ws_sensor_data);
+ZBUS_CHAN_DECLARE(ws_sensor_batch);
+ZBUS_CHAN_DECLARE(ws_aggregate);
+ZBUS_CHAN_DECLARE(ws_derived);
 
 #endif /* WEATHER_STATION_MESSAGES_H */
\ No newline at end of file
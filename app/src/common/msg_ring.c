@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+#include "msg_ring.h"
+
+void msg_ring_clear(struct msg_ring *ring)
+{
+    ring->head = 0;
+    ring->count = 0;
+    ring->reserved = 0;
+}
+
+bool msg_ring_has_room(const struct msg_ring *ring)
+{
+    return ring->count + ring->reserved < ring->slots;
+}
+
+int msg_ring_reserve(struct msg_ring *ring)
+{
+    if (!msg_ring_has_room(ring)) {
+        return -ENOBUFS;
+    }
+
+    ring->reserved++;
+    return 0;
+}
+
+void msg_ring_release(struct msg_ring *ring)
+{
+    if (ring->reserved > 0) {
+        ring->reserved--;
+    }
+}
+
+int msg_ring_put(struct msg_ring *ring, uint32_t stamp, const void *msg, bool overwrite)
+{
+    int rc = 0;
+
+    if (ring->count == ring->slots) {
+        if (!overwrite) {
+            return -ENOBUFS;
+        }
+
+        // The oldest slot becomes the newest
+        ring->head = (ring->head + 1U) % ring->slots;
+        ring->count--;
+        rc = 1;
+    }
+
+    uint32_t slot = (ring->head + ring->count) % ring->slots;
+
+    memcpy(&ring->msgs[slot * ring->msg_size], msg, ring->msg_size);
+    ring->stamps[slot] = stamp;
+    ring->count++;
+    msg_ring_release(ring);
+
+    return rc;
+}
+
+int msg_ring_peek(const struct msg_ring *ring, uint32_t *stamp)
+{
+    if (ring->count == 0) {
+        return -ENODATA;
+    }
+
+    *stamp = ring->stamps[ring->head];
+    return 0;
+}
+
+int msg_ring_get(struct msg_ring *ring, void *msg)
+{
+    if (ring->count == 0) {
+        return -ENODATA;
+    }
+
+    memcpy(msg, &ring->msgs[ring->head * ring->msg_size], ring->msg_size);
+    ring->head = (ring->head + 1U) % ring->slots;
+    ring->count--;
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_MSG_RING_H
+#define WEATHER_STATION_MSG_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Bounded FIFO of fixed-size messages, the queue of one subscriber.
+ *
+ * Every message carries a stamp, so a consumer reading several rings can
+ * take their messages in the order they were put. Room can be reserved
+ * before a put: a publisher that got a reservation knows its message will
+ * be kept. A put without one takes any free slot, or with overwrite set
+ * replaces the oldest message of a full ring. Not thread safe, callers
+ * serialise access with their own lock.
+ */
+
+struct msg_ring {
+    uint8_t *msgs;          /* slots * msg_size bytes */
+    uint32_t *stamps;
+    size_t msg_size;
+    uint32_t slots;
+    uint32_t head;          /* Slot of the oldest message */
+    uint32_t count;         /* Messages queued */
+    uint32_t reserved;      /* Free slots promised to puts to come */
+};
+
+/* Initializer with static storage for n messages of type msg_type */
+#define MSG_RING_INIT(msg_type, n)                                                           \
+    {                                                                                        \
+        .msgs = (uint8_t[(n) * sizeof(msg_type)]){0},                                        \
+        .stamps = (uint32_t[(n)]){0},                                                        \
+        .msg_size = sizeof(msg_type),                                                        \
+        .slots = (n),                                                                        \
+    }
+
+/* Drop every queued message and reservation */
+void msg_ring_clear(struct msg_ring *ring);
+
+/* True if a slot is neither used nor reserved */
+bool msg_ring_has_room(const struct msg_ring *ring);
+
+/* Reserve a slot for a later put, returns 0 or -ENOBUFS */
+int msg_ring_reserve(struct msg_ring *ring);
+
+/* Give back a reservation that will not be used */
+void msg_ring_release(struct msg_ring *ring);
+
+/**
+ * @brief Queue a copy of msg_size bytes at msg
+ *
+ * Uses up a reservation if there is one.
+ *
+ * @return 0 if queued, 1 if queued in place of the oldest message, -ENOBUFS
+ *         if the ring is full and overwrite is not set
+ */
+int msg_ring_put(struct msg_ring *ring, uint32_t stamp, const void *msg, bool overwrite);
+
+/* Stamp of the oldest message, returns 0 or -ENODATA if the ring is empty */
+int msg_ring_peek(const struct msg_ring *ring, uint32_t *stamp);
+
+/* Take the oldest message into msg, returns 0 or -ENODATA if the ring is empty */
+int msg_ring_get(struct msg_ring *ring, void *msg);
+
+#endif /* WEATHER_STATION_MSG_RING_H */
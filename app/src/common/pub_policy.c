@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/zbus/zbus.h>
+#include <errno.h>
+#include "pub_policy.h"
+
+static K_MUTEX_DEFINE(pub_lock);
+static K_CONDVAR_DEFINE(pub_room);     /* Signalled when a subscriber takes a message */
+static uint32_t pub_stamp;             /* Order of the queued messages, under pub_lock */
+
+static const char *const pub_policy_names[] = {
+    [PUB_POLICY_BLOCK] = "block",
+    [PUB_POLICY_DROP_NEWEST] = "drop-newest",
+    [PUB_POLICY_DROP_OLDEST] = "drop-oldest",
+};
+
+const char *pub_policy_name(enum pub_policy policy)
+{
+    return (policy < ARRAY_SIZE(pub_policy_names)) ? pub_policy_names[policy] : "?";
+}
+
+static struct pub_channel *pub_policy_find(const struct zbus_channel *chan)
+{
+    for (size_t i = 0; i < pub_channel_count; i++) {
+        if (pub_channels[i].chan == chan) {
+            return &pub_channels[i];
+        }
+    }
+    return NULL;
+}
+
+/* Deepest enabled queue of a channel, called with pub_lock held */
+static uint32_t pub_policy_depth(const struct zbus_channel *chan)
+{
+    uint32_t depth = 0;
+
+    for (size_t i = 0; i < pub_queue_count; i++) {
+        const struct pub_queue *q = &pub_queues[i];
+
+        if (q->chan == chan && q->enabled) {
+            depth = MAX(depth, q->ring.count);
+        }
+    }
+    return depth;
+}
+
+static void pub_policy_update_depth(struct pub_channel *pc)
+{
+    pc->stats.depth = pub_policy_depth(pc->chan);
+    pc->stats.max_depth = MAX(pc->stats.max_depth, pc->stats.depth);
+}
+
+/* Reserve a slot in every enabled queue of a channel or in none, with pub_lock held */
+static bool pub_policy_reserve(const struct zbus_channel *chan)
+{
+    for (size_t i = 0; i < pub_queue_count; i++) {
+        const struct pub_queue *q = &pub_queues[i];
+
+        if (q->chan == chan && q->enabled && !msg_ring_has_room(&q->ring)) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < pub_queue_count; i++) {
+        struct pub_queue *q = &pub_queues[i];
+
+        if (q->chan == chan && q->enabled) {
+            (void)msg_ring_reserve(&q->ring);
+        }
+    }
+    return true;
+}
+
+static void pub_policy_release(const struct zbus_channel *chan)
+{
+    for (size_t i = 0; i < pub_queue_count; i++) {
+        struct pub_queue *q = &pub_queues[i];
+
+        if (q->chan == chan && q->enabled) {
+            msg_ring_release(&q->ring);
+        }
+    }
+}
+
+/*
+ * Runs in the publisher's thread with the channel held, so the message can
+ * be copied straight from it. Every enabled queue of the channel gets its
+ * copy, a subscriber is given once per message added to its queues.
+ */
+static void pub_policy_deliver(const struct zbus_channel *chan)
+{
+    struct pub_channel *pc = pub_policy_find(chan);
+    bool overwrite = (pc != NULL && pc->policy == PUB_POLICY_DROP_OLDEST);
+    const void *msg = zbus_chan_const_msg(chan);
+
+    k_mutex_lock(&pub_lock, K_FOREVER);
+
+    uint32_t stamp = pub_stamp++;
+
+    for (size_t i = 0; i < pub_queue_count; i++) {
+        struct pub_queue *q = &pub_queues[i];
+
+        if (q->chan != chan || !q->enabled) {
+            continue;
+        }
+
+        int rc = msg_ring_put(&q->ring, stamp, msg, overwrite);
+
+        if (rc == 0) {
+            k_sem_give(q->sub);
+        } else if (pc != NULL) {
+            // Replaced the oldest message, or found no room without a reservation
+            pc->stats.dropped++;
+        }
+    }
+
+    if (pc != NULL) {
+        pub_policy_update_depth(pc);
+    }
+    k_mutex_unlock(&pub_lock);
+}
+
+ZBUS_LISTENER_DEFINE(pub_policy_lis, pub_policy_deliver);
+
+static int pub_policy_send(const struct zbus_channel *chan, const void *msg, bool may_block)
+{
+    struct pub_channel *pc = pub_policy_find(chan);
+
+    if (pc == NULL) {
+        return zbus_chan_pub(chan, msg, K_NO_WAIT);
+    }
+
+    bool reserve = (pc->policy != PUB_POLICY_DROP_OLDEST);
+    k_timepoint_t end = sys_timepoint_calc((pc->policy == PUB_POLICY_BLOCK && may_block) ?
+                                           K_MSEC(pc->timeout_ms) : K_NO_WAIT);
+
+    k_mutex_lock(&pub_lock, K_FOREVER);
+    while (reserve && !pub_policy_reserve(chan)) {
+        if (pc->policy == PUB_POLICY_DROP_NEWEST) {
+            pc->stats.dropped++;
+            k_mutex_unlock(&pub_lock);
+            return -ENOBUFS;
+        }
+        if (k_condvar_wait(&pub_room, &pub_lock, sys_timepoint_timeout(end)) != 0) {
+            pc->stats.timeouts++;
+            pc->stats.dropped++;
+            k_mutex_unlock(&pub_lock);
+            return -EAGAIN;
+        }
+    }
+    k_mutex_unlock(&pub_lock);
+
+    int rc = zbus_chan_pub(chan, msg, sys_timepoint_timeout(end));
+
+    k_mutex_lock(&pub_lock, K_FOREVER);
+    if (rc == 0) {
+        pc->stats.published++;
+    } else {
+        // Only listeners observe the channel and they cannot fail, so no queue got it
+        if (reserve) {
+            pub_policy_release(chan);
+            k_condvar_broadcast(&pub_room);
+        }
+        pc->stats.dropped++;
+        if (rc == -EAGAIN || rc == -EBUSY) {
+            pc->stats.timeouts++;
+        }
+    }
+    k_mutex_unlock(&pub_lock);
+
+    return rc;
+}
+
+int pub_policy_publish(const struct zbus_channel *chan, const void *msg)
+{
+    return pub_policy_send(chan, msg, true);
+}
+
+int pub_policy_try_publish(const struct zbus_channel *chan, const void *msg)
+{
+    return pub_policy_send(chan, msg, false);
+}
+
+/* Queue of a subscriber with the oldest message, with pub_lock held */
+static struct pub_queue *pub_policy_oldest(const struct k_sem *sub)
+{
+    struct pub_queue *oldest = NULL;
+    uint32_t oldest_stamp = 0;
+
+    for (size_t i = 0; i < pub_queue_count; i++) {
+        struct pub_queue *q = &pub_queues[i];
+        uint32_t stamp;
+
+        if (q->sub != sub || !q->enabled || msg_ring_peek(&q->ring, &stamp) != 0) {
+            continue;
+        }
+
+        // Stamps wrap, compare their distance
+        if (oldest == NULL || (int32_t)(stamp - oldest_stamp) < 0) {
+            oldest = q;
+            oldest_stamp = stamp;
+        }
+    }
+    return oldest;
+}
+
+int pub_policy_wait(struct k_sem *sub, const struct zbus_channel **chan, void *msg,
+                    k_timeout_t timeout)
+{
+    k_timepoint_t end = sys_timepoint_calc(timeout);
+
+    while (k_sem_take(sub, sys_timepoint_timeout(end)) == 0) {
+        k_mutex_lock(&pub_lock, K_FOREVER);
+
+        struct pub_queue *q = pub_policy_oldest(sub);
+
+        if (q != NULL) {
+            (void)msg_ring_get(&q->ring, msg);
+            *chan = q->chan;
+
+            struct pub_channel *pc = pub_policy_find(q->chan);
+
+            if (pc != NULL) {
+                pc->stats.depth = pub_policy_depth(q->chan);
+            }
+            k_condvar_broadcast(&pub_room);
+        }
+        k_mutex_unlock(&pub_lock);
+
+        if (q != NULL) {
+            return 0;
+        }
+        // Given for a message emptied out since by a disable, wait for the next one
+    }
+
+    return -EAGAIN;
+}
+
+int pub_policy_set_enable(struct k_sem *sub, bool enabled)
+{
+    int rc = -EINVAL;
+
+    k_mutex_lock(&pub_lock, K_FOREVER);
+    for (size_t i = 0; i < pub_queue_count; i++) {
+        struct pub_queue *q = &pub_queues[i];
+
+        if (q->sub == sub) {
+            q->enabled = enabled;
+            msg_ring_clear(&q->ring);
+            rc = 0;
+        }
+    }
+    k_condvar_broadcast(&pub_room);
+    k_mutex_unlock(&pub_lock);
+
+    return rc;
+}
+
+int pub_policy_get(size_t index, struct pub_channel *out)
+{
+    if (index >= pub_channel_count) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&pub_lock, K_FOREVER);
+    *out = pub_channels[index];
+    k_mutex_unlock(&pub_lock);
+    return 0;
+}
+
+void pub_policy_reset(void)
+{
+    k_mutex_lock(&pub_lock, K_FOREVER);
+    for (size_t i = 0; i < pub_channel_count; i++) {
+        pub_channels[i].stats = (struct pub_policy_stats){
+            .depth = pub_policy_depth(pub_channels[i].chan),
+        };
+    }
+    k_mutex_unlock(&pub_lock);
+}
+
+/* Queues are sized from message types in channels.c, check them against the channels */
+static int pub_policy_init(void)
+{
+    int rc = 0;
+
+    for (size_t i = 0; i < pub_queue_count; i++) {
+        struct pub_queue *q = &pub_queues[i];
+
+        if (q->ring.msg_size != zbus_chan_msg_size(q->chan)) {
+            __ASSERT(false, "Queue %u does not fit the messages of its channel", (unsigned int)i);
+            q->enabled = false;
+            rc = -EINVAL;
+        }
+    }
+    return rc;
+}
+
+SYS_INIT(pub_policy_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
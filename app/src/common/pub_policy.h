@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_PUB_POLICY_H
+#define WEATHER_STATION_PUB_POLICY_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/zbus/zbus.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "msg_ring.h"
+
+/*
+ * Delivery and overload policy of the ws_* channels.
+ *
+ * Every subscriber of a channel gets a bounded queue of its own, a ring
+ * filled by pub_policy_lis in the publisher's thread. A subscriber is the
+ * semaphore its thread waits on in pub_policy_wait(), which hands out the
+ * oldest message of all its queues. When a queue is at its bound the
+ * channel policy decides what happens to a new message:
+ *
+ *   BLOCK        the publisher waits for room, up to the channel timeout
+ *   DROP_NEWEST  the new message is discarded and the publish fails
+ *   DROP_OLDEST  the new message replaces the oldest one of the full queue
+ *
+ * so an overloaded station sheds messages at known points instead of
+ * stalling its publishers. BLOCK and DROP_NEWEST reserve a slot in every
+ * queue of the channel before publishing, so a message that is published
+ * is queued everywhere. Policies, timeouts and bounds are set per channel
+ * in Kconfig, the wiring lives in channels.c.
+ */
+
+enum pub_policy {
+    PUB_POLICY_BLOCK,
+    PUB_POLICY_DROP_NEWEST,
+    PUB_POLICY_DROP_OLDEST,
+};
+
+struct pub_policy_stats {
+    uint32_t published;     /* Messages handed to the channel */
+    uint32_t timeouts;      /* Blocking publishes that gave up */
+    uint32_t dropped;       /* Failed publishes and messages replaced or refused by a queue */
+    uint32_t depth;         /* Deepest subscriber queue now */
+    uint32_t max_depth;     /* Deepest subscriber queue seen */
+};
+
+/* Overload settings and counters of one channel */
+struct pub_channel {
+    const struct zbus_channel *chan;
+    const char *name;
+    enum pub_policy policy;
+    uint32_t timeout_ms;
+    uint32_t depth;                 /* Bound of each subscriber queue */
+    struct pub_policy_stats stats;
+};
+
+/* Queue of one channel for one subscriber */
+struct pub_queue {
+    const struct zbus_channel *chan;
+    struct k_sem *sub;
+    struct msg_ring ring;
+    bool enabled;
+};
+
+/* A subscriber, given once for every message queued for it */
+#define PUB_SUBSCRIBER_DEFINE(name) K_SEM_DEFINE(name, 0, K_SEM_MAX_LIMIT)
+#define PUB_SUBSCRIBER_DECLARE(name) extern struct k_sem name
+
+/* Observer of every channel with subscriber queues */
+ZBUS_OBS_DECLARE(pub_policy_lis);
+
+/* Defined with the channels */
+extern struct pub_channel pub_channels[];
+extern const size_t pub_channel_count;
+extern struct pub_queue pub_queues[];
+extern const size_t pub_queue_count;
+
+/**
+ * @brief Publish on a ws_* channel under its overload policy
+ *
+ * @return 0 on success, -EAGAIN if a blocking publish timed out, -ENOBUFS
+ *         if the message was dropped, or the zbus_chan_pub() error
+ */
+int pub_policy_publish(const struct zbus_channel *chan, const void *msg);
+
+/*
+ * Same without ever waiting, for work items and other shared contexts: a
+ * blocking channel with a full queue times out at once with -EAGAIN.
+ */
+int pub_policy_try_publish(const struct zbus_channel *chan, const void *msg);
+
+/**
+ * @brief Take the oldest message queued for a subscriber
+ *
+ * @param sub Subscriber
+ * @param chan Set to the channel the message was published on
+ * @param msg Room for the largest message of the subscribed channels
+ * @param timeout How long to wait for a message
+ * @return 0 on success, -EAGAIN if no message arrived in time
+ */
+int pub_policy_wait(struct k_sem *sub, const struct zbus_channel **chan, void *msg,
+                    k_timeout_t timeout);
+
+/* Enable or disable a subscriber, its queues are emptied and get nothing while disabled */
+int pub_policy_set_enable(struct k_sem *sub, bool enabled);
+
+const char *pub_policy_name(enum pub_policy policy);
+
+/* Settings and counters of channel index, -EINVAL past the last one */
+int pub_policy_get(size_t index, struct pub_channel *out);
+
+void pub_policy_reset(void);
+
+#endif /* WEATHER_STATION_PUB_POLICY_H */
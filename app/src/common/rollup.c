@@ -0,0 +1,409 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+#include "rollup.h"
+
+static const char *const rollup_tier_names[ROLLUP_TIER_COUNT] = {
+    [ROLLUP_TIER_RAW] = "raw",
+    [ROLLUP_TIER_MINUTE] = "minute",
+    [ROLLUP_TIER_HOUR] = "hour",
+};
+
+static uint16_t rollup_pressure_off(int32_t pressure_pa)
+{
+    return (uint16_t)CLAMP(pressure_pa - (int32_t)SENSOR_PRESSURE_BASE_PA, 0,
+                           SAMPLE_HISTORY_PRESSURE_INVALID - 1);
+}
+
+static void rollup_make_record(struct rollup_record *rec, uint32_t start, uint32_t count,
+                               const struct stats_acc acc[STATS_CHANNEL_COUNT])
+{
+    const struct stats_acc *temp = &acc[STATS_TEMPERATURE];
+    const struct stats_acc *humidity = &acc[STATS_HUMIDITY];
+    const struct stats_acc *pressure = &acc[STATS_PRESSURE];
+
+    rec->start = start;
+    rec->count = count;
+
+    if (temp->count > 0) {
+        rec->temp_min = (int16_t)temp->min;
+        rec->temp_max = (int16_t)temp->max;
+        rec->temp_avg = (int16_t)stats_acc_mean(temp);
+    } else {
+        rec->temp_min = rec->temp_max = rec->temp_avg = SAMPLE_HISTORY_TEMP_INVALID;
+    }
+
+    if (humidity->count > 0) {
+        rec->humidity_min = (uint16_t)humidity->min;
+        rec->humidity_max = (uint16_t)humidity->max;
+        rec->humidity_avg = (uint16_t)stats_acc_mean(humidity);
+    } else {
+        rec->humidity_min = rec->humidity_max = rec->humidity_avg =
+            SAMPLE_HISTORY_HUMIDITY_INVALID;
+    }
+
+    if (pressure->count > 0) {
+        rec->pressure_min = rollup_pressure_off(pressure->min);
+        rec->pressure_max = rollup_pressure_off(pressure->max);
+        rec->pressure_avg = rollup_pressure_off(stats_acc_mean(pressure));
+    } else {
+        rec->pressure_min = rec->pressure_max = rec->pressure_avg =
+            SAMPLE_HISTORY_PRESSURE_INVALID;
+    }
+}
+
+static void rollup_ring_push(struct rollup_ring *ring, uint32_t start, uint32_t count,
+                             const struct stats_acc acc[STATS_CHANNEL_COUNT])
+{
+    rollup_make_record(&ring->records[ring->head % ring->size], start, count, acc);
+    ring->head++;
+}
+
+static uint32_t rollup_ring_count(const struct rollup_ring *ring)
+{
+    return MIN(ring->head, ring->size);
+}
+
+void rollup_init(struct rollup *r)
+{
+    memset(r, 0, sizeof(*r));
+    sample_history_init(&r->raw);
+
+    r->minutes.size = ROLLUP_MINUTES;
+    r->minutes.records = r->minute_records;
+    r->hours.size = ROLLUP_HOURS;
+    r->hours.records = r->hour_records;
+}
+
+void rollup_add(struct rollup *r, const struct sensor_data_msg *msg)
+{
+    int32_t values[STATS_CHANNEL_COUNT];
+    uint32_t valid = stats_sample_values(msg, values);
+    uint32_t minute = msg->timestamp - (msg->timestamp % ROLLUP_MINUTE_MS);
+    uint32_t hour = msg->timestamp - (msg->timestamp % ROLLUP_HOUR_MS);
+
+    sample_history_append(&r->raw, msg);
+
+    k_spinlock_key_t key = k_spin_lock(&r->lock);
+
+    // A sample in a new period closes the open one of each tier
+    if (r->minute_samples > 0 && minute != r->minute_start) {
+        rollup_ring_push(&r->minutes, r->minute_start, r->minute_samples, r->minute_acc);
+        memset(r->minute_acc, 0, sizeof(r->minute_acc));
+        r->minute_samples = 0;
+    }
+    if (r->hour_samples > 0 && hour != r->hour_start) {
+        rollup_ring_push(&r->hours, r->hour_start, r->hour_samples, r->hour_acc);
+        memset(r->hour_acc, 0, sizeof(r->hour_acc));
+        r->hour_samples = 0;
+    }
+
+    r->minute_start = minute;
+    r->hour_start = hour;
+    r->minute_samples++;
+    r->hour_samples++;
+
+    for (int ch = 0; ch < STATS_CHANNEL_COUNT; ch++) {
+        if (valid & BIT(ch)) {
+            stats_acc_add(&r->minute_acc[ch], values[ch]);
+            stats_acc_add(&r->hour_acc[ch], values[ch]);
+        }
+    }
+
+    k_spin_unlock(&r->lock, key);
+}
+
+uint32_t rollup_tier_period(enum rollup_tier tier)
+{
+    switch (tier) {
+    case ROLLUP_TIER_MINUTE:
+        return ROLLUP_MINUTE_MS;
+    case ROLLUP_TIER_HOUR:
+        return ROLLUP_HOUR_MS;
+    default:
+        return 0;
+    }
+}
+
+const char *rollup_tier_name(enum rollup_tier tier)
+{
+    return (tier < ROLLUP_TIER_COUNT) ? rollup_tier_names[tier] : "?";
+}
+
+static struct rollup_ring *rollup_ring(struct rollup *r, enum rollup_tier tier)
+{
+    return (tier == ROLLUP_TIER_MINUTE) ? &r->minutes : &r->hours;
+}
+
+bool rollup_tier_oldest(struct rollup *r, enum rollup_tier tier, uint32_t *start)
+{
+    if (tier == ROLLUP_TIER_RAW) {
+        return sample_history_oldest(&r->raw, start);
+    }
+
+    struct rollup_ring *ring = rollup_ring(r, tier);
+    k_spinlock_key_t key = k_spin_lock(&r->lock);
+    bool found = true;
+
+    if (ring->head > 0) {
+        *start = ring->records[(ring->head - rollup_ring_count(ring)) % ring->size].start;
+    } else if (r->minute_samples > 0) {
+        *start = (tier == ROLLUP_TIER_MINUTE) ? r->minute_start : r->hour_start;
+    } else {
+        found = false;
+    }
+
+    k_spin_unlock(&r->lock, key);
+    return found;
+}
+
+enum rollup_tier rollup_select_tier(struct rollup *r, uint32_t from_ms, uint32_t step_ms)
+{
+    uint32_t oldest;
+
+    for (int tier = ROLLUP_TIER_COUNT - 1; tier >= 0; tier--) {
+        if (rollup_tier_period(tier) <= step_ms &&
+            rollup_tier_oldest(r, tier, &oldest) && oldest <= from_ms) {
+            return tier;
+        }
+    }
+
+    for (int tier = 0; tier < ROLLUP_TIER_COUNT; tier++) {
+        if (rollup_tier_oldest(r, tier, &oldest) && oldest <= from_ms) {
+            return tier;
+        }
+    }
+
+    return ROLLUP_TIER_HOUR;
+}
+
+static uint32_t rollup_query_raw(struct rollup *r, uint32_t from_ms, uint32_t to_ms,
+                                 rollup_visit_t visit, void *user_data)
+{
+    struct sample_history_cursor cursor;
+    struct sample_history_entry entry;
+    uint32_t visited = 0;
+
+    sample_history_cursor_init(&r->raw, &cursor, UINT32_MAX);
+
+    while (sample_history_prev(&r->raw, &cursor, &entry) == 0 && entry.timestamp >= from_ms) {
+        if (entry.timestamp > to_ms) {
+            continue;
+        }
+
+        struct rollup_record rec = {
+            .start = entry.timestamp,
+            .count = 1,
+            .temp_min = entry.temperature_centi_c,
+            .temp_max = entry.temperature_centi_c,
+            .temp_avg = entry.temperature_centi_c,
+            .humidity_min = entry.humidity_deci_pct,
+            .humidity_max = entry.humidity_deci_pct,
+            .humidity_avg = entry.humidity_deci_pct,
+        };
+
+        rec.pressure_min = (entry.pressure_pa == 0) ? SAMPLE_HISTORY_PRESSURE_INVALID :
+                           rollup_pressure_off((int32_t)entry.pressure_pa);
+        rec.pressure_max = rec.pressure_avg = rec.pressure_min;
+
+        visited++;
+        if (!visit(ROLLUP_TIER_RAW, &rec, user_data)) {
+            break;
+        }
+    }
+
+    return visited;
+}
+
+uint32_t rollup_query(struct rollup *r, enum rollup_tier tier, uint32_t from_ms,
+                      uint32_t to_ms, rollup_visit_t visit, void *user_data)
+{
+    if (tier == ROLLUP_TIER_RAW) {
+        return rollup_query_raw(r, from_ms, to_ms, visit, user_data);
+    }
+
+    struct rollup_ring *ring = rollup_ring(r, tier);
+    uint32_t period = rollup_tier_period(tier);
+    struct rollup_record rec;
+    uint32_t visited = 0;
+    bool have_open = false;
+
+    k_spinlock_key_t key = k_spin_lock(&r->lock);
+    uint32_t index = ring->head;
+    uint32_t remaining = rollup_ring_count(ring);
+
+    // The open period is the newest record of the tier
+    if (tier == ROLLUP_TIER_MINUTE && r->minute_samples > 0) {
+        rollup_make_record(&rec, r->minute_start, r->minute_samples, r->minute_acc);
+        have_open = true;
+    } else if (tier == ROLLUP_TIER_HOUR && r->hour_samples > 0) {
+        rollup_make_record(&rec, r->hour_start, r->hour_samples, r->hour_acc);
+        have_open = true;
+    }
+    k_spin_unlock(&r->lock, key);
+
+    if (have_open && rec.start <= to_ms && rec.start + period > from_ms) {
+        visited++;
+        if (!visit(tier, &rec, user_data)) {
+            return visited;
+        }
+    }
+
+    while (remaining-- > 0) {
+        index--;
+
+        key = k_spin_lock(&r->lock);
+        // Stop if the record has been recycled since the walk started
+        if (ring->head - index > ring->size) {
+            k_spin_unlock(&r->lock, key);
+            break;
+        }
+        rec = ring->records[index % ring->size];
+        k_spin_unlock(&r->lock, key);
+
+        if (rec.start + period <= from_ms) {
+            break;
+        }
+        if (rec.start > to_ms) {
+            continue;
+        }
+
+        visited++;
+        if (!visit(tier, &rec, user_data)) {
+            break;
+        }
+    }
+
+    return visited;
+}
+
+/* min/avg/max of one channel */
+struct rollup_range {
+    int32_t min;
+    int32_t avg;
+    int32_t max;
+};
+
+/* Fold src into dst, averages weighted by the samples behind each */
+static void rollup_range_merge(struct rollup_range *dst, uint32_t *weight,
+                               const struct rollup_range *src, uint32_t count)
+{
+    if (*weight == 0) {
+        *dst = *src;
+    } else {
+        int64_t n = (int64_t)*weight + count;
+        int64_t sum = (int64_t)dst->avg * *weight + (int64_t)src->avg * count;
+
+        dst->min = MIN(dst->min, src->min);
+        dst->max = MAX(dst->max, src->max);
+        dst->avg = (int32_t)(((sum < 0) ? sum - n / 2 : sum + n / 2) / n);
+    }
+    *weight += count;
+}
+
+struct rollup_steps {
+    enum rollup_tier tier;
+    uint32_t step_ms;
+    uint32_t key;                           /* start / step_ms of the open step */
+    uint32_t weight[STATS_CHANNEL_COUNT];   /* Samples behind each channel, 0 if none */
+    struct rollup_record rec;
+    rollup_visit_t visit;
+    void *user_data;
+    uint32_t visited;
+    bool stopped;
+};
+
+static void rollup_steps_merge(struct rollup_steps *s, const struct rollup_record *rec)
+{
+    struct rollup_record *dst = &s->rec;
+    struct rollup_range a, b;
+
+    dst->start = MIN(dst->start, rec->start);
+    dst->count += rec->count;
+
+    if (rec->temp_avg != SAMPLE_HISTORY_TEMP_INVALID) {
+        a = (struct rollup_range){dst->temp_min, dst->temp_avg, dst->temp_max};
+        b = (struct rollup_range){rec->temp_min, rec->temp_avg, rec->temp_max};
+        rollup_range_merge(&a, &s->weight[STATS_TEMPERATURE], &b, rec->count);
+        dst->temp_min = (int16_t)a.min;
+        dst->temp_avg = (int16_t)a.avg;
+        dst->temp_max = (int16_t)a.max;
+    }
+
+    if (rec->humidity_avg != SAMPLE_HISTORY_HUMIDITY_INVALID) {
+        a = (struct rollup_range){dst->humidity_min, dst->humidity_avg, dst->humidity_max};
+        b = (struct rollup_range){rec->humidity_min, rec->humidity_avg, rec->humidity_max};
+        rollup_range_merge(&a, &s->weight[STATS_HUMIDITY], &b, rec->count);
+        dst->humidity_min = (uint16_t)a.min;
+        dst->humidity_avg = (uint16_t)a.avg;
+        dst->humidity_max = (uint16_t)a.max;
+    }
+
+    if (rec->pressure_avg != SAMPLE_HISTORY_PRESSURE_INVALID) {
+        a = (struct rollup_range){dst->pressure_min, dst->pressure_avg, dst->pressure_max};
+        b = (struct rollup_range){rec->pressure_min, rec->pressure_avg, rec->pressure_max};
+        rollup_range_merge(&a, &s->weight[STATS_PRESSURE], &b, rec->count);
+        dst->pressure_min = (uint16_t)a.min;
+        dst->pressure_avg = (uint16_t)a.avg;
+        dst->pressure_max = (uint16_t)a.max;
+    }
+}
+
+/* Hand the open step to the caller's visitor */
+static bool rollup_steps_emit(struct rollup_steps *s)
+{
+    s->visited++;
+    s->stopped = !s->visit(s->tier, &s->rec, s->user_data);
+    return !s->stopped;
+}
+
+static bool rollup_steps_visit(enum rollup_tier tier, const struct rollup_record *rec,
+                               void *user_data)
+{
+    struct rollup_steps *s = user_data;
+    uint32_t key = rec->start / s->step_ms;
+
+    if (s->rec.count > 0 && key == s->key) {
+        rollup_steps_merge(s, rec);
+        return true;
+    }
+
+    // Records come newest first, a new key closes the open step
+    if (s->rec.count > 0 && !rollup_steps_emit(s)) {
+        return false;
+    }
+
+    s->key = key;
+    s->rec = *rec;
+    s->weight[STATS_TEMPERATURE] = (rec->temp_avg != SAMPLE_HISTORY_TEMP_INVALID) ?
+                                   rec->count : 0;
+    s->weight[STATS_HUMIDITY] = (rec->humidity_avg != SAMPLE_HISTORY_HUMIDITY_INVALID) ?
+                                rec->count : 0;
+    s->weight[STATS_PRESSURE] = (rec->pressure_avg != SAMPLE_HISTORY_PRESSURE_INVALID) ?
+                                rec->count : 0;
+    return true;
+}
+
+uint32_t rollup_query_steps(struct rollup *r, enum rollup_tier tier, uint32_t from_ms,
+                            uint32_t to_ms, uint32_t step_ms, rollup_visit_t visit,
+                            void *user_data)
+{
+    struct rollup_steps s = {
+        .tier = tier,
+        .step_ms = MAX(step_ms, 1U),
+        .visit = visit,
+        .user_data = user_data,
+    };
+
+    rollup_query(r, tier, from_ms, to_ms, rollup_steps_visit, &s);
+    if (s.rec.count > 0 && !s.stopped) {
+        rollup_steps_emit(&s);
+    }
+
+    return s.visited;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_ROLLUP_H
+#define WEATHER_STATION_ROLLUP_H
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "messages.h"
+#include "sample_history.h"
+#include "stats_window.h"
+
+/*
+ * Multi-tier downsampling of the sample stream.
+ *
+ *   raw     the sample_history ring, CONFIG_WEATHER_STATION_HISTORY_SIZE samples
+ *   minute  min/max/avg/count per minute, CONFIG_WEATHER_STATION_ROLLUP_MINUTES
+ *   hour    min/max/avg/count per hour, CONFIG_WEATHER_STATION_ROLLUP_HOURS
+ *
+ * Samples are folded into the open minute and the open hour as they arrive,
+ * and a period's record is stored when the first sample of the next period
+ * comes in. Every tier is complete on its own and coarser tiers outlive the
+ * finer ones. All memory is static and sized by Kconfig.
+ *
+ * Records use the sample_history units and invalid markers.
+ */
+
+#define ROLLUP_MINUTE_MS   (60U * MSEC_PER_SEC)
+#define ROLLUP_HOUR_MS     (60U * ROLLUP_MINUTE_MS)
+#define ROLLUP_MINUTES     CONFIG_WEATHER_STATION_ROLLUP_MINUTES
+#define ROLLUP_HOURS       CONFIG_WEATHER_STATION_ROLLUP_HOURS
+
+enum rollup_tier {
+    ROLLUP_TIER_RAW,
+    ROLLUP_TIER_MINUTE,
+    ROLLUP_TIER_HOUR,
+    ROLLUP_TIER_COUNT
+};
+
+/* One period of one tier; a raw sample is a period of one */
+struct rollup_record {
+    uint32_t start;         /* ms, same time base as sensor_data_msg */
+    uint32_t count;         /* Samples folded in */
+    int16_t temp_min;
+    int16_t temp_max;
+    int16_t temp_avg;
+    uint16_t humidity_min;
+    uint16_t humidity_max;
+    uint16_t humidity_avg;
+    uint16_t pressure_min;  /* Pa, offset by SENSOR_PRESSURE_BASE_PA */
+    uint16_t pressure_max;
+    uint16_t pressure_avg;
+};
+
+struct rollup_ring {
+    uint32_t head;          /* Total number of records ever stored */
+    uint32_t size;
+    struct rollup_record *records;
+};
+
+struct rollup {
+    struct k_spinlock lock;
+    struct sample_history raw;
+    struct rollup_ring minutes;
+    struct rollup_ring hours;
+    uint32_t minute_start;
+    uint32_t hour_start;
+    struct stats_acc minute_acc[STATS_CHANNEL_COUNT];
+    struct stats_acc hour_acc[STATS_CHANNEL_COUNT];
+    uint32_t minute_samples;
+    uint32_t hour_samples;
+    struct rollup_record minute_records[ROLLUP_MINUTES];
+    struct rollup_record hour_records[ROLLUP_HOURS];
+};
+
+/* Called for each record, newest first; return false to stop */
+typedef bool (*rollup_visit_t)(enum rollup_tier tier, const struct rollup_record *rec,
+                               void *user_data);
+
+void rollup_init(struct rollup *r);
+
+/* Fold one sample into every tier */
+void rollup_add(struct rollup *r, const struct sensor_data_msg *msg);
+
+/* Period of a tier in ms, 0 for raw */
+uint32_t rollup_tier_period(enum rollup_tier tier);
+
+const char *rollup_tier_name(enum rollup_tier tier);
+
+/* Timestamp of the oldest data a tier still holds; false if it is empty */
+bool rollup_tier_oldest(struct rollup *r, enum rollup_tier tier, uint32_t *start);
+
+/**
+ * @brief Pick the tier to answer a query with
+ *
+ * Picks the coarsest tier whose period is at most step_ms and that still
+ * reaches back to from_ms. If none of those does, the finest tier that
+ * reaches back to from_ms is used, or the hour tier when nothing does.
+ */
+enum rollup_tier rollup_select_tier(struct rollup *r, uint32_t from_ms, uint32_t step_ms);
+
+/**
+ * @brief Visit the records of a tier that overlap [from_ms, to_ms]
+ *
+ * The open minute and hour are included as the newest record of their
+ * tier. The lock is only held while copying a single record.
+ *
+ * @return Number of records visited
+ */
+uint32_t rollup_query(struct rollup *r, enum rollup_tier tier, uint32_t from_ms,
+                      uint32_t to_ms, rollup_visit_t visit, void *user_data);
+
+/**
+ * @brief Visit the records of a tier that overlap [from_ms, to_ms], merged into steps
+ *
+ * Records whose start falls in the same step_ms-aligned step are merged
+ * into one: min and max over the step, averages weighted by sample count,
+ * start of the oldest record. A step is never finer than the records of
+ * the tier.
+ *
+ * @return Number of steps visited
+ */
+uint32_t rollup_query_steps(struct rollup *r, enum rollup_tier tier, uint32_t from_ms,
+                            uint32_t to_ms, uint32_t step_ms, rollup_visit_t visit,
+                            void *user_data);
+
+#endif /* WEATHER_STATION_ROLLUP_H */
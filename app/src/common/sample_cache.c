@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <string.h>
+#include "sample_cache.h"
+
+void sample_cache_init(struct sample_cache *cache)
+{
+    memset(cache->copies, 0, sizeof(cache->copies));
+    seqlock_init(&cache->lock);
+}
+
+static void sample_cache_update(struct sample_cache_copy *copy, uint8_t id,
+                                const struct sensor_data_msg *msg)
+{
+    copy->samples[id] = *msg;
+    copy->present |= BIT(id);
+    copy->newest = id;
+}
+
+void sample_cache_put(struct sample_cache *cache, const struct sensor_data_msg *msg)
+{
+    uint8_t id = sensor_data_id(msg);
+
+    seqlock_write_switch(&cache->lock);
+    sample_cache_update(&cache->copies[0], id, msg);
+    seqlock_write_switch(&cache->lock);
+    sample_cache_update(&cache->copies[1], id, msg);
+}
+
+/* Read sensor id, or the newest sample if id is negative */
+static int sample_cache_read(const struct sample_cache *cache, int id,
+                             struct sensor_data_msg *out)
+{
+    uint32_t present;
+    uint32_t seq;
+
+    do {
+        seq = seqlock_read_begin(&cache->lock);
+
+        const struct sample_cache_copy *copy = &cache->copies[seqlock_read_index(seq)];
+        uint8_t slot = (id < 0) ? copy->newest : (uint8_t)id;
+
+        present = copy->present & BIT(slot);
+        *out = copy->samples[slot];
+    } while (seqlock_read_retry(&cache->lock, seq));
+
+    return present ? 0 : -ENODATA;
+}
+
+int sample_cache_get(const struct sample_cache *cache, uint8_t id, struct sensor_data_msg *out)
+{
+    if (id >= SAMPLE_CACHE_SENSORS) {
+        return -EINVAL;
+    }
+
+    return sample_cache_read(cache, id, out);
+}
+
+int sample_cache_latest(const struct sample_cache *cache, struct sensor_data_msg *out)
+{
+    return sample_cache_read(cache, -1, out);
+}
+
+uint32_t sample_cache_sensors(const struct sample_cache *cache)
+{
+    uint32_t present;
+    uint32_t seq;
+
+    do {
+        seq = seqlock_read_begin(&cache->lock);
+        present = cache->copies[seqlock_read_index(seq)].present;
+    } while (seqlock_read_retry(&cache->lock, seq));
+
+    return present;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_SAMPLE_CACHE_H
+#define WEATHER_STATION_SAMPLE_CACHE_H
+
+#include <stdint.h>
+#include "messages.h"
+#include "seqlock.h"
+
+/*
+ * Newest sample of every sensor id, behind a seqlock.
+ *
+ * One writer puts samples as they are published; any thread reads them in
+ * O(1) without taking a lock or subscribing to a channel. A read never
+ * blocks and only repeats its 16 byte copy if a put ran at the same time.
+ */
+
+#define SAMPLE_CACHE_SENSORS (SENSOR_ID_MAX + 1)
+
+struct sample_cache_copy {
+    uint32_t present;       /* BIT(sensor id) of the ids with a sample */
+    uint8_t newest;         /* Sensor id of the last sample put */
+    struct sensor_data_msg samples[SAMPLE_CACHE_SENSORS];
+};
+
+struct sample_cache {
+    struct seqlock lock;
+    struct sample_cache_copy copies[2];
+};
+
+void sample_cache_init(struct sample_cache *cache);
+
+/* Store a sample under its sensor id; callers must not put concurrently */
+void sample_cache_put(struct sample_cache *cache, const struct sensor_data_msg *msg);
+
+/* Newest sample of one sensor, returns 0, -ENODATA or -EINVAL past SENSOR_ID_MAX */
+int sample_cache_get(const struct sample_cache *cache, uint8_t id, struct sensor_data_msg *out);
+
+/* Newest sample of any sensor, returns 0 or -ENODATA */
+int sample_cache_latest(const struct sample_cache *cache, struct sensor_data_msg *out);
+
+/* BIT(sensor id) of the sensors that have a sample */
+uint32_t sample_cache_sensors(const struct sample_cache *cache);
+
+#endif /* WEATHER_STATION_SAMPLE_CACHE_H */
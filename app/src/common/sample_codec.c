@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/toolchain.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/byteorder.h>
+#include <stdbool.h>
+#include <errno.h>
+#include "sample_codec.h"
+
+/* Header layout */
+#define HDR_MAGIC       0
+#define HDR_VERSION     1
+#define HDR_COUNT       2
+#define HDR_LENGTH      4
+#define HDR_TIME        6
+#define HDR_TEMP        14
+#define HDR_HUMIDITY    16
+#define HDR_PRESSURE    18
+#define HDR_FLAGS       20
+
+BUILD_ASSERT(HDR_FLAGS + 2 == SAMPLE_CODEC_HDR_SIZE);
+
+static inline uint32_t zigzag_encode(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t zigzag_decode(uint32_t value)
+{
+    return (int32_t)((value >> 1) ^ -(value & 1U));
+}
+
+/* Bits taken by a zigzag coded delta, prefix included */
+static uint32_t codec_field_bits(uint32_t z)
+{
+    if (z == 0) {
+        return 1;
+    }
+    if (z < BIT(4)) {
+        return 2 + 4;
+    }
+    if (z < BIT(8)) {
+        return 3 + 8;
+    }
+    if (z < BIT(16)) {
+        return 4 + 16;
+    }
+    return 4 + 32;
+}
+
+/* Append the low bits of value, most significant first */
+static void codec_put_bits(struct sample_codec_encoder *enc, uint32_t value, uint32_t bits)
+{
+    while (bits > 0) {
+        uint32_t used = enc->bit_pos & 7U;
+        uint32_t n = MIN(8U - used, bits);
+        uint8_t chunk = (uint8_t)((value >> (bits - n)) & (BIT(n) - 1U));
+        uint8_t *byte = &enc->buf[enc->bit_pos >> 3];
+
+        // Bytes are not cleared up front, the first write to one sets it
+        *byte = (used == 0) ? 0 : *byte;
+        *byte |= (uint8_t)(chunk << (8U - used - n));
+
+        enc->bit_pos += n;
+        bits -= n;
+    }
+}
+
+static void codec_put_field(struct sample_codec_encoder *enc, uint32_t z)
+{
+    if (z == 0) {
+        codec_put_bits(enc, 0x0, 1);
+    } else if (z < BIT(4)) {
+        codec_put_bits(enc, 0x2, 2);
+        codec_put_bits(enc, z, 4);
+    } else if (z < BIT(8)) {
+        codec_put_bits(enc, 0x6, 3);
+        codec_put_bits(enc, z, 8);
+    } else if (z < BIT(16)) {
+        codec_put_bits(enc, 0xE, 4);
+        codec_put_bits(enc, z, 16);
+    } else {
+        codec_put_bits(enc, 0xF, 4);
+        codec_put_bits(enc, z, 32);
+    }
+}
+
+void sample_codec_encoder_init(struct sample_codec_encoder *enc, uint8_t *buf, uint32_t size)
+{
+    *enc = (struct sample_codec_encoder){
+        .buf = buf,
+        .size = MIN(size, UINT16_MAX),
+    };
+}
+
+int sample_codec_encode(struct sample_codec_encoder *enc, const struct sample_record *rec)
+{
+    if (enc->count == UINT16_MAX) {
+        return -ENOSPC;
+    }
+
+    if (enc->count == 0) {
+        if (enc->size < SAMPLE_CODEC_HDR_SIZE) {
+            return -ENOSPC;
+        }
+
+        enc->buf[HDR_MAGIC] = SAMPLE_CODEC_MAGIC;
+        enc->buf[HDR_VERSION] = SAMPLE_CODEC_VERSION;
+        sys_put_le64(rec->time, &enc->buf[HDR_TIME]);
+        sys_put_le16((uint16_t)rec->temperature_centi_c, &enc->buf[HDR_TEMP]);
+        sys_put_le16(rec->humidity_deci_pct, &enc->buf[HDR_HUMIDITY]);
+        sys_put_le16(rec->pressure_pa_off, &enc->buf[HDR_PRESSURE]);
+        sys_put_le16(rec->flags, &enc->buf[HDR_FLAGS]);
+
+        enc->bit_pos = SAMPLE_CODEC_HDR_SIZE * 8U;
+        enc->prev = *rec;
+        enc->prev_delta = 0;
+        enc->count = 1;
+        return 0;
+    }
+
+    int64_t gap = (int64_t)(rec->time - enc->prev.time);
+
+    // Deltas are coded in 32 bits, a longer gap starts a new block
+    if (gap < INT32_MIN || gap > INT32_MAX) {
+        return -ENOSPC;
+    }
+
+    int32_t delta = (int32_t)gap;
+    uint32_t z_time = zigzag_encode((int32_t)((uint32_t)delta - (uint32_t)enc->prev_delta));
+    uint32_t z_temp = zigzag_encode((int32_t)rec->temperature_centi_c -
+                                    enc->prev.temperature_centi_c);
+    uint32_t z_humidity = zigzag_encode((int32_t)rec->humidity_deci_pct -
+                                        enc->prev.humidity_deci_pct);
+    uint32_t z_pressure = zigzag_encode((int32_t)rec->pressure_pa_off -
+                                        enc->prev.pressure_pa_off);
+    bool flags_changed = (rec->flags != enc->prev.flags);
+    uint32_t bits = codec_field_bits(z_time) + codec_field_bits(z_temp) +
+                    codec_field_bits(z_humidity) + codec_field_bits(z_pressure) +
+                    (flags_changed ? 17U : 1U);
+
+    // Check the whole sample fits before writing any of it
+    if (enc->bit_pos + bits > enc->size * 8U) {
+        return -ENOSPC;
+    }
+
+    codec_put_field(enc, z_time);
+    codec_put_field(enc, z_temp);
+    codec_put_field(enc, z_humidity);
+    codec_put_field(enc, z_pressure);
+    if (flags_changed) {
+        codec_put_bits(enc, 1, 1);
+        codec_put_bits(enc, rec->flags, 16);
+    } else {
+        codec_put_bits(enc, 0, 1);
+    }
+
+    enc->prev = *rec;
+    enc->prev_delta = delta;
+    enc->count++;
+    return 0;
+}
+
+uint32_t sample_codec_finish(struct sample_codec_encoder *enc)
+{
+    if (enc->count == 0) {
+        return 0;
+    }
+
+    uint32_t len = DIV_ROUND_UP(enc->bit_pos, 8U);
+
+    sys_put_le16(enc->count, &enc->buf[HDR_COUNT]);
+    sys_put_le16((uint16_t)len, &enc->buf[HDR_LENGTH]);
+    return len;
+}
+
+int sample_codec_decoder_init(struct sample_codec_decoder *dec, const uint8_t *buf,
+                              uint32_t len)
+{
+    if (len < SAMPLE_CODEC_HDR_SIZE || buf[HDR_MAGIC] != SAMPLE_CODEC_MAGIC ||
+        buf[HDR_VERSION] != SAMPLE_CODEC_VERSION) {
+        return -EBADMSG;
+    }
+
+    uint16_t count = sys_get_le16(&buf[HDR_COUNT]);
+    uint16_t length = sys_get_le16(&buf[HDR_LENGTH]);
+
+    if (count == 0 || length < SAMPLE_CODEC_HDR_SIZE || length > len) {
+        return -EBADMSG;
+    }
+
+    *dec = (struct sample_codec_decoder){
+        .buf = buf,
+        .len_bits = length * 8U,
+        .bit_pos = SAMPLE_CODEC_HDR_SIZE * 8U,
+        .count = count,
+        .prev = {
+            .time = sys_get_le64(&buf[HDR_TIME]),
+            .temperature_centi_c = (int16_t)sys_get_le16(&buf[HDR_TEMP]),
+            .humidity_deci_pct = sys_get_le16(&buf[HDR_HUMIDITY]),
+            .pressure_pa_off = sys_get_le16(&buf[HDR_PRESSURE]),
+            .flags = sys_get_le16(&buf[HDR_FLAGS]),
+        },
+    };
+
+    return 0;
+}
+
+static int codec_get_bits(struct sample_codec_decoder *dec, uint32_t bits, uint32_t *value)
+{
+    uint32_t out = 0;
+
+    if (dec->bit_pos + bits > dec->len_bits) {
+        return -EBADMSG;
+    }
+
+    while (bits > 0) {
+        uint32_t used = dec->bit_pos & 7U;
+        uint32_t n = MIN(8U - used, bits);
+        uint8_t byte = dec->buf[dec->bit_pos >> 3];
+
+        out = (out << n) | ((byte >> (8U - used - n)) & (BIT(n) - 1U));
+        dec->bit_pos += n;
+        bits -= n;
+    }
+
+    *value = out;
+    return 0;
+}
+
+static int codec_get_field(struct sample_codec_decoder *dec, int32_t *delta)
+{
+    static const uint8_t widths[] = {4, 8, 16, 32};
+    uint32_t prefix = 0;
+    uint32_t bit;
+    uint32_t z = 0;
+    int rc;
+
+    // Count the ones of the prefix, at most four
+    while (prefix < ARRAY_SIZE(widths)) {
+        rc = codec_get_bits(dec, 1, &bit);
+        if (rc != 0) {
+            return rc;
+        }
+        if (bit == 0) {
+            break;
+        }
+        prefix++;
+    }
+
+    if (prefix > 0) {
+        rc = codec_get_bits(dec, widths[prefix - 1], &z);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    *delta = zigzag_decode(z);
+    return 0;
+}
+
+int sample_codec_decode(struct sample_codec_decoder *dec, struct sample_record *rec)
+{
+    int32_t dod, d_temp, d_humidity, d_pressure;
+    uint32_t flags_changed;
+    uint32_t flags;
+
+    if (dec->index == dec->count) {
+        return -ENOENT;
+    }
+
+    if (dec->index > 0) {
+        if (codec_get_field(dec, &dod) != 0 ||
+            codec_get_field(dec, &d_temp) != 0 ||
+            codec_get_field(dec, &d_humidity) != 0 ||
+            codec_get_field(dec, &d_pressure) != 0 ||
+            codec_get_bits(dec, 1, &flags_changed) != 0) {
+            return -EBADMSG;
+        }
+
+        if (flags_changed) {
+            if (codec_get_bits(dec, 16, &flags) != 0) {
+                return -EBADMSG;
+            }
+            dec->prev.flags = (uint16_t)flags;
+        }
+
+        dec->prev_delta = (int32_t)((uint32_t)dec->prev_delta + (uint32_t)dod);
+        dec->prev.time += (uint64_t)(int64_t)dec->prev_delta;
+        dec->prev.temperature_centi_c = (int16_t)(dec->prev.temperature_centi_c + d_temp);
+        dec->prev.humidity_deci_pct = (uint16_t)(dec->prev.humidity_deci_pct + d_humidity);
+        dec->prev.pressure_pa_off = (uint16_t)(dec->prev.pressure_pa_off + d_pressure);
+    }
+
+    *rec = dec->prev;
+    dec->index++;
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_SAMPLE_CODEC_H
+#define WEATHER_STATION_SAMPLE_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Compressed blocks of samples in the sensor_data_msg fixed-point units.
+ *
+ * A block starts with a header holding the sample count, the block length
+ * and the first sample in full. Every further sample is coded against the
+ * previous one as a bit stream:
+ *   - timestamp: delta of the delta, so a steady sampling rate costs 1 bit;
+ *     samples of a block are less than 2^31 ms apart
+ *   - temperature, humidity, pressure: delta
+ *   - flags: 1 bit when unchanged, else the new value
+ *
+ * Deltas are zigzag coded and written with a length prefix:
+ *   0              zero
+ *   10   + 4 bits  < 16
+ *   110  + 8 bits  < 256
+ *   1110 + 16 bits < 65536
+ *   1111 + 32 bits anything else
+ * A slowly changing sample at a fixed rate takes 2 to 4 bytes, against 16
+ * for a sensor_data_msg. Multi-byte header fields are little-endian.
+ *
+ * Encoding and decoding stream one sample at a time; neither allocates.
+ */
+
+#define SAMPLE_CODEC_MAGIC      0x5A
+#define SAMPLE_CODEC_VERSION    2
+#define SAMPLE_CODEC_HDR_SIZE   22
+
+/* Upper bound of the encoded size of one sample after the first, in bytes */
+#define SAMPLE_CODEC_MAX_SAMPLE_SIZE 21
+
+/* One sample, sensor_data_msg units */
+struct sample_record {
+    uint64_t time;          /* ms */
+    int16_t temperature_centi_c;
+    uint16_t humidity_deci_pct;
+    uint16_t pressure_pa_off;
+    uint16_t flags;
+};
+
+struct sample_codec_encoder {
+    uint8_t *buf;
+    uint32_t size;          /* Capacity of buf, bytes */
+    uint32_t bit_pos;       /* Bits written, header included */
+    uint16_t count;
+    struct sample_record prev;
+    int32_t prev_delta;     /* Previous timestamp delta */
+};
+
+struct sample_codec_decoder {
+    const uint8_t *buf;
+    uint32_t len_bits;
+    uint32_t bit_pos;
+    uint16_t count;
+    uint16_t index;         /* Samples decoded so far */
+    struct sample_record prev;
+    int32_t prev_delta;
+};
+
+/* Start an empty block in buf */
+void sample_codec_encoder_init(struct sample_codec_encoder *enc, uint8_t *buf, uint32_t size);
+
+/**
+ * @brief Append a sample to the block
+ *
+ * @return 0 on success, -ENOSPC if it does not fit or is too far in time
+ *         from the previous sample; the block is left as it was and can
+ *         still be finished
+ */
+int sample_codec_encode(struct sample_codec_encoder *enc, const struct sample_record *rec);
+
+/* Complete the header, returns the block length in bytes (0 if empty) */
+uint32_t sample_codec_finish(struct sample_codec_encoder *enc);
+
+/**
+ * @brief Open a block for decoding
+ *
+ * @return 0 on success, -EBADMSG if buf does not hold a valid block header
+ */
+int sample_codec_decoder_init(struct sample_codec_decoder *dec, const uint8_t *buf,
+                              uint32_t len);
+
+/**
+ * @brief Decode the next sample, oldest first
+ *
+ * @return 0 on success, -ENOENT after the last sample, -EBADMSG if the
+ *         block is truncated
+ */
+int sample_codec_decode(struct sample_codec_decoder *dec, struct sample_record *rec);
+
+#endif /* WEATHER_STATION_SAMPLE_CODEC_H */
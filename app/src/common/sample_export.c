@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include "messages.h"
+#include "sample_export.h"
+#include "value_fmt.h"
+
+#define CSV_HEADER "time_ms,temperature_c,humidity_pct,pressure_pa,flags\n"
+
+/* Longest CSV line: "18446744073709551615,-327.68,6553.5,115535,0xffff\n" */
+#define CSV_LINE_MAX 56
+
+#define START_PAYLOAD_SIZE 20
+#define END_PAYLOAD_SIZE 4
+#define CRC_SIZE 4
+
+int sample_export_format_by_name(const char *name)
+{
+    if (strcmp(name, "csv") == 0) {
+        return SAMPLE_EXPORT_CSV;
+    }
+    if (strcmp(name, "bin") == 0) {
+        return SAMPLE_EXPORT_BIN;
+    }
+
+    return -ENOENT;
+}
+
+static int sample_export_write(struct sample_export *exp, size_t len)
+{
+    if (exp->err == 0 && len > 0) {
+        exp->err = exp->write(exp->buf, len, exp->user_data);
+        exp->chunks++;
+    }
+
+    return exp->err;
+}
+
+/* Close the frame being built in buf and write it out */
+static int sample_export_frame(struct sample_export *exp, enum sample_export_frame type)
+{
+    size_t payload = exp->len - SAMPLE_EXPORT_FRAME_HDR_SIZE;
+
+    exp->buf[0] = SAMPLE_EXPORT_SYNC;
+    exp->buf[1] = (uint8_t)type;
+    sys_put_le16((uint16_t)payload, &exp->buf[2]);
+    sys_put_le32(crc32_ieee(&exp->buf[1], exp->len - 1), &exp->buf[exp->len]);
+
+    int rc = sample_export_write(exp, exp->len + CRC_SIZE);
+
+    exp->len = SAMPLE_EXPORT_FRAME_HDR_SIZE;
+    return rc;
+}
+
+int sample_export_init(struct sample_export *exp, enum sample_export_format format,
+                       uint8_t *buf, size_t size, uint64_t from, uint64_t to,
+                       sample_export_write_cb write, void *user_data)
+{
+    memset(exp, 0, sizeof(*exp));
+
+    if (size < SAMPLE_EXPORT_MIN_CHUNK || size > UINT16_MAX) {
+        return -EINVAL;
+    }
+
+    exp->format = format;
+    exp->buf = buf;
+    exp->size = size;
+    exp->write = write;
+    exp->user_data = user_data;
+
+    if (format == SAMPLE_EXPORT_CSV) {
+        exp->len = strlen(CSV_HEADER);
+        memcpy(buf, CSV_HEADER, exp->len);
+        return 0;
+    }
+
+    uint8_t *payload = &buf[SAMPLE_EXPORT_FRAME_HDR_SIZE];
+
+    payload[0] = SAMPLE_EXPORT_VERSION;
+    payload[1] = SAMPLE_EXPORT_RECORD_SIZE;
+    sys_put_le16(0, &payload[2]);
+    sys_put_le64(from, &payload[4]);
+    sys_put_le64(to, &payload[12]);
+    exp->len = SAMPLE_EXPORT_FRAME_HDR_SIZE + START_PAYLOAD_SIZE;
+
+    return sample_export_frame(exp, SAMPLE_EXPORT_FRAME_START);
+}
+
+static size_t sample_export_csv_line(char *line, const struct sample_record *rec)
+{
+    char temp[VALUE_FMT_LEN] = "";
+    char humidity[VALUE_FMT_LEN] = "";
+    char pressure[VALUE_FMT_LEN] = "";
+
+    if (!(rec->flags & SENSOR_FLAG_TEMP_INVALID)) {
+        value_fmt_fixed(temp, sizeof(temp), rec->temperature_centi_c, 2);
+    }
+    if (!(rec->flags & SENSOR_FLAG_HUMIDITY_INVALID)) {
+        value_fmt_fixed(humidity, sizeof(humidity), rec->humidity_deci_pct, 1);
+    }
+    if (!(rec->flags & SENSOR_FLAG_PRESSURE_INVALID)) {
+        value_fmt_fixed(pressure, sizeof(pressure),
+                        (int32_t)rec->pressure_pa_off + SENSOR_PRESSURE_BASE_PA, 0);
+    }
+
+    return (size_t)snprintf(line, CSV_LINE_MAX, "%llu,%s,%s,%s,0x%04x\n",
+                            (unsigned long long)rec->time, temp, humidity, pressure,
+                            rec->flags);
+}
+
+int sample_export_add(struct sample_export *exp, const struct sample_record *rec)
+{
+    if (exp->err != 0) {
+        return exp->err;
+    }
+
+    if (exp->format == SAMPLE_EXPORT_CSV) {
+        char line[CSV_LINE_MAX];
+        size_t n = sample_export_csv_line(line, rec);
+
+        if (exp->len + n > exp->size) {
+            sample_export_write(exp, exp->len);
+            exp->len = 0;
+        }
+        memcpy(&exp->buf[exp->len], line, n);
+        exp->len += n;
+    } else {
+        if (exp->len + SAMPLE_EXPORT_RECORD_SIZE + CRC_SIZE > exp->size) {
+            sample_export_frame(exp, SAMPLE_EXPORT_FRAME_DATA);
+        }
+
+        uint8_t *out = &exp->buf[exp->len];
+
+        sys_put_le64(rec->time, &out[0]);
+        sys_put_le16((uint16_t)rec->temperature_centi_c, &out[8]);
+        sys_put_le16(rec->humidity_deci_pct, &out[10]);
+        sys_put_le16(rec->pressure_pa_off, &out[12]);
+        sys_put_le16(rec->flags, &out[14]);
+        exp->len += SAMPLE_EXPORT_RECORD_SIZE;
+    }
+
+    exp->records++;
+    return exp->err;
+}
+
+int sample_export_finish(struct sample_export *exp)
+{
+    if (exp->format == SAMPLE_EXPORT_CSV) {
+        return sample_export_write(exp, exp->len);
+    }
+
+    if (exp->len > SAMPLE_EXPORT_FRAME_HDR_SIZE) {
+        sample_export_frame(exp, SAMPLE_EXPORT_FRAME_DATA);
+    }
+
+    sys_put_le32(exp->records, &exp->buf[SAMPLE_EXPORT_FRAME_HDR_SIZE]);
+    exp->len = SAMPLE_EXPORT_FRAME_HDR_SIZE + END_PAYLOAD_SIZE;
+
+    return sample_export_frame(exp, SAMPLE_EXPORT_FRAME_END);
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_SAMPLE_EXPORT_H
+#define WEATHER_STATION_SAMPLE_EXPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sample_codec.h"
+
+/*
+ * Chunked export of logged samples.
+ *
+ * Samples are packed into a caller-supplied chunk buffer, which is handed
+ * to the write callback whenever the next sample would not fit, so memory
+ * use does not depend on the number of samples exported.
+ *
+ * CSV chunks hold whole lines of integer text, no floats:
+ *
+ *   time_ms,temperature_c,humidity_pct,pressure_pa,flags
+ *   123000,21.50,45.3,101325,0x0001
+ *
+ * Empty fields are values the sensor flagged invalid.
+ *
+ * Binary chunks are frames, all fields little endian:
+ *
+ *   sync    u8   SAMPLE_EXPORT_SYNC
+ *   type    u8   enum sample_export_frame
+ *   length  u16  payload bytes
+ *   payload
+ *   crc     u32  CRC-32 (IEEE) of type, length and payload
+ *
+ * The stream is one START frame (version, record size, from, to), DATA
+ * frames with whole records and one END frame with the record count. A
+ * record is the sample_record fields in order, SAMPLE_EXPORT_RECORD_SIZE
+ * bytes. Times, from and to are u64 ms of log time.
+ */
+
+#define SAMPLE_EXPORT_SYNC 0xA5
+#define SAMPLE_EXPORT_VERSION 2
+#define SAMPLE_EXPORT_RECORD_SIZE 16
+
+/* Sync, type and length before the payload, CRC after it */
+#define SAMPLE_EXPORT_FRAME_HDR_SIZE 4
+#define SAMPLE_EXPORT_FRAME_OVERHEAD (SAMPLE_EXPORT_FRAME_HDR_SIZE + 4)
+
+/* Smallest chunk that holds one record in either format */
+#define SAMPLE_EXPORT_MIN_CHUNK 64
+
+enum sample_export_format {
+    SAMPLE_EXPORT_CSV,
+    SAMPLE_EXPORT_BIN
+};
+
+enum sample_export_frame {
+    SAMPLE_EXPORT_FRAME_START = 1,
+    SAMPLE_EXPORT_FRAME_DATA = 2,
+    SAMPLE_EXPORT_FRAME_END = 3
+};
+
+/* Called with each complete chunk; a negative return aborts the export */
+typedef int (*sample_export_write_cb)(const uint8_t *data, size_t len, void *user_data);
+
+struct sample_export {
+    enum sample_export_format format;
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    sample_export_write_cb write;
+    void *user_data;
+    uint32_t records;
+    uint32_t chunks;
+    int err;                /* First write error, sticky */
+};
+
+/* Look up a format by name ("csv", "bin"), returns the format or -ENOENT */
+int sample_export_format_by_name(const char *name);
+
+/**
+ * @brief Start an export of the samples of [from, to]
+ *
+ * Writes the CSV header line or the START frame.
+ *
+ * @return 0 on success, -EINVAL if size is below SAMPLE_EXPORT_MIN_CHUNK,
+ *         or the write callback error
+ */
+int sample_export_init(struct sample_export *exp, enum sample_export_format format,
+                       uint8_t *buf, size_t size, uint64_t from, uint64_t to,
+                       sample_export_write_cb write, void *user_data);
+
+/* Add a sample, writing out the chunk first if it is full */
+int sample_export_add(struct sample_export *exp, const struct sample_record *rec);
+
+/* Write out the last chunk and, for binary, the END frame */
+int sample_export_finish(struct sample_export *exp);
+
+#endif /* WEATHER_STATION_SAMPLE_EXPORT_H */
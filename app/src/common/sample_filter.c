@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+#include <string.h>
+#include "sample_filter.h"
+
+static const uint16_t sample_filter_invalid[AGGREGATE_CHANNELS] = {
+    SENSOR_FLAG_TEMP_INVALID,
+    SENSOR_FLAG_HUMIDITY_INVALID,
+    SENSOR_FLAG_PRESSURE_INVALID,
+};
+
+void sample_filter_init(struct sample_filter *filter, const struct sample_filter_config *config)
+{
+    memset(filter, 0, sizeof(*filter));
+    filter->config = *config;
+    filter->config.median_size = CLAMP(config->median_size, 1, SAMPLE_FILTER_MEDIAN_MAX);
+    filter->config.ema_alpha_pct = CLAMP(config->ema_alpha_pct, 1, 100);
+}
+
+static int32_t sample_filter_round_q8(int64_t value)
+{
+    return (int32_t)((value >= 0) ? (value + 128) / 256 : (value - 128) / 256);
+}
+
+static int32_t sample_filter_median(const struct sample_filter_config *config,
+                                    struct sample_filter_channel *ch, int32_t value)
+{
+    int32_t sorted[SAMPLE_FILTER_MEDIAN_MAX];
+
+    ch->window[ch->next] = value;
+    ch->next = (ch->next + 1) % config->median_size;
+    ch->count = MIN(ch->count + 1, config->median_size);
+
+    // Insertion sort, the window holds a handful of values
+    for (uint8_t i = 0; i < ch->count; i++) {
+        int32_t v = ch->window[i];
+        uint8_t j = i;
+
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+
+    return sorted[ch->count / 2];
+}
+
+static int32_t sample_filter_channel_step(const struct sample_filter_config *config, int channel,
+                                          struct sample_filter_channel *ch, int32_t value)
+{
+    if (config->median_size > 1) {
+        value = sample_filter_median(config, ch, value);
+    }
+
+    int64_t r = config->kalman_r[channel];
+    int64_t measurement_q8 = (int64_t)value * 256;
+
+    if (!ch->primed) {
+        ch->primed = true;
+        ch->ema_q8 = value * 256;
+        ch->estimate_q8 = measurement_q8;
+        ch->variance_q8 = r * r * 256;
+        return value;
+    }
+
+    if (config->ema_alpha_pct < 100) {
+        ch->ema_q8 += (int32_t)(((int64_t)value * 256 - ch->ema_q8) * config->ema_alpha_pct / 100);
+        value = sample_filter_round_q8(ch->ema_q8);
+        measurement_q8 = ch->ema_q8;
+    }
+
+    if (r > 0) {
+        int64_t q = config->kalman_q[channel];
+
+        // Predict, then weigh the measurement by the gain, Q16
+        ch->variance_q8 += q * q * 256;
+
+        int64_t gain = (ch->variance_q8 << 16) / (ch->variance_q8 + r * r * 256);
+
+        ch->estimate_q8 += (measurement_q8 - ch->estimate_q8) * gain / 65536;
+        ch->variance_q8 = ch->variance_q8 * (65536 - gain) / 65536;
+        value = sample_filter_round_q8(ch->estimate_q8);
+    }
+
+    return value;
+}
+
+void sample_filter_apply(struct sample_filter *filter, struct sensor_data_msg *msg)
+{
+    struct sample_filter_channel *ch = filter->channels;
+    const struct sample_filter_config *config = &filter->config;
+    int32_t value;
+
+    // CLAMP evaluates its argument more than once, so each step gets its own statement
+    if (!(msg->flags & sample_filter_invalid[0])) {
+        value = sample_filter_channel_step(config, 0, &ch[0], msg->temperature_centi_c);
+        msg->temperature_centi_c = (int16_t)CLAMP(value, INT16_MIN, INT16_MAX);
+    }
+    if (!(msg->flags & sample_filter_invalid[1])) {
+        value = sample_filter_channel_step(config, 1, &ch[1], msg->humidity_deci_pct);
+        msg->humidity_deci_pct = (uint16_t)CLAMP(value, 0, 1000);
+    }
+    if (!(msg->flags & sample_filter_invalid[2])) {
+        value = sample_filter_channel_step(config, 2, &ch[2], msg->pressure_pa_off);
+        msg->pressure_pa_off = (uint16_t)CLAMP(value, 0, UINT16_MAX);
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_SAMPLE_FILTER_H
+#define WEATHER_STATION_SAMPLE_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "messages.h"
+
+/*
+ * Smoothing of the measurement channels of one sensor, run once per sample
+ * before it is published.
+ *
+ * The stages run in a fixed order, each enabled by the config:
+ *
+ *   median  median of the last median_size values, removes single spikes
+ *   EMA     y += alpha * (x - y), smooths what the median lets through
+ *   Kalman  scalar filter for a random walk, process noise q and
+ *           measurement noise r given as standard deviations in channel
+ *           units; follows real changes faster than an EMA of equal
+ *           smoothing once its gain has settled
+ *
+ * State is fixed size and integer only. A field marked invalid passes
+ * through and leaves the state of its channel untouched.
+ */
+
+#define SAMPLE_FILTER_MEDIAN_MAX 9
+
+struct sample_filter_config {
+    uint8_t median_size;        /* Window of the median, 1 disables it */
+    uint8_t ema_alpha_pct;      /* Weight of a new value, 100 disables the EMA */
+    /* Per channel in channel units, an r of 0 disables the Kalman stage of the channel */
+    uint16_t kalman_q[AGGREGATE_CHANNELS];
+    uint16_t kalman_r[AGGREGATE_CHANNELS];
+};
+
+#if defined(CONFIG_WEATHER_STATION_FILTER)
+/* The chain set up in Kconfig, as run by the sensor manager */
+#define SAMPLE_FILTER_CONFIG_DEFAULT                                                         \
+    {                                                                                        \
+        .median_size = CONFIG_WEATHER_STATION_FILTER_MEDIAN_SIZE,                            \
+        .ema_alpha_pct = CONFIG_WEATHER_STATION_FILTER_EMA_ALPHA_PCT,                        \
+        .kalman_q = {                                                                        \
+            CONFIG_WEATHER_STATION_FILTER_KALMAN_TEMP_DRIFT,                                 \
+            CONFIG_WEATHER_STATION_FILTER_KALMAN_HUMIDITY_DRIFT,                             \
+            CONFIG_WEATHER_STATION_FILTER_KALMAN_PRESSURE_DRIFT,                             \
+        },                                                                                   \
+        .kalman_r = {                                                                        \
+            CONFIG_WEATHER_STATION_FILTER_KALMAN_TEMP_NOISE,                                 \
+            CONFIG_WEATHER_STATION_FILTER_KALMAN_HUMIDITY_NOISE,                             \
+            CONFIG_WEATHER_STATION_FILTER_KALMAN_PRESSURE_NOISE,                             \
+        },                                                                                   \
+    }
+#endif
+
+struct sample_filter_channel {
+    int32_t window[SAMPLE_FILTER_MEDIAN_MAX];   /* Last values, oldest at next */
+    uint8_t count;
+    uint8_t next;
+    bool primed;                /* The EMA and the estimate hold a value */
+    int32_t ema_q8;             /* Channel units, Q8 */
+    int64_t estimate_q8;        /* Channel units, Q8 */
+    int64_t variance_q8;        /* Of the estimate, channel units squared, Q8 */
+};
+
+struct sample_filter {
+    struct sample_filter_config config;
+    struct sample_filter_channel channels[AGGREGATE_CHANNELS];
+};
+
+/* median_size is clamped to [1, SAMPLE_FILTER_MEDIAN_MAX], ema_alpha_pct to [1, 100] */
+void sample_filter_init(struct sample_filter *filter, const struct sample_filter_config *config);
+
+/* Filter the valid measurement fields of msg in place */
+void sample_filter_apply(struct sample_filter *filter, struct sensor_data_msg *msg);
+
+#endif /* WEATHER_STATION_SAMPLE_FILTER_H */
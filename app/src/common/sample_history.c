@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+#include "sample_history.h"
+
+static uint16_t encode_dt(uint32_t dt_ms)
+{
+    if (dt_ms < SAMPLE_HISTORY_DT_SECONDS) {
+        return (uint16_t)dt_ms;
+    }
+
+    return SAMPLE_HISTORY_DT_SECONDS |
+           (uint16_t)MIN(dt_ms / MSEC_PER_SEC, SAMPLE_HISTORY_DT_SECONDS - 1U);
+}
+
+static uint32_t decode_dt(uint16_t dt)
+{
+    if (dt & SAMPLE_HISTORY_DT_SECONDS) {
+        return (uint32_t)(dt & ~SAMPLE_HISTORY_DT_SECONDS) * MSEC_PER_SEC;
+    }
+
+    return dt;
+}
+
+void sample_history_init(struct sample_history *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+void sample_history_append(struct sample_history *hist, const struct sensor_data_msg *msg)
+{
+    int16_t temp = (msg->flags & SENSOR_FLAG_TEMP_INVALID) ?
+                   SAMPLE_HISTORY_TEMP_INVALID : msg->temperature_centi_c;
+    uint16_t humidity = (msg->flags & SENSOR_FLAG_HUMIDITY_INVALID) ?
+                        SAMPLE_HISTORY_HUMIDITY_INVALID : msg->humidity_deci_pct;
+    uint16_t pressure = (msg->flags & SENSOR_FLAG_PRESSURE_INVALID) ?
+                        SAMPLE_HISTORY_PRESSURE_INVALID :
+                        MIN(msg->pressure_pa_off, SAMPLE_HISTORY_PRESSURE_INVALID - 1U);
+
+    k_spinlock_key_t key = k_spin_lock(&hist->lock);
+    uint32_t slot = hist->head % SAMPLE_HISTORY_SIZE;
+    uint32_t dt_ms = 0;
+
+    /* Unsigned difference stays correct across the 32-bit ms wrap */
+    if (hist->head > 0) {
+        dt_ms = msg->timestamp - hist->newest_ts;
+    }
+
+    /*
+     * Full: the slot about to be reused holds the oldest sample and its
+     * successor becomes the oldest, so its delta leaves the span. The span
+     * uses decoded deltas to agree with timestamps rebuilt by a cursor.
+     */
+    if (hist->head >= SAMPLE_HISTORY_SIZE) {
+        hist->span_ms -= decode_dt(hist->dt[(hist->head + 1U) % SAMPLE_HISTORY_SIZE]);
+    }
+    hist->span_ms += decode_dt(encode_dt(dt_ms));
+
+    hist->temperature_centi_c[slot] = temp;
+    hist->humidity_deci_pct[slot] = humidity;
+    hist->pressure_pa_off[slot] = pressure;
+    hist->dt[slot] = encode_dt(dt_ms);
+    hist->newest_ts = msg->timestamp;
+    hist->head++;
+    k_spin_unlock(&hist->lock, key);
+}
+
+uint32_t sample_history_count(struct sample_history *hist)
+{
+    k_spinlock_key_t key = k_spin_lock(&hist->lock);
+    uint32_t count = MIN(hist->head, SAMPLE_HISTORY_SIZE);
+
+    k_spin_unlock(&hist->lock, key);
+    return count;
+}
+
+bool sample_history_oldest(struct sample_history *hist, uint32_t *timestamp)
+{
+    k_spinlock_key_t key = k_spin_lock(&hist->lock);
+    bool found = (hist->head > 0);
+
+    *timestamp = hist->newest_ts - hist->span_ms;
+    k_spin_unlock(&hist->lock, key);
+    return found;
+}
+
+void sample_history_cursor_init(struct sample_history *hist,
+                                struct sample_history_cursor *cursor,
+                                uint32_t max_entries)
+{
+    k_spinlock_key_t key = k_spin_lock(&hist->lock);
+
+    cursor->index = hist->head - 1U;
+    cursor->remaining = MIN(max_entries, MIN(hist->head, SAMPLE_HISTORY_SIZE));
+    cursor->timestamp = hist->newest_ts;
+    k_spin_unlock(&hist->lock, key);
+}
+
+int sample_history_prev(struct sample_history *hist,
+                        struct sample_history_cursor *cursor,
+                        struct sample_history_entry *entry)
+{
+    if (cursor->remaining == 0) {
+        return -ENOENT;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&hist->lock);
+
+    /* The slot may have been recycled by appends since the cursor was made */
+    if (hist->head - cursor->index > SAMPLE_HISTORY_SIZE) {
+        k_spin_unlock(&hist->lock, key);
+        cursor->remaining = 0;
+        return -ENOENT;
+    }
+
+    uint32_t slot = cursor->index % SAMPLE_HISTORY_SIZE;
+    uint16_t pressure = hist->pressure_pa_off[slot];
+    uint32_t dt_ms = decode_dt(hist->dt[slot]);
+
+    entry->timestamp = cursor->timestamp;
+    entry->temperature_centi_c = hist->temperature_centi_c[slot];
+    entry->humidity_deci_pct = hist->humidity_deci_pct[slot];
+    k_spin_unlock(&hist->lock, key);
+
+    entry->pressure_pa = (pressure == SAMPLE_HISTORY_PRESSURE_INVALID) ?
+                         0 : pressure + SENSOR_PRESSURE_BASE_PA;
+
+    cursor->index--;
+    cursor->remaining--;
+    cursor->timestamp -= dt_ms;
+
+    return 0;
+}
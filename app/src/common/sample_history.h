@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_SAMPLE_HISTORY_H
+#define WEATHER_STATION_SAMPLE_HISTORY_H
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "messages.h"
+
+/*
+ * Fixed-capacity ring of sensor samples.
+ *
+ * Samples are stored as a struct of arrays in the sensor_data_msg fixed-point
+ * units, 8 bytes per sample instead of a full message:
+ *   - temperature in centi-degrees Celsius (int16)
+ *   - relative humidity in deci-percent (uint16)
+ *   - pressure in Pa, offset by SENSOR_PRESSURE_BASE_PA (uint16)
+ *   - time since the previous sample (uint16, see SAMPLE_HISTORY_DT_SECONDS)
+ *
+ * Only the newest timestamp is kept in full; older timestamps are rebuilt
+ * while walking backwards from it. Appending is O(1) and never blocks.
+ */
+
+#define SAMPLE_HISTORY_SIZE CONFIG_WEATHER_STATION_HISTORY_SIZE
+
+/* Invalid markers for the fixed-point fields */
+#define SAMPLE_HISTORY_TEMP_INVALID     INT16_MIN
+#define SAMPLE_HISTORY_HUMIDITY_INVALID UINT16_MAX
+#define SAMPLE_HISTORY_PRESSURE_INVALID UINT16_MAX
+
+/*
+ * Time deltas below 32.768 s are stored in ms. Longer gaps set this bit and
+ * store whole seconds instead (up to ~9 h), trading precision for range.
+ */
+#define SAMPLE_HISTORY_DT_SECONDS BIT(15)
+
+struct sample_history {
+    struct k_spinlock lock;
+    uint32_t head;          /* Total number of samples ever appended */
+    uint32_t newest_ts;     /* Timestamp of the newest sample, ms */
+    uint32_t span_ms;       /* Decoded time from the oldest to the newest sample */
+    int16_t temperature_centi_c[SAMPLE_HISTORY_SIZE];
+    uint16_t humidity_deci_pct[SAMPLE_HISTORY_SIZE];
+    uint16_t pressure_pa_off[SAMPLE_HISTORY_SIZE];
+    uint16_t dt[SAMPLE_HISTORY_SIZE];
+};
+
+/* Decoded history entry */
+struct sample_history_entry {
+    uint32_t timestamp;         /* ms, same time base as sensor_data_msg */
+    int16_t temperature_centi_c;
+    uint16_t humidity_deci_pct;
+    uint32_t pressure_pa;       /* 0 if invalid */
+};
+
+/* Read position, walks from the newest sample towards the oldest */
+struct sample_history_cursor {
+    uint32_t index;         /* Absolute index of the next entry to read */
+    uint32_t remaining;     /* Entries left before the cursor stops */
+    uint32_t timestamp;     /* Timestamp of the entry at index */
+};
+
+void sample_history_init(struct sample_history *hist);
+
+/* Append one sample, overwriting the oldest one when full. ISR safe. */
+void sample_history_append(struct sample_history *hist, const struct sensor_data_msg *msg);
+
+/* Number of samples currently held */
+uint32_t sample_history_count(struct sample_history *hist);
+
+/* Timestamp of the oldest sample held; false if the history is empty */
+bool sample_history_oldest(struct sample_history *hist, uint32_t *timestamp);
+
+/* Position a cursor on the newest sample, limited to max_entries reads */
+void sample_history_cursor_init(struct sample_history *hist,
+                                struct sample_history_cursor *cursor,
+                                uint32_t max_entries);
+
+/**
+ * @brief Read the entry under the cursor and step to the next older one
+ *
+ * Safe to call concurrently with sample_history_append(); the lock is only
+ * held for a single entry.
+ *
+ * @return 0 on success, -ENOENT when the cursor is exhausted or the
+ *         remaining entries have been overwritten by newer samples
+ */
+int sample_history_prev(struct sample_history *hist,
+                        struct sample_history_cursor *cursor,
+                        struct sample_history_entry *entry);
+
+#endif /* WEATHER_STATION_SAMPLE_HISTORY_H */
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <string.h>
+#include "sample_query.h"
+
+static const char *const sample_agg_names[SAMPLE_AGG_COUNT] = {
+    [SAMPLE_AGG_AVG] = "avg",
+    [SAMPLE_AGG_MIN] = "min",
+    [SAMPLE_AGG_MAX] = "max",
+    [SAMPLE_AGG_LAST] = "last",
+};
+
+const char *sample_agg_name(enum sample_agg agg)
+{
+    return (agg < SAMPLE_AGG_COUNT) ? sample_agg_names[agg] : "?";
+}
+
+int sample_agg_by_name(const char *name)
+{
+    for (int agg = 0; agg < SAMPLE_AGG_COUNT; agg++) {
+        if (strcmp(name, sample_agg_names[agg]) == 0) {
+            return agg;
+        }
+    }
+
+    return -ENOENT;
+}
+
+void sample_query_init(struct sample_query *q, uint64_t from, uint64_t to, uint32_t step,
+                       enum sample_agg agg, sample_bucket_cb cb, void *user_data)
+{
+    memset(q, 0, sizeof(*q));
+    q->from = from;
+    q->to = to;
+    q->step = step;
+    q->agg = agg;
+    q->cb = cb;
+    q->user_data = user_data;
+}
+
+static void sample_query_emit(struct sample_query *q)
+{
+    struct sample_bucket *bucket = &q->bucket;
+
+    if (bucket->count == 0) {
+        return;
+    }
+
+    for (int ch = 0; ch < STATS_CHANNEL_COUNT; ch++) {
+        const struct stats_acc *acc = &q->acc[ch];
+
+        if (acc->count == 0) {
+            continue;
+        }
+
+        bucket->valid |= BIT(ch);
+        switch (q->agg) {
+        case SAMPLE_AGG_MIN:
+            bucket->values[ch] = acc->min;
+            break;
+        case SAMPLE_AGG_MAX:
+            bucket->values[ch] = acc->max;
+            break;
+        case SAMPLE_AGG_AVG:
+            bucket->values[ch] = stats_acc_mean(acc);
+            break;
+        default:
+            // Last values are stored as samples come in
+            break;
+        }
+    }
+
+    q->buckets++;
+    if (!q->cb(bucket, q->user_data)) {
+        q->stopped = true;
+    }
+
+    memset(bucket, 0, sizeof(*bucket));
+    memset(q->acc, 0, sizeof(q->acc));
+}
+
+bool sample_query_add(struct sample_query *q, const struct sample_record *rec)
+{
+    if (q->stopped || rec->time > q->to) {
+        return false;
+    }
+    if (rec->time < q->from) {
+        return true;
+    }
+
+    uint64_t start = rec->time;
+
+    if (q->step > 0) {
+        start = q->from + (rec->time - q->from) / q->step * q->step;
+    }
+
+    if (q->bucket.count > 0 && (q->step == 0 || start != q->bucket.start)) {
+        sample_query_emit(q);
+        if (q->stopped) {
+            return false;
+        }
+    }
+
+    // Reuse the invalid flag handling of the statistics
+    struct sensor_data_msg msg = {
+        .temperature_centi_c = rec->temperature_centi_c,
+        .humidity_deci_pct = rec->humidity_deci_pct,
+        .pressure_pa_off = rec->pressure_pa_off,
+        .flags = rec->flags,
+    };
+    int32_t values[STATS_CHANNEL_COUNT];
+    uint32_t valid = stats_sample_values(&msg, values);
+
+    q->bucket.start = start;
+    q->bucket.count++;
+    for (int ch = 0; ch < STATS_CHANNEL_COUNT; ch++) {
+        if (valid & BIT(ch)) {
+            stats_acc_add(&q->acc[ch], values[ch]);
+            q->bucket.values[ch] = (q->agg == SAMPLE_AGG_LAST) ? values[ch] : 0;
+        }
+    }
+
+    return true;
+}
+
+uint32_t sample_query_finish(struct sample_query *q)
+{
+    if (!q->stopped) {
+        sample_query_emit(q);
+    }
+
+    return q->buckets;
+}
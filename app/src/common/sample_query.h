@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_SAMPLE_QUERY_H
+#define WEATHER_STATION_SAMPLE_QUERY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sample_codec.h"
+#include "stats_window.h"
+
+/*
+ * Streaming aggregation of samples into fixed-size time buckets.
+ *
+ * Samples are fed oldest first. Buckets start at from + k * step and are
+ * handed to the callback as soon as a sample lands in a later one, so the
+ * memory used does not depend on the range. Buckets without samples are
+ * skipped. A step of 0 hands out every sample on its own.
+ */
+
+enum sample_agg {
+    SAMPLE_AGG_AVG,
+    SAMPLE_AGG_MIN,
+    SAMPLE_AGG_MAX,
+    SAMPLE_AGG_LAST,
+    SAMPLE_AGG_COUNT
+};
+
+struct sample_bucket {
+    uint64_t start;         /* ms */
+    uint32_t count;         /* Samples in the bucket */
+    uint32_t valid;         /* BIT(enum stats_channel) of the channels with a value */
+    int32_t values[STATS_CHANNEL_COUNT];    /* Channel units, see stats_window.h */
+};
+
+/* Called for each bucket, oldest first; return false to stop */
+typedef bool (*sample_bucket_cb)(const struct sample_bucket *bucket, void *user_data);
+
+struct sample_query {
+    uint64_t from;
+    uint64_t to;
+    uint32_t step;
+    enum sample_agg agg;
+    sample_bucket_cb cb;
+    void *user_data;
+    bool stopped;
+    uint32_t buckets;       /* Buckets handed out */
+    struct sample_bucket bucket;
+    struct stats_acc acc[STATS_CHANNEL_COUNT];
+};
+
+const char *sample_agg_name(enum sample_agg agg);
+
+/* Look up an aggregate by name, returns the aggregate or -ENOENT */
+int sample_agg_by_name(const char *name);
+
+void sample_query_init(struct sample_query *q, uint64_t from, uint64_t to, uint32_t step,
+                       enum sample_agg agg, sample_bucket_cb cb, void *user_data);
+
+/*
+ * Feed the next sample. Returns false once no later sample can be part of
+ * the result: past the end of the range or stopped by the callback.
+ */
+bool sample_query_add(struct sample_query *q, const struct sample_record *rec);
+
+/* Hand out the last bucket; returns the number of buckets handed out */
+uint32_t sample_query_finish(struct sample_query *q);
+
+#endif /* WEATHER_STATION_SAMPLE_QUERY_H */
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_SAMPLE_SCHED_H
+#define WEATHER_STATION_SAMPLE_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Periodic sampling scheduler. Publishes TRIGGER_TIMER messages on
+ * ws_trigger at absolute deadlines (epoch + n * period), so timer and work
+ * queue latency never accumulates into drift. Triggers are published from
+ * the system workqueue without waiting, so one the ws_trigger queue has no
+ * room for is counted as missed, whatever the channel policy.
+ *
+ * In adaptive mode the period follows the rate of change of the published
+ * samples, between CONFIG_WEATHER_STATION_ADAPTIVE_RATE_MIN_MS and
+ * CONFIG_WEATHER_STATION_ADAPTIVE_RATE_MAX_MS, see adaptive_rate.h.
+ */
+
+struct sample_sched_stats {
+    uint32_t period_ms;     /* 0 when periodic sampling is stopped */
+    uint32_t triggers;      /* Triggers published */
+    uint32_t late;          /* Triggers published more than 10% of a period late */
+    uint32_t missed;        /* Deadlines skipped or triggers that could not be queued */
+    uint32_t max_late_ms;   /* Worst lateness seen since the period was set */
+    bool adaptive;          /* Period set by the adaptive controller */
+    uint32_t activity_pct;  /* Adaptive mode: last decided rate, percent of thresholds */
+    uint32_t adjustments;   /* Period changes made by the adaptive controller */
+};
+
+/**
+ * @brief Set a fixed sampling period and restart the schedule from now
+ *
+ * Leaves adaptive mode.
+ *
+ * @param period_ms Period in milliseconds, 0 stops periodic sampling
+ * @return 0 on success, -EINVAL if the period is out of range
+ */
+int sample_sched_set_period(uint32_t period_ms);
+
+/**
+ * @brief Let the rate of change of the samples set the period
+ *
+ * Starts from the current period clamped to the adaptive bounds, or from
+ * the longest one if periodic sampling is stopped.
+ *
+ * @return 0 on success, -ENOTSUP without CONFIG_WEATHER_STATION_ADAPTIVE_RATE
+ */
+int sample_sched_set_adaptive(void);
+
+uint32_t sample_sched_get_period(void);
+
+void sample_sched_get_stats(struct sample_sched_stats *stats);
+
+#endif /* WEATHER_STATION_SAMPLE_SCHED_H */
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_SENSOR_MGR_H
+#define WEATHER_STATION_SENSOR_MGR_H
+
+#include <zephyr/device.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sample_history.h"
+#include "rollup.h"
+#include "sample_cache.h"
+
+#define SENSOR_MGR_PRIMARY_ID CONFIG_WEATHER_STATION_PRIMARY_SENSOR_ID
+
+/* Real samples of the primary sensor are the ones recorded, see Kconfig */
+static inline bool sensor_mgr_recorded(const struct sensor_data_msg *msg)
+{
+    return sensor_data_id(msg) == SENSOR_MGR_PRIMARY_ID && !sensor_data_synthetic(msg);
+}
+
+/* History of the primary sensor's samples published on ws_sensor_data */
+struct sample_history *sensor_mgr_history(void);
+
+/* Minute and hour rollups of the same samples, raw tier is the history */
+struct rollup *sensor_mgr_rollup(void);
+
+/* Newest sample of every sensor, kept up to date from ws_sensor_data */
+struct sample_cache *sensor_mgr_cache(void);
+
+struct sensor_mgr_trigger_stats {
+    uint32_t triggers;      /* Triggers handled */
+    uint32_t acquisitions;  /* Triggers that started a read of at least one probe */
+    uint32_t coalesced;     /* Triggers folded entirely into reads already in flight */
+    uint32_t failed;        /* Triggers for which no probe could be read */
+};
+
+/* Trigger counters since boot, triggers == acquisitions + coalesced + failed */
+void sensor_mgr_get_trigger_stats(struct sensor_mgr_trigger_stats *stats);
+
+/* Reads that could not be queued or completed with an error */
+uint32_t sensor_mgr_read_errors(void);
+
+/* Sequence number the next published sample will carry */
+uint16_t sensor_mgr_next_sequence(void);
+
+/* Number of probes read on every trigger */
+size_t sensor_mgr_sensor_count(void);
+
+/* Probe at index and its sensor id, NULL past the last one */
+const struct device *sensor_mgr_sensor(size_t index, uint8_t *id);
+
+#endif /* WEATHER_STATION_SENSOR_MGR_H */
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_SEQLOCK_H
+#define WEATHER_STATION_SEQLOCK_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/barrier.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Sequence lock over two copies of the protected data (a "latch"), for a
+ * single writer and any number of readers that never wait.
+ *
+ * The writer bumps the sequence, updates copy 0, bumps it again and
+ * updates copy 1. Readers copy out the copy selected by the low bit of the
+ * sequence, which the writer is not touching, and retry if the sequence
+ * moved meanwhile. A writer preempted halfway therefore never stalls a
+ * reader, which matters when readers run at a higher priority.
+ *
+ *   Writer:                           Reader:
+ *     seqlock_write_switch(&sl);        do {
+ *     update(&copies[0]);                   seq = seqlock_read_begin(&sl);
+ *     seqlock_write_switch(&sl);            out = copies[seqlock_read_index(seq)];
+ *     update(&copies[1]);               } while (seqlock_read_retry(&sl, seq));
+ *
+ * Writers must be serialised by the caller.
+ */
+
+struct seqlock {
+    atomic_t seq;
+};
+
+#define SEQLOCK_INIT {.seq = ATOMIC_INIT(0)}
+
+static inline void seqlock_init(struct seqlock *sl)
+{
+    atomic_set(&sl->seq, 0);
+}
+
+/* Point readers at the other copy, then update the one they just left */
+static inline void seqlock_write_switch(struct seqlock *sl)
+{
+    barrier_dmem_fence_full();
+    atomic_inc(&sl->seq);
+    barrier_dmem_fence_full();
+}
+
+static inline uint32_t seqlock_read_begin(const struct seqlock *sl)
+{
+    uint32_t seq = (uint32_t)atomic_get(&sl->seq);
+
+    barrier_dmem_fence_full();
+    return seq;
+}
+
+/* Copy that is stable for a read started at seq */
+static inline unsigned int seqlock_read_index(uint32_t seq)
+{
+    return seq & 1U;
+}
+
+/* True if the copy read since seqlock_read_begin() may be torn */
+static inline bool seqlock_read_retry(const struct seqlock *sl, uint32_t seq)
+{
+    barrier_dmem_fence_full();
+    return (uint32_t)atomic_get(&sl->seq) != seq;
+}
+
+#endif /* WEATHER_STATION_SEQLOCK_H */
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+#include <string.h>
+#include "stats_window.h"
+
+static uint32_t stats_isqrt(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)root;
+}
+
+int32_t stats_acc_mean(const struct stats_acc *acc)
+{
+    int64_t half = acc->count / 2;
+    int64_t sum = (acc->sum < 0) ? acc->sum - half : acc->sum + half;
+
+    return (int32_t)(sum / (int64_t)acc->count);
+}
+
+/*
+ * Truncated standard deviation of an accumulator with count > 1.
+ *
+ * The sum of squared deviations is sum_sq - sum^2 / count. With
+ * sum = q * count + r the square splits into terms no larger than sum_sq,
+ * so it is computed in 64 bits without forming sum^2.
+ */
+static uint32_t stats_acc_stddev(const struct stats_acc *acc)
+{
+    int64_t n = acc->count;
+    int64_t q = acc->sum / n;
+    int64_t r = acc->sum - q * n;
+    int64_t m2 = (int64_t)acc->sum_sq - q * acc->sum - q * r - (r * r) / n;
+
+    return stats_isqrt((m2 > 0) ? (uint64_t)((m2 + (n - 1) / 2) / (n - 1)) : 0);
+}
+
+uint32_t stats_sample_values(const struct sensor_data_msg *msg,
+                             int32_t values[STATS_CHANNEL_COUNT])
+{
+    uint32_t valid = 0;
+
+    if (!(msg->flags & SENSOR_FLAG_TEMP_INVALID)) {
+        values[STATS_TEMPERATURE] = msg->temperature_centi_c;
+        valid |= BIT(STATS_TEMPERATURE);
+    }
+    if (!(msg->flags & SENSOR_FLAG_HUMIDITY_INVALID)) {
+        values[STATS_HUMIDITY] = msg->humidity_deci_pct;
+        valid |= BIT(STATS_HUMIDITY);
+    }
+    if (!(msg->flags & SENSOR_FLAG_PRESSURE_INVALID)) {
+        values[STATS_PRESSURE] = (int32_t)sensor_data_pressure(msg);
+        valid |= BIT(STATS_PRESSURE);
+    }
+
+    return valid;
+}
+
+void stats_acc_reset(struct stats_acc *acc)
+{
+    memset(acc, 0, sizeof(*acc));
+}
+
+void stats_acc_add(struct stats_acc *acc, int32_t value)
+{
+    if (acc->count == 0) {
+        acc->min = value;
+        acc->max = value;
+    } else {
+        acc->min = MIN(acc->min, value);
+        acc->max = MAX(acc->max, value);
+    }
+
+    acc->count++;
+    acc->sum += value;
+    acc->sum_sq += (uint64_t)((int64_t)value * value);
+}
+
+void stats_acc_merge(struct stats_acc *dst, const struct stats_acc *src)
+{
+    if (src->count == 0) {
+        return;
+    }
+
+    if (dst->count == 0) {
+        dst->min = src->min;
+        dst->max = src->max;
+    } else {
+        dst->min = MIN(dst->min, src->min);
+        dst->max = MAX(dst->max, src->max);
+    }
+
+    dst->count += src->count;
+    dst->sum += src->sum;
+    dst->sum_sq += src->sum_sq;
+}
+
+void stats_acc_summary(const struct stats_acc *acc, struct aggregate_stats *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+    if (acc->count == 0) {
+        return;
+    }
+
+    summary->count = acc->count;
+    summary->min = acc->min;
+    summary->max = acc->max;
+    summary->mean = stats_acc_mean(acc);
+
+    if (acc->count > 1) {
+        summary->stddev = stats_acc_stddev(acc);
+    }
+}
+
+void stats_running_reset(struct stats_running *run)
+{
+    memset(run, 0, sizeof(*run));
+}
+
+void stats_running_add(struct stats_running *run, int32_t value)
+{
+    if (run->acc.count == 0) {
+        run->shift = value;
+    }
+
+    // Deviations from the first value stay small, so do their sums
+    stats_acc_add(&run->acc, value - run->shift);
+}
+
+void stats_running_summary(const struct stats_running *run, struct aggregate_stats *summary)
+{
+    stats_acc_summary(&run->acc, summary);
+    if (run->acc.count > 0) {
+        summary->min += run->shift;
+        summary->max += run->shift;
+        summary->mean += run->shift;
+    }
+}
+
+void stats_window_reset(struct stats_window *win)
+{
+    memset(win->buckets, 0, sizeof(win->buckets[0]) * win->bucket_count);
+    memset(win->total, 0, sizeof(win->total));
+    win->head_start = 0;
+    win->head = 0;
+}
+
+/* Move the head bucket forward to now_ms, expiring the buckets it passes */
+static void stats_window_advance(struct stats_window *win, int64_t now_ms)
+{
+    int64_t start = now_ms - (now_ms % win->bucket_ms);
+
+    if (start <= win->head_start) {
+        return;
+    }
+
+    int64_t steps = (start - win->head_start) / win->bucket_ms;
+
+    if (steps >= win->bucket_count) {
+        memset(win->buckets, 0, sizeof(win->buckets[0]) * win->bucket_count);
+        memset(win->total, 0, sizeof(win->total));
+    } else {
+        // At most one step per bucket period, O(1) amortised per sample
+        for (int64_t i = 0; i < steps; i++) {
+            win->head = (win->head + 1) % win->bucket_count;
+
+            for (int ch = 0; ch < STATS_CHANNEL_COUNT; ch++) {
+                struct stats_acc *old = &win->buckets[win->head][ch];
+
+                win->total[ch].count -= old->count;
+                win->total[ch].sum -= old->sum;
+                win->total[ch].sum_sq -= old->sum_sq;
+                stats_acc_reset(old);
+            }
+        }
+    }
+
+    win->head_start = start;
+}
+
+void stats_window_add(struct stats_window *win, int64_t now_ms,
+                      const int32_t values[STATS_CHANNEL_COUNT], uint32_t valid)
+{
+    stats_window_advance(win, now_ms);
+
+    for (int ch = 0; ch < STATS_CHANNEL_COUNT; ch++) {
+        if (valid & BIT(ch)) {
+            stats_acc_add(&win->buckets[win->head][ch], values[ch]);
+            stats_acc_add(&win->total[ch], values[ch]);
+        }
+    }
+}
+
+void stats_window_summary(struct stats_window *win, int64_t now_ms,
+                          enum stats_channel channel, struct aggregate_stats *summary)
+{
+    struct stats_acc acc;
+
+    stats_window_advance(win, now_ms);
+
+    /*
+     * Count and sums are kept up to date for the whole window. Extremes
+     * cannot be un-merged when a bucket expires, so they come from a pass
+     * over the buckets.
+     */
+    acc = win->total[channel];
+    acc.min = INT32_MAX;
+    acc.max = INT32_MIN;
+    for (uint32_t i = 0; i < win->bucket_count; i++) {
+        const struct stats_acc *bucket = &win->buckets[i][channel];
+
+        if (bucket->count > 0) {
+            acc.min = MIN(acc.min, bucket->min);
+            acc.max = MAX(acc.max, bucket->max);
+        }
+    }
+
+    stats_acc_summary(&acc, summary);
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_STATS_WINDOW_H
+#define WEATHER_STATION_STATS_WINDOW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "messages.h"
+
+/*
+ * Streaming statistics over the sensor channels.
+ *
+ * Values are integers in the channel's natural fixed-point unit:
+ * temperature in centi-degrees Celsius, humidity in deci-percent and
+ * pressure in Pa.
+ *
+ * - stats_running: all-time statistics. Sums are kept of the deviations
+ *   from the first sample, which stay small however many samples are
+ *   added.
+ * - stats_window: a sliding window made of time buckets. Each bucket keeps
+ *   exact integer sums, so adding a sample and expiring a bucket are both
+ *   O(1) whatever the window length. The window covers between
+ *   (buckets - 1) and buckets bucket periods.
+ *
+ * None of this locks; callers serialise access.
+ */
+
+enum stats_channel {
+    STATS_TEMPERATURE,
+    STATS_HUMIDITY,
+    STATS_PRESSURE,
+    STATS_CHANNEL_COUNT
+};
+
+/* Summaries use the aggregate_msg layout, all zero when count is 0 */
+BUILD_ASSERT(STATS_CHANNEL_COUNT == AGGREGATE_CHANNELS);
+
+/* Mergeable accumulator of one channel */
+struct stats_acc {
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    uint64_t sum_sq;
+};
+
+/* Running statistics of one channel */
+struct stats_running {
+    int32_t shift;          /* First value added */
+    struct stats_acc acc;   /* Of value - shift */
+};
+
+struct stats_window {
+    uint32_t bucket_ms;
+    uint32_t bucket_count;
+    struct stats_acc (*buckets)[STATS_CHANNEL_COUNT];
+    struct stats_acc total[STATS_CHANNEL_COUNT]; /* count and sums of all buckets */
+    int64_t head_start;     /* Start time of the newest bucket, ms */
+    uint32_t head;          /* Index of the newest bucket */
+};
+
+/* Define the bucket storage of a window and initialise it */
+#define STATS_WINDOW_DEFINE(_name, _bucket_ms, _buckets)                             \
+    static struct stats_acc _name##_buckets[_buckets][STATS_CHANNEL_COUNT];          \
+    static struct stats_window _name = {                                             \
+        .bucket_ms = (_bucket_ms),                                                   \
+        .bucket_count = (_buckets),                                                  \
+        .buckets = _name##_buckets,                                                  \
+    }
+
+/*
+ * Extract the channel values of a sample. Returns a mask of BIT(channel)
+ * for the valid ones.
+ */
+uint32_t stats_sample_values(const struct sensor_data_msg *msg,
+                             int32_t values[STATS_CHANNEL_COUNT]);
+
+void stats_acc_reset(struct stats_acc *acc);
+void stats_acc_add(struct stats_acc *acc, int32_t value);
+void stats_acc_merge(struct stats_acc *dst, const struct stats_acc *src);
+void stats_acc_summary(const struct stats_acc *acc, struct aggregate_stats *summary);
+
+/* Mean rounded half away from zero, count must not be 0 */
+int32_t stats_acc_mean(const struct stats_acc *acc);
+
+void stats_running_reset(struct stats_running *run);
+void stats_running_add(struct stats_running *run, int32_t value);
+void stats_running_summary(const struct stats_running *run, struct aggregate_stats *summary);
+
+void stats_window_reset(struct stats_window *win);
+
+/* Add the valid channels of a sample taken at now_ms */
+void stats_window_add(struct stats_window *win, int64_t now_ms,
+                      const int32_t values[STATS_CHANNEL_COUNT], uint32_t valid);
+
+/* Summary of a channel over the window ending at now_ms */
+void stats_window_summary(struct stats_window *win, int64_t now_ms,
+                          enum stats_channel channel, struct aggregate_stats *summary);
+
+#endif /* WEATHER_STATION_STATS_WINDOW_H */
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+#include <stdio.h>
+#include <string.h>
+#include "value_fmt.h"
+
+#if defined(CONFIG_WEATHER_STATION_VALUE_FORMAT_FLOAT)
+
+size_t value_fmt_fixed(char *buf, size_t len, int32_t value, unsigned int decimals)
+{
+    double scaled = value;
+
+    decimals = MIN(decimals, VALUE_FMT_MAX_DECIMALS);
+    for (unsigned int i = 0; i < decimals; i++) {
+        scaled /= 10.0;
+    }
+
+    int n = snprintf(buf, len, "%.*f", (int)decimals, scaled);
+
+    return (len == 0 || n < 0) ? 0 : MIN((size_t)n, len - 1);
+}
+
+#else
+
+size_t value_fmt_fixed(char *buf, size_t len, int32_t value, unsigned int decimals)
+{
+    char digits[VALUE_FMT_LEN];
+    uint32_t mag = (value < 0) ? -(uint32_t)value : (uint32_t)value;
+    size_t count = 0;
+    size_t pos = 0;
+
+    if (len == 0) {
+        return 0;
+    }
+
+    decimals = MIN(decimals, VALUE_FMT_MAX_DECIMALS);
+
+    // Least significant first, with a leading zero before the point
+    do {
+        digits[count++] = (char)('0' + mag % 10U);
+        mag /= 10U;
+    } while (mag != 0 || count <= decimals);
+
+    if (value < 0 && pos < len - 1) {
+        buf[pos++] = '-';
+    }
+    while (count > 0 && pos < len - 1) {
+        if (count == decimals) {
+            buf[pos++] = '.';
+            if (pos == len - 1) {
+                break;
+            }
+        }
+        buf[pos++] = digits[--count];
+    }
+    buf[pos] = '\0';
+
+    return pos;
+}
+
+#endif
+
+static size_t value_fmt_field(char *buf, size_t len, bool invalid, int32_t value,
+                              unsigned int decimals)
+{
+    if (invalid) {
+        if (len == 0) {
+            return 0;
+        }
+        strncpy(buf, "n/a", len - 1);
+        buf[len - 1] = '\0';
+        return strlen(buf);
+    }
+
+    return value_fmt_fixed(buf, len, value, decimals);
+}
+
+size_t value_fmt_temperature(char *buf, size_t len, const struct sensor_data_msg *msg)
+{
+    return value_fmt_field(buf, len, msg->flags & SENSOR_FLAG_TEMP_INVALID,
+                           msg->temperature_centi_c, 2);
+}
+
+size_t value_fmt_humidity(char *buf, size_t len, const struct sensor_data_msg *msg)
+{
+    return value_fmt_field(buf, len, msg->flags & SENSOR_FLAG_HUMIDITY_INVALID,
+                           msg->humidity_deci_pct, 1);
+}
+
+size_t value_fmt_pressure(char *buf, size_t len, const struct sensor_data_msg *msg)
+{
+    return value_fmt_field(buf, len, msg->flags & SENSOR_FLAG_PRESSURE_INVALID,
+                           (int32_t)sensor_data_pressure(msg), 0);
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WEATHER_STATION_VALUE_FMT_H
+#define WEATHER_STATION_VALUE_FMT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "messages.h"
+
+/*
+ * Text rendering of fixed-point values for the shell, the display and the
+ * logs. With CONFIG_WEATHER_STATION_VALUE_FORMAT_FIXED the digits are
+ * produced with integer division only, so images can be built without
+ * CONFIG_CBPRINTF_FP_SUPPORT; the float variant goes through "%.*f".
+ */
+
+/* Fits any int32_t with up to VALUE_FMT_MAX_DECIMALS decimals, plus the NUL */
+#define VALUE_FMT_LEN 16
+
+#define VALUE_FMT_MAX_DECIMALS 9
+
+/**
+ * @brief Render value / 10^decimals, e.g. 2150 with 2 -> "21.50"
+ *
+ * The text is truncated to fit and always NUL terminated when len > 0.
+ *
+ * @return Characters written, not counting the NUL
+ */
+size_t value_fmt_fixed(char *buf, size_t len, int32_t value, unsigned int decimals);
+
+/* Sample fields at their wire resolution, "n/a" when the field is invalid */
+size_t value_fmt_temperature(char *buf, size_t len, const struct sensor_data_msg *msg);
+size_t value_fmt_humidity(char *buf, size_t len, const struct sensor_data_msg *msg);
+size_t value_fmt_pressure(char *buf, size_t len, const struct sensor_data_msg *msg);
+
+#endif /* WEATHER_STATION_VALUE_FMT_H */
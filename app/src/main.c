@@ -11,21 +11,6 @@
 
 LOG_MODULE_REGISTER(main, CONFIG_WEATHER_STATION_LOG_LEVEL);
 
-// Define zbus channels (must be global)
-ZBUS_CHAN_DEFINE(ws_trigger,
-                struct trigger_msg,
-                NULL,
-                NULL,
-                ZBUS_OBSERVERS(sensor_mgr_listener),
-                ZBUS_MSG_INIT());
-
-ZBUS_CHAN_DEFINE(ws_sensor_data,
-                struct sensor_data_msg,
-                NULL,
-                NULL,
-                ZBUS_OBSERVERS(display_mgr_listener, shell_iface_listener),
-                ZBUS_MSG_INIT());
-
 int main(void)
 {
     LOG_INF("Weather Station starting...");
@@ -33,7 +18,7 @@ int main(void)
     // ZBUS is automatically initialized by the system
 
     LOG_INF("Weather Station initialized. Type 'ws trigger' to request sensor reading.");
-    LOG_INF("Available commands: ws trigger, ws show, ws status");
+    LOG_INF("Available commands: ws trigger, ws show, ws status, ws history, ws rate, ws stats");
 
     return 0;
 }
\ No newline at end of file
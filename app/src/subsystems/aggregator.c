@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <string.h>
+#include "messages.h"
+#include "aggregator.h"
+#include "pub_policy.h"
+#include "sensor_mgr.h"
+#include "stats_window.h"
+
+LOG_MODULE_REGISTER(aggregator, CONFIG_WEATHER_STATION_LOG_LEVEL);
+
+/*
+ * Bucket sizes trade memory for how sharply samples leave the window:
+ * 48 buckets of three channels, about 4.5 KB in total.
+ */
+STATS_WINDOW_DEFINE(aggregator_1m, 5 * MSEC_PER_SEC, 12);
+STATS_WINDOW_DEFINE(aggregator_1h, 5 * 60 * MSEC_PER_SEC, 12);
+STATS_WINDOW_DEFINE(aggregator_24h, 60 * 60 * MSEC_PER_SEC, 24);
+
+static struct stats_window *const aggregator_windows[] = {
+    [AGGREGATE_WINDOW_1M] = &aggregator_1m,
+    [AGGREGATE_WINDOW_1H] = &aggregator_1h,
+    [AGGREGATE_WINDOW_24H] = &aggregator_24h,
+};
+
+static const char *const aggregator_names[AGGREGATE_WINDOW_COUNT] = {
+    [AGGREGATE_WINDOW_1M] = "1m",
+    [AGGREGATE_WINDOW_1H] = "1h",
+    [AGGREGATE_WINDOW_24H] = "24h",
+    [AGGREGATE_WINDOW_ALL] = "all",
+};
+
+static struct stats_running aggregator_running[STATS_CHANNEL_COUNT];
+
+/* The thread updates, the shell queries */
+static K_MUTEX_DEFINE(aggregator_lock);
+
+PUB_SUBSCRIBER_DEFINE(aggregator_sub);
+
+const char *aggregator_window_name(enum aggregate_window window)
+{
+    return (window < AGGREGATE_WINDOW_COUNT) ? aggregator_names[window] : "?";
+}
+
+int aggregator_window_by_name(const char *name)
+{
+    for (int window = 0; window < AGGREGATE_WINDOW_COUNT; window++) {
+        if (strcmp(name, aggregator_names[window]) == 0) {
+            return window;
+        }
+    }
+
+    return -ENOENT;
+}
+
+int aggregator_query(enum aggregate_window window, struct aggregate_msg *out)
+{
+    if (window >= AGGREGATE_WINDOW_COUNT) {
+        return -EINVAL;
+    }
+
+    int64_t now = k_uptime_get();
+
+    out->timestamp = (uint32_t)now;
+    out->window = window;
+
+    k_mutex_lock(&aggregator_lock, K_FOREVER);
+    for (int ch = 0; ch < STATS_CHANNEL_COUNT; ch++) {
+        if (window == AGGREGATE_WINDOW_ALL) {
+            stats_running_summary(&aggregator_running[ch], &out->channels[ch]);
+        } else {
+            stats_window_summary(aggregator_windows[window], now, ch, &out->channels[ch]);
+        }
+    }
+    k_mutex_unlock(&aggregator_lock);
+
+    return 0;
+}
+
+static void aggregator_add(const struct sensor_data_msg *msg)
+{
+    int32_t values[STATS_CHANNEL_COUNT];
+    uint32_t valid = stats_sample_values(msg, values);
+    int64_t now = k_uptime_get();
+
+    if (!sensor_mgr_recorded(msg)) {
+        return;
+    }
+
+    k_mutex_lock(&aggregator_lock, K_FOREVER);
+    for (int ch = 0; ch < STATS_CHANNEL_COUNT; ch++) {
+        if (valid & BIT(ch)) {
+            stats_running_add(&aggregator_running[ch], values[ch]);
+        }
+    }
+    for (size_t w = 0; w < ARRAY_SIZE(aggregator_windows); w++) {
+        stats_window_add(aggregator_windows[w], now, values, valid);
+    }
+    k_mutex_unlock(&aggregator_lock);
+}
+
+static void aggregator_publish(void)
+{
+    struct aggregate_msg msg;
+
+    for (int window = 0; window < AGGREGATE_WINDOW_COUNT; window++) {
+        aggregator_query(window, &msg);
+
+        int rc = pub_policy_publish(ZBUS_REF(ws_aggregate), &msg);
+        if (rc != 0) {
+            LOG_ERR("Failed to publish %s aggregate: %d", aggregator_names[window], rc);
+        }
+    }
+}
+
+/*
+ * Folds every sample into the running statistics and the windows, and
+ * publishes a summary of each window on ws_aggregate at a fixed period.
+ */
+static void aggregator_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    const struct zbus_channel *chan;
+    struct sensor_data_msg msg;
+    int64_t next_publish = k_uptime_get() + CONFIG_WEATHER_STATION_AGGREGATE_PERIOD_MS;
+
+    while (true) {
+        k_timeout_t timeout = K_FOREVER;
+
+        if (CONFIG_WEATHER_STATION_AGGREGATE_PERIOD_MS > 0) {
+            timeout = K_TIMEOUT_ABS_MS(next_publish);
+        }
+
+        if (pub_policy_wait(&aggregator_sub, &chan, &msg, timeout) == 0 &&
+            chan == ZBUS_REF(ws_sensor_data)) {
+            aggregator_add(&msg);
+        }
+
+        if (CONFIG_WEATHER_STATION_AGGREGATE_PERIOD_MS > 0 && k_uptime_get() >= next_publish) {
+            aggregator_publish();
+            next_publish = MAX(next_publish + CONFIG_WEATHER_STATION_AGGREGATE_PERIOD_MS,
+                               k_uptime_get());
+        }
+    }
+}
+
+K_THREAD_DEFINE(aggregator_tid, CONFIG_WEATHER_STATION_AGGREGATOR_STACK_SIZE,
+                aggregator_thread, NULL, NULL, NULL,
+                CONFIG_WEATHER_STATION_AGGREGATOR_PRIORITY, 0, 0);
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include "messages.h"
+#include "derived_metrics.h"
+#include "pub_policy.h"
+
+LOG_MODULE_REGISTER(derived_mgr, CONFIG_WEATHER_STATION_LOG_LEVEL);
+
+PUB_SUBSCRIBER_DEFINE(derived_mgr_sub);
+
+/* Set once at boot, read-only afterwards */
+static struct derived_station derived_station;
+
+/*
+ * Computes the derived metrics of every sample and publishes them on
+ * ws_derived. Integer only, a sample costs a table lookup and a few
+ * dozen multiplications.
+ */
+static void derived_mgr_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    const struct zbus_channel *chan;
+    struct sensor_data_msg sample;
+    struct derived_data_msg derived;
+
+    while (pub_policy_wait(&derived_mgr_sub, &chan, &sample, K_FOREVER) == 0) {
+        if (chan != ZBUS_REF(ws_sensor_data) || sensor_data_synthetic(&sample)) {
+            continue;
+        }
+
+        derived_metrics_compute(&derived_station, &sample, &derived);
+
+        int rc = pub_policy_publish(ZBUS_REF(ws_derived), &derived);
+        if (rc != 0) {
+            LOG_ERR("Failed to publish derived metrics of sample %u: %d", sample.sequence, rc);
+        }
+    }
+}
+
+K_THREAD_DEFINE(derived_mgr_tid, CONFIG_WEATHER_STATION_DERIVED_STACK_SIZE,
+                derived_mgr_thread, NULL, NULL, NULL,
+                CONFIG_WEATHER_STATION_DERIVED_PRIORITY, 0, 0);
+
+static int derived_mgr_init(void)
+{
+    derived_station_init(&derived_station, CONFIG_WEATHER_STATION_ALTITUDE_M);
+    LOG_INF("Derived metrics initialized (altitude %d m)", derived_station.altitude_m);
+    return 0;
+}
+
+SYS_INIT(derived_mgr_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
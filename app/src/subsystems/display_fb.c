@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/display.h>
+#include <zephyr/logging/log.h>
+#include <stdio.h>
+#include <string.h>
+#include "display_fb.h"
+#include "value_fmt.h"
+
+LOG_MODULE_REGISTER(display_fb, CONFIG_WEATHER_STATION_LOG_LEVEL);
+
+#define DISPLAY_FB_SCALE  CONFIG_WEATHER_STATION_DISPLAY_SCALE
+#define GLYPH_WIDTH       5
+#define GLYPH_HEIGHT      7
+/* One column and one row of spacing around each glyph */
+#define CELL_WIDTH        ((GLYPH_WIDTH + 1) * DISPLAY_FB_SCALE)
+#define CELL_HEIGHT       ((GLYPH_HEIGHT + 1) * DISPLAY_FB_SCALE)
+#define CELL_MAX_BPP      4
+
+#define LAYOUT_COLUMNS    10
+#define LAYOUT_ROWS       4
+#define FIELD_MAX_WIDTH   LAYOUT_COLUMNS
+
+static const struct device *const display_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_display));
+
+/*
+ * 5x7 glyphs, one byte per row, bit 4 is the leftmost column. Only the
+ * characters the layout can produce are included; anything else is drawn
+ * as a blank.
+ */
+static const char glyph_chars[] = "0123456789.-%:/CEHKOPRTahn";
+static const uint8_t glyph_rows[][GLYPH_HEIGHT] = {
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, /* 0 */
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, /* 1 */
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, /* 2 */
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, /* 3 */
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, /* 4 */
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, /* 5 */
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, /* 6 */
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, /* 7 */
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, /* 8 */
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, /* 9 */
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, /* . */
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, /* - */
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, /* % */
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, /* : */
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, /* / */
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, /* C */
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, /* E */
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, /* H */
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, /* K */
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, /* O */
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, /* P */
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, /* R */
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, /* T */
+    {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F}, /* a */
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11}, /* h */
+    {0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11}, /* n */
+};
+
+BUILD_ASSERT(ARRAY_SIZE(glyph_rows) == sizeof(glyph_chars) - 1);
+
+enum display_field_id {
+    FIELD_TEMPERATURE,
+    FIELD_HUMIDITY,
+    FIELD_PRESSURE,
+    FIELD_STATUS,
+    FIELD_COUNT
+};
+
+/* A value on the character grid and the text currently drawn there */
+struct display_field {
+    uint8_t col;
+    uint8_t row;
+    uint8_t width;
+    char shown[FIELD_MAX_WIDTH + 1];
+};
+
+static struct display_field display_fields[FIELD_COUNT] = {
+    [FIELD_TEMPERATURE] = {.col = 2, .row = 0, .width = 8},
+    [FIELD_HUMIDITY] = {.col = 2, .row = 1, .width = 8},
+    [FIELD_PRESSURE] = {.col = 2, .row = 2, .width = 8},
+    [FIELD_STATUS] = {.col = 0, .row = 3, .width = 10},
+};
+
+/* Static labels, drawn once by display_fb_init() */
+static const char *const display_labels[LAYOUT_ROWS] = {"T:", "H:", "P:", ""};
+
+/* Colours are all-ones or all-zeros bytes, valid in every supported format */
+static uint8_t display_bpp;
+static uint8_t cell_buf[CELL_WIDTH * CELL_HEIGHT * CELL_MAX_BPP];
+
+static const uint8_t *glyph_lookup(char c)
+{
+    const char *pos = (c != '\0') ? strchr(glyph_chars, c) : NULL;
+
+    return pos ? glyph_rows[pos - glyph_chars] : NULL;
+}
+
+static int display_fb_draw_char(uint8_t col, uint8_t row, char c)
+{
+    const uint8_t *glyph = glyph_lookup(c);
+    size_t pitch = CELL_WIDTH * display_bpp;
+
+    memset(cell_buf, 0, sizeof(cell_buf));
+
+    if (glyph) {
+        for (int gy = 0; gy < GLYPH_HEIGHT; gy++) {
+            for (int gx = 0; gx < GLYPH_WIDTH; gx++) {
+                if (!(glyph[gy] & BIT(GLYPH_WIDTH - 1 - gx))) {
+                    continue;
+                }
+                for (int sy = 0; sy < DISPLAY_FB_SCALE; sy++) {
+                    uint8_t *px = &cell_buf[(gy * DISPLAY_FB_SCALE + sy) * pitch +
+                                            gx * DISPLAY_FB_SCALE * display_bpp];
+
+                    memset(px, 0xFF, DISPLAY_FB_SCALE * display_bpp);
+                }
+            }
+        }
+    }
+
+    struct display_buffer_descriptor desc = {
+        .buf_size = CELL_WIDTH * CELL_HEIGHT * display_bpp,
+        .width = CELL_WIDTH,
+        .height = CELL_HEIGHT,
+        .pitch = CELL_WIDTH,
+    };
+
+    return display_write(display_dev, col * CELL_WIDTH, row * CELL_HEIGHT, &desc, cell_buf);
+}
+
+/* Redraw the cells of a field whose character changed; returns cells drawn */
+static int display_fb_update_field(struct display_field *field, const char *text)
+{
+    char padded[FIELD_MAX_WIDTH + 1];
+    int drawn = 0;
+
+    // Right aligned, so digits stay in place as the value changes
+    snprintf(padded, sizeof(padded), "%*s", field->width, text);
+
+    for (uint8_t i = 0; i < field->width; i++) {
+        if (padded[i] == field->shown[i]) {
+            continue;
+        }
+
+        int rc = display_fb_draw_char(field->col + i, field->row, padded[i]);
+        if (rc != 0) {
+            // Leave the cache stale so the cell is retried next time
+            field->shown[i] = '\0';
+            return rc;
+        }
+        field->shown[i] = padded[i];
+        drawn++;
+    }
+
+    return drawn;
+}
+
+/* Append the unit to a value of written characters, invalid values stay "n/a" */
+static void display_fb_unit(char *text, size_t len, size_t written, bool valid, const char *unit)
+{
+    if (valid) {
+        snprintf(text + written, len - written, "%s", unit);
+    }
+}
+
+static void display_fb_format(const struct sensor_data_msg *msg, enum display_field_id id,
+                              char *text, size_t len)
+{
+    switch (id) {
+    case FIELD_TEMPERATURE:
+        display_fb_unit(text, len, value_fmt_temperature(text, len, msg),
+                        !(msg->flags & SENSOR_FLAG_TEMP_INVALID), "C");
+        break;
+    case FIELD_HUMIDITY:
+        display_fb_unit(text, len, value_fmt_humidity(text, len, msg),
+                        !(msg->flags & SENSOR_FLAG_HUMIDITY_INVALID), "%");
+        break;
+    case FIELD_PRESSURE:
+        display_fb_unit(text, len, value_fmt_pressure(text, len, msg),
+                        !(msg->flags & SENSOR_FLAG_PRESSURE_INVALID), "Pa");
+        break;
+    case FIELD_STATUS:
+        snprintf(text, len, "%s", (msg->flags & SENSOR_FLAG_ERROR) ? "ERR" : "OK");
+        break;
+    default:
+        text[0] = '\0';
+        break;
+    }
+}
+
+int display_fb_render(const struct sensor_data_msg *msg)
+{
+    int fields = 0;
+
+    for (int id = 0; id < FIELD_COUNT; id++) {
+        char text[FIELD_MAX_WIDTH + 1];
+
+        display_fb_format(msg, id, text, sizeof(text));
+
+        int rc = display_fb_update_field(&display_fields[id], text);
+        if (rc < 0) {
+            return rc;
+        }
+        if (rc > 0) {
+            fields++;
+        }
+    }
+
+    return fields;
+}
+
+static int display_fb_select_format(const struct display_capabilities *caps)
+{
+    static const struct {
+        enum display_pixel_format format;
+        uint8_t bpp;
+    } formats[] = {
+        {PIXEL_FORMAT_RGB_565, 2},
+        {PIXEL_FORMAT_ARGB_8888, 4},
+        {PIXEL_FORMAT_RGB_888, 3},
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(formats); i++) {
+        if (caps->current_pixel_format == formats[i].format) {
+            display_bpp = formats[i].bpp;
+            return 0;
+        }
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(formats); i++) {
+        if ((caps->supported_pixel_formats & formats[i].format) &&
+            display_set_pixel_format(display_dev, formats[i].format) == 0) {
+            display_bpp = formats[i].bpp;
+            return 0;
+        }
+    }
+
+    return -ENOTSUP;
+}
+
+int display_fb_init(void)
+{
+    struct display_capabilities caps;
+
+    if (!device_is_ready(display_dev)) {
+        LOG_ERR("Display %s not ready", display_dev->name);
+        return -ENODEV;
+    }
+
+    display_get_capabilities(display_dev, &caps);
+
+    if (caps.x_resolution < LAYOUT_COLUMNS * CELL_WIDTH ||
+        caps.y_resolution < LAYOUT_ROWS * CELL_HEIGHT) {
+        LOG_ERR("Display %ux%u too small for the %ux%u layout", caps.x_resolution,
+                caps.y_resolution, LAYOUT_COLUMNS * CELL_WIDTH, LAYOUT_ROWS * CELL_HEIGHT);
+        return -ENOTSUP;
+    }
+
+    if (display_fb_select_format(&caps) != 0) {
+        LOG_ERR("No supported pixel format (0x%x)", caps.supported_pixel_formats);
+        return -ENOTSUP;
+    }
+
+    // Blank the layout area and draw the labels, values follow on first render
+    for (uint8_t row = 0; row < LAYOUT_ROWS; row++) {
+        const char *label = display_labels[row];
+        size_t label_len = strlen(label);
+
+        for (uint8_t col = 0; col < LAYOUT_COLUMNS; col++) {
+            int rc = display_fb_draw_char(col, row, (col < label_len) ? label[col] : ' ');
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    }
+
+    for (int id = 0; id < FIELD_COUNT; id++) {
+        memset(display_fields[id].shown, ' ', display_fields[id].width);
+        display_fields[id].shown[display_fields[id].width] = '\0';
+    }
+
+    display_blanking_off(display_dev);
+    LOG_INF("Display %s ready (%ux%u)", display_dev->name, caps.x_resolution,
+            caps.y_resolution);
+    return 0;
+}
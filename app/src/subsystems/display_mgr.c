@@ -7,26 +7,87 @@
 #include <zephyr/logging/log.h>
 #include <zephyr/zbus/zbus.h>
 #include "messages.h"
+#include "latency_stats.h"
+#include "display_fb.h"
+#include "pub_policy.h"
+#include "value_fmt.h"
 
 LOG_MODULE_REGISTER(display_mgr, CONFIG_WEATHER_STATION_LOG_LEVEL);
 
-static void display_mgr_sensor_data_handler(const struct zbus_channel *chan)
+PUB_SUBSCRIBER_DEFINE(display_mgr_sub);
+
+static bool display_ready;
+
+static void display_mgr_show(const struct sensor_data_msg *msg)
 {
-    const struct sensor_data_msg *msg = zbus_chan_const_msg(chan);
+    if (display_ready) {
+        int rc = display_fb_render(msg);
+        if (rc < 0) {
+            LOG_ERR("Display update failed: %d", rc);
+        }
+        return;
+    }
+
+    // Without a display the log is the output
+    char temp[VALUE_FMT_LEN], humidity[VALUE_FMT_LEN], pressure[VALUE_FMT_LEN];
+
+    value_fmt_temperature(temp, sizeof(temp), msg);
+    value_fmt_humidity(humidity, sizeof(humidity), msg);
+    value_fmt_pressure(pressure, sizeof(pressure), msg);
 
-    // Log the incoming sensor data (for native_sim, this acts as display output)
     LOG_INF("Sensor Data Received:");
-    LOG_INF("  Timestamp: %llu ms", msg->timestamp);
-    LOG_INF("  Temperature: %.1f°C", msg->temperature_c);
-    LOG_INF("  Humidity: %.1f%%", msg->humidity_percent);
-    LOG_INF("  Pressure: %.1f Pa", msg->pressure_pa);
-    LOG_INF("  Source: %s", (msg->source_flags & SENSOR_SOURCE_INTERNAL) ? "INTERNAL" : "EXTERNAL");
+    LOG_INF("  Timestamp: %u ms", msg->timestamp);
+    LOG_INF("  Temperature: %s°C", temp);
+    LOG_INF("  Humidity: %s%%", humidity);
+    LOG_INF("  Pressure: %s Pa", pressure);
+    LOG_INF("  Source: %s", (msg->flags & SENSOR_SOURCE_INTERNAL) ? "INTERNAL" : "EXTERNAL");
+    LOG_INF("  Sensor: %u", sensor_data_id(msg));
     LOG_INF("  Sequence: %u", msg->sequence);
-    LOG_INF("  Status: %d", msg->status);
+    LOG_INF("  Status: %s", (msg->flags & SENSOR_FLAG_ERROR) ? "ERROR" : "OK");
+}
+
+static void display_mgr_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    const struct zbus_channel *chan;
+    static struct sensor_batch_msg batch;
+    struct sensor_data_msg pending;
+    bool dirty = false;
+    int64_t next_refresh = 0;
+
+    if (IS_ENABLED(CONFIG_WEATHER_STATION_DISPLAY)) {
+        display_ready = (display_fb_init() == 0);
+    }
+
+    /*
+     * One wakeup per batch, only the newest sample is worth showing. Samples
+     * arriving faster than the refresh interval just replace the pending one,
+     * so rendering cost is bounded by the refresh rate, not the sample rate.
+     */
+    while (true) {
+        k_timeout_t timeout = dirty ? K_TIMEOUT_ABS_MS(next_refresh) : K_FOREVER;
+
+        if (pub_policy_wait(&display_mgr_sub, &chan, &batch, timeout) == 0 &&
+            chan == ZBUS_REF(ws_sensor_batch) && batch.count > 0) {
+            pending = batch.samples[batch.count - 1];
+            latency_stats_delivered(LATENCY_STAGE_DISPLAY, pending.sequence);
+            dirty = true;
+        }
+
+        if (dirty && k_uptime_get() >= next_refresh) {
+            display_mgr_show(&pending);
+            dirty = false;
+            next_refresh = k_uptime_get() + CONFIG_WEATHER_STATION_DISPLAY_REFRESH_MS;
+        }
+    }
 }
 
-ZBUS_LISTENER_DEFINE(display_mgr_listener,
-                    display_mgr_sensor_data_handler);
+K_THREAD_DEFINE(display_mgr_tid, CONFIG_WEATHER_STATION_DISPLAY_MGR_STACK_SIZE,
+                display_mgr_thread, NULL, NULL, NULL,
+                CONFIG_WEATHER_STATION_DISPLAY_MGR_PRIORITY, 0, 0);
 
 static int display_mgr_init(void)
 {
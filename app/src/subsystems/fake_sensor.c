@@ -4,24 +4,77 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#define DT_DRV_COMPAT ws_fake_sensor
+
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/sensor.h>
+#include <zephyr/rtio/rtio.h>
 #include <zephyr/sys/math_extras.h>
 #include <math.h>
 #include <stdio.h>
+#include "fake_sensor.h"
+#include "value_fmt.h"
+
+/* Nominal values and the swing used by the periodic waveforms */
+#define FAKE_TEMP_NOMINAL_C       22.5f
+#define FAKE_TEMP_SWING_C         5.0f
+#define FAKE_HUMIDITY_NOMINAL     45.0f
+#define FAKE_HUMIDITY_SWING       15.0f
+#define FAKE_PRESSURE_NOMINAL_PA  101325.0f
+#define FAKE_PRESSURE_SWING_PA    1000.0f
+
+#define FAKE_PI 3.14159265f
+
+/* Per-instance settings from devicetree */
+struct fake_sensor_dt_config {
+    uint8_t sensor_id;
+    enum fake_sensor_waveform waveform;
+    uint32_t seed;
+    uint32_t period;
+    uint32_t read_delay_ms;
+};
 
-/* Fake sensor device structure */
+/*
+ * Fake sensor device structure. Reads step the waveform from the calling
+ * thread or from the system work queue, and fill and configure from any
+ * thread, so the state below dev is only touched under lock.
+ */
 struct fake_sensor_data {
+    const struct device *dev;
+    struct k_spinlock lock;
     float temperature_c;
     float humidity_percent;
     float pressure_pa;
     uint32_t sequence;
     uint32_t prng_state; /* Simple pseudo-random number generator state */
+    uint32_t phase;      /* Sample index within the waveform period */
+    struct fake_sensor_config config;
+    struct k_work_delayable read_work;
+    atomic_ptr_t pending;   /* Delayed read waiting for read_work */
 };
 
-/* Fake sensor device instance */
-static struct fake_sensor_data fake_sensor;
+/* Copy of the values after a step, used outside the lock */
+struct fake_sensor_reading {
+    float temperature_c;
+    float humidity_percent;
+    float pressure_pa;
+    uint32_t sequence;
+    bool quiet;
+};
+
+/* Encoded reading as produced by submit and understood by the decoder */
+struct fake_sensor_frame {
+    uint64_t timestamp_ns;
+    int32_t temperature_milli_c;
+    int32_t humidity_milli_pct;
+    int32_t pressure_pa;
+};
+
+/* q31 shifts, chosen so every plausible reading fits: +-256 C, 128 %, 256 kPa */
+#define FAKE_TEMP_SHIFT     8
+#define FAKE_HUMIDITY_SHIFT 7
+#define FAKE_PRESSURE_SHIFT 8
 
 /* Simple pseudo-random number generator */
 static uint32_t simple_prng(uint32_t *state)
@@ -30,46 +83,157 @@ static uint32_t simple_prng(uint32_t *state)
     return *state;
 }
 
+/* Uniform value in [-1, 1] */
+static float prng_unit(uint32_t *state)
+{
+    return ((float)simple_prng(state) / (float)4294967295U) * 2.0f - 1.0f;
+}
+
+static void fake_sensor_random_walk(struct fake_sensor_data *data)
+{
+    /* Add small random variations to simulate real sensor behavior */
+    float temp_variation = prng_unit(&data->prng_state);
+    float humidity_variation = prng_unit(&data->prng_state) * 2.5f;
+    float pressure_variation = prng_unit(&data->prng_state) * 100.0f;
+
+    /* Apply variations with bounds checking */
+    data->temperature_c = fmaxf(15.0f, fminf(30.0f,
+        data->temperature_c + temp_variation * 0.1f));
+    data->humidity_percent = fmaxf(20.0f, fminf(80.0f,
+        data->humidity_percent + humidity_variation * 0.1f));
+    data->pressure_pa = fmaxf(95000.0f, fminf(105000.0f,
+        data->pressure_pa + pressure_variation));
+}
+
+/* Waveform value in [-1, 1] at the current phase */
+static float fake_sensor_shape(const struct fake_sensor_data *data)
+{
+    float pos = (float)data->phase / (float)data->config.period;
+
+    switch (data->config.waveform) {
+    case FAKE_SENSOR_WAVE_SINE:
+        return sinf(2.0f * FAKE_PI * pos);
+    case FAKE_SENSOR_WAVE_STEP:
+        return (pos < 0.5f) ? -1.0f : 1.0f;
+    case FAKE_SENSOR_WAVE_RAMP:
+    default:
+        return pos * 2.0f - 1.0f;
+    }
+}
+
+/* Advance the instance by one sample */
+static void fake_sensor_step(struct fake_sensor_data *data)
+{
+    if (data->config.waveform == FAKE_SENSOR_WAVE_RANDOM_WALK) {
+        fake_sensor_random_walk(data);
+    } else if (data->config.waveform == FAKE_SENSOR_WAVE_NOISE) {
+        data->temperature_c = FAKE_TEMP_NOMINAL_C +
+                              prng_unit(&data->prng_state) * FAKE_TEMP_SWING_C;
+        data->humidity_percent = FAKE_HUMIDITY_NOMINAL +
+                                 prng_unit(&data->prng_state) * FAKE_HUMIDITY_SWING;
+        data->pressure_pa = FAKE_PRESSURE_NOMINAL_PA +
+                            prng_unit(&data->prng_state) * FAKE_PRESSURE_SWING_PA;
+    } else {
+        float shape = fake_sensor_shape(data);
+
+        data->temperature_c = FAKE_TEMP_NOMINAL_C + shape * FAKE_TEMP_SWING_C;
+        data->humidity_percent = FAKE_HUMIDITY_NOMINAL + shape * FAKE_HUMIDITY_SWING;
+        data->pressure_pa = FAKE_PRESSURE_NOMINAL_PA + shape * FAKE_PRESSURE_SWING_PA;
+    }
+
+    data->phase = (data->phase + 1U) % data->config.period;
+    data->sequence++;
+}
+
+/* Step the instance and take the resulting values */
+static void fake_sensor_next(struct fake_sensor_data *data, struct fake_sensor_reading *reading)
+{
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+    fake_sensor_step(data);
+    *reading = (struct fake_sensor_reading){
+        .temperature_c = data->temperature_c,
+        .humidity_percent = data->humidity_percent,
+        .pressure_pa = data->pressure_pa,
+        .sequence = data->sequence,
+        .quiet = data->config.quiet,
+    };
+    k_spin_unlock(&data->lock, key);
+}
+
+/* Values at 0.1 resolution, rendered without floating-point printf */
+static void fake_sensor_print(const struct fake_sensor_dt_config *cfg,
+                              const struct fake_sensor_reading *data, const char *what)
+{
+    char temp[VALUE_FMT_LEN], humidity[VALUE_FMT_LEN], pressure[VALUE_FMT_LEN];
+
+    value_fmt_fixed(temp, sizeof(temp),
+                    sensor_data_to_fixed(data->temperature_c * 10.0f, INT32_MIN, INT32_MAX), 1);
+    value_fmt_fixed(humidity, sizeof(humidity),
+                    sensor_data_to_fixed(data->humidity_percent * 10.0f, INT32_MIN, INT32_MAX), 1);
+    value_fmt_fixed(pressure, sizeof(pressure),
+                    sensor_data_to_fixed(data->pressure_pa * 10.0f, INT32_MIN, INT32_MAX), 1);
+
+    printk("Fake sensor %u %s: T=%s°C, H=%s%%, P=%s Pa (seq=%u)\n", cfg->sensor_id, what,
+           temp, humidity, pressure, data->sequence);
+}
+
+static void fake_sensor_read_work(struct k_work *work);
+
 /* Initialize fake sensor with realistic values */
 static int fake_sensor_init(const struct device *dev)
 {
-    ARG_UNUSED(dev);
+    const struct fake_sensor_dt_config *cfg = dev->config;
+    struct fake_sensor_data *data = dev->data;
 
     /* Set initial values */
-    fake_sensor.temperature_c = 22.5f;  /* Room temperature */
-    fake_sensor.humidity_percent = 45.0f; /* Comfortable humidity */
-    fake_sensor.pressure_pa = 101325.0f; /* Standard atmospheric pressure */
-    fake_sensor.sequence = 0;
-    fake_sensor.prng_state = 42; /* Seed for PRNG */
+    data->dev = dev;
+    data->temperature_c = FAKE_TEMP_NOMINAL_C;  /* Room temperature */
+    data->humidity_percent = FAKE_HUMIDITY_NOMINAL; /* Comfortable humidity */
+    data->pressure_pa = FAKE_PRESSURE_NOMINAL_PA; /* Standard atmospheric pressure */
+    data->sequence = 0;
+    data->phase = 0;
+    data->prng_state = cfg->seed; /* Seed for PRNG */
+    data->config.waveform = cfg->waveform;
+    data->config.seed = cfg->seed;
+    data->config.period = cfg->period;
+    data->config.quiet = IS_ENABLED(CONFIG_WEATHER_STATION_FAKE_SENSOR_QUIET);
+    atomic_ptr_clear(&data->pending);
+    k_work_init_delayable(&data->read_work, fake_sensor_read_work);
 
-    printk("Fake sensor initialized: T=%.1f°C, H=%.1f%%, P=%.1f Pa\n",
-           fake_sensor.temperature_c, fake_sensor.humidity_percent,
-           fake_sensor.pressure_pa);
+    if (!data->config.quiet) {
+        struct fake_sensor_reading reading = {
+            .temperature_c = data->temperature_c,
+            .humidity_percent = data->humidity_percent,
+            .pressure_pa = data->pressure_pa,
+        };
+
+        fake_sensor_print(cfg, &reading, "initialized");
+    }
 
     return 0;
 }
 
+/* Take one reading, printing it unless the instance is quiet */
+static void fake_sensor_take(const struct device *dev, struct fake_sensor_reading *reading)
+{
+    const struct fake_sensor_dt_config *cfg = dev->config;
+
+    fake_sensor_next(dev->data, reading);
+
+    if (!reading->quiet) {
+        fake_sensor_print(cfg, reading, "sampled");
+    }
+}
+
 /* Simulate sensor reading with small variations */
 static int fake_sensor_sample_fetch(const struct device *dev, enum sensor_channel chan)
 {
-    /* Add small random variations to simulate real sensor behavior */
-    float temp_variation = ((float)simple_prng(&fake_sensor.prng_state) / (float)4294967295U) * 2.0f - 1.0f;
-    float humidity_variation = ((float)simple_prng(&fake_sensor.prng_state) / (float)4294967295U) * 5.0f - 2.5f;
-    float pressure_variation = ((float)simple_prng(&fake_sensor.prng_state) / (float)4294967295U) * 200.0f - 100.0f;
+    struct fake_sensor_reading reading;
 
-    /* Apply variations with bounds checking */
-    fake_sensor.temperature_c = fmaxf(15.0f, fminf(30.0f,
-        fake_sensor.temperature_c + temp_variation * 0.1f));
-    fake_sensor.humidity_percent = fmaxf(20.0f, fminf(80.0f,
-        fake_sensor.humidity_percent + humidity_variation * 0.1f));
-    fake_sensor.pressure_pa = fmaxf(95000.0f, fminf(105000.0f,
-        fake_sensor.pressure_pa + pressure_variation));
-
-    fake_sensor.sequence++;
+    ARG_UNUSED(chan);
 
-    printk("Fake sensor sampled: T=%.1f°C, H=%.1f%%, P=%.1f Pa (seq=%u)\n",
-           fake_sensor.temperature_c, fake_sensor.humidity_percent,
-           fake_sensor.pressure_pa, fake_sensor.sequence);
+    fake_sensor_take(dev, &reading);
 
     return 0;
 }
@@ -78,43 +242,293 @@ static int fake_sensor_sample_fetch(const struct device *dev, enum sensor_channe
 static int fake_sensor_channel_get(const struct device *dev, enum sensor_channel chan,
                                  struct sensor_value *val)
 {
+    struct fake_sensor_data *data = dev->data;
+    float value;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+
     switch (chan) {
         case SENSOR_CHAN_AMBIENT_TEMP:
-            sensor_value_from_double(val, fake_sensor.temperature_c);
+            value = data->temperature_c;
             break;
         case SENSOR_CHAN_HUMIDITY:
-            sensor_value_from_double(val, fake_sensor.humidity_percent);
+            value = data->humidity_percent;
             break;
         case SENSOR_CHAN_PRESS:
-            sensor_value_from_double(val, fake_sensor.pressure_pa);
+            value = data->pressure_pa;
             break;
         default:
+            k_spin_unlock(&data->lock, key);
             return -ENOTSUP;
     }
+    k_spin_unlock(&data->lock, key);
+
+    sensor_value_from_double(val, value);
 
     return 0;
 }
 
+/* Scale value / divisor to a q31 number with the given shift */
+static q31_t fake_sensor_to_q31(int64_t value, int64_t divisor, int8_t shift)
+{
+    return (q31_t)CLAMP((value * (1LL << (31 - shift))) / divisor, INT32_MIN, INT32_MAX);
+}
+
+static int fake_sensor_decoder_get_frame_count(const uint8_t *buffer,
+                                               struct sensor_chan_spec chan_spec,
+                                               uint16_t *frame_count)
+{
+    ARG_UNUSED(buffer);
+
+    if (chan_spec.chan_idx != 0) {
+        return -ENOTSUP;
+    }
+
+    switch (chan_spec.chan_type) {
+    case SENSOR_CHAN_AMBIENT_TEMP:
+    case SENSOR_CHAN_HUMIDITY:
+    case SENSOR_CHAN_PRESS:
+        *frame_count = 1;
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static int fake_sensor_decoder_get_size_info(struct sensor_chan_spec chan_spec,
+                                             size_t *base_size, size_t *frame_size)
+{
+    switch (chan_spec.chan_type) {
+    case SENSOR_CHAN_AMBIENT_TEMP:
+    case SENSOR_CHAN_HUMIDITY:
+    case SENSOR_CHAN_PRESS:
+        *base_size = sizeof(struct sensor_q31_data);
+        *frame_size = sizeof(struct sensor_q31_sample_data);
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static int fake_sensor_decoder_decode(const uint8_t *buffer, struct sensor_chan_spec chan_spec,
+                                      uint32_t *fit, uint16_t max_count, void *data_out)
+{
+    const struct fake_sensor_frame *frame = (const struct fake_sensor_frame *)buffer;
+    struct sensor_q31_data *out = data_out;
+
+    // A frame holds a single reading per channel
+    if (*fit != 0 || max_count == 0 || chan_spec.chan_idx != 0) {
+        return 0;
+    }
+
+    switch (chan_spec.chan_type) {
+    case SENSOR_CHAN_AMBIENT_TEMP:
+        out->shift = FAKE_TEMP_SHIFT;
+        out->readings[0].value = fake_sensor_to_q31(frame->temperature_milli_c, 1000,
+                                                    FAKE_TEMP_SHIFT);
+        break;
+    case SENSOR_CHAN_HUMIDITY:
+        out->shift = FAKE_HUMIDITY_SHIFT;
+        out->readings[0].value = fake_sensor_to_q31(frame->humidity_milli_pct, 1000,
+                                                    FAKE_HUMIDITY_SHIFT);
+        break;
+    case SENSOR_CHAN_PRESS:
+        // Pressure channel unit is kPa
+        out->shift = FAKE_PRESSURE_SHIFT;
+        out->readings[0].value = fake_sensor_to_q31(frame->pressure_pa, 1000,
+                                                    FAKE_PRESSURE_SHIFT);
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    out->header.base_timestamp_ns = frame->timestamp_ns;
+    out->header.reading_count = 1;
+    out->readings[0].timestamp_delta = 0;
+    *fit = 1;
+
+    return 1;
+}
+
+static bool fake_sensor_decoder_has_trigger(const uint8_t *buffer,
+                                            enum sensor_trigger_type trigger)
+{
+    ARG_UNUSED(buffer);
+    ARG_UNUSED(trigger);
+
+    return false;
+}
+
+static const struct sensor_decoder_api fake_sensor_decoder = {
+    .get_frame_count = fake_sensor_decoder_get_frame_count,
+    .get_size_info = fake_sensor_decoder_get_size_info,
+    .decode = fake_sensor_decoder_decode,
+    .has_trigger = fake_sensor_decoder_has_trigger,
+};
+
+static int fake_sensor_get_decoder(const struct device *dev,
+                                   const struct sensor_decoder_api **decoder)
+{
+    ARG_UNUSED(dev);
+
+    *decoder = &fake_sensor_decoder;
+    return 0;
+}
+
+/* Take a reading into the read buffer and complete the request */
+static void fake_sensor_complete(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe)
+{
+    struct fake_sensor_reading reading;
+    uint8_t *buf;
+    uint32_t buf_len;
+
+    int rc = rtio_sqe_rx_buf(iodev_sqe, sizeof(struct fake_sensor_frame),
+                             sizeof(struct fake_sensor_frame), &buf, &buf_len);
+    if (rc != 0) {
+        rtio_iodev_sqe_err(iodev_sqe, rc);
+        return;
+    }
+
+    fake_sensor_take(dev, &reading);
+
+    struct fake_sensor_frame *frame = (struct fake_sensor_frame *)buf;
+
+    frame->timestamp_ns = k_ticks_to_ns_floor64(k_uptime_ticks());
+    frame->temperature_milli_c = (int32_t)(reading.temperature_c * 1000.0f);
+    frame->humidity_milli_pct = (int32_t)(reading.humidity_percent * 1000.0f);
+    frame->pressure_pa = (int32_t)reading.pressure_pa;
+
+    rtio_iodev_sqe_ok(iodev_sqe, 0);
+}
+
+static void fake_sensor_read_work(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct fake_sensor_data *data = CONTAINER_OF(dwork, struct fake_sensor_data, read_work);
+    struct rtio_iodev_sqe *iodev_sqe = atomic_ptr_set(&data->pending, NULL);
+
+    if (iodev_sqe != NULL) {
+        fake_sensor_complete(data->dev, iodev_sqe);
+    }
+}
+
+/*
+ * Asynchronous read. Without a read delay it completes inline, which is
+ * what a sensor with data ready in registers does; otherwise it completes
+ * from the system work queue once the delay has passed, like a conversion
+ * on a slow bus. Either way the caller only sees the completion. One
+ * delayed read can be pending per instance.
+ */
+static void fake_sensor_submit(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe)
+{
+    const struct fake_sensor_dt_config *cfg = dev->config;
+    struct fake_sensor_data *data = dev->data;
+
+    if (cfg->read_delay_ms == 0) {
+        fake_sensor_complete(dev, iodev_sqe);
+        return;
+    }
+
+    if (!atomic_ptr_cas(&data->pending, NULL, iodev_sqe)) {
+        rtio_iodev_sqe_err(iodev_sqe, -EBUSY);
+        return;
+    }
+
+    k_work_schedule(&data->read_work, K_MSEC(cfg->read_delay_ms));
+}
+
 /* Fake sensor driver API */
 static const struct sensor_driver_api fake_sensor_api = {
     .sample_fetch = fake_sensor_sample_fetch,
     .channel_get = fake_sensor_channel_get,
+    .get_decoder = fake_sensor_get_decoder,
+    .submit = fake_sensor_submit,
 };
 
-/* Fake sensor device definition */
-DEVICE_DEFINE(fake_sensor, "FAKE_SENSOR", fake_sensor_init, NULL, NULL, NULL,
-             POST_KERNEL, CONFIG_SENSOR_INIT_PRIORITY, &fake_sensor_api);
+/* Fake sensor device definition, one per enabled devicetree node */
+#define FAKE_SENSOR_DEFINE(inst)                                                        \
+    BUILD_ASSERT(DT_INST_PROP(inst, sensor_id) <= SENSOR_ID_MAX,                        \
+                 "sensor-id must fit in the sample flags");                             \
+    BUILD_ASSERT(DT_INST_PROP(inst, period) > 0, "period must not be 0");               \
+                                                                                        \
+    static struct fake_sensor_data fake_sensor_data_##inst;                             \
+                                                                                        \
+    static const struct fake_sensor_dt_config fake_sensor_config_##inst = {             \
+        .sensor_id = DT_INST_PROP(inst, sensor_id),                                     \
+        .waveform = (enum fake_sensor_waveform)DT_INST_ENUM_IDX(inst, waveform),        \
+        .seed = DT_INST_PROP_OR(inst, seed, CONFIG_WEATHER_STATION_FAKE_SENSOR_SEED +   \
+                                            DT_INST_PROP(inst, sensor_id)),             \
+        .period = DT_INST_PROP(inst, period),                                           \
+        .read_delay_ms = DT_INST_PROP(inst, read_delay_ms),                             \
+    };                                                                                  \
+                                                                                        \
+    SENSOR_DEVICE_DT_INST_DEFINE(inst, fake_sensor_init, NULL, &fake_sensor_data_##inst, \
+                                 &fake_sensor_config_##inst, POST_KERNEL,               \
+                                 CONFIG_SENSOR_INIT_PRIORITY, &fake_sensor_api);
+
+DT_INST_FOREACH_STATUS_OKAY(FAKE_SENSOR_DEFINE)
+
+int fake_sensor_configure(const struct device *dev, const struct fake_sensor_config *cfg)
+{
+    if (!dev || !cfg || cfg->period == 0 || cfg->waveform > FAKE_SENSOR_WAVE_NOISE) {
+        return -EINVAL;
+    }
+
+    struct fake_sensor_data *data = dev->data;
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+    data->config = *cfg;
+    data->phase = 0;
+    if (cfg->seed != 0) {
+        data->prng_state = cfg->seed;
+    }
+    k_spin_unlock(&data->lock, key);
+
+    return 0;
+}
+
+int fake_sensor_fill(const struct device *dev, struct sensor_data_msg *samples, size_t count)
+{
+    if (!dev || (!samples && count > 0)) {
+        return -EINVAL;
+    }
+
+    const struct fake_sensor_dt_config *cfg = dev->config;
+    struct fake_sensor_data *data = dev->data;
+    uint32_t now = k_uptime_get_32();
+
+    for (size_t i = 0; i < count; i++) {
+        struct fake_sensor_reading reading;
+
+        fake_sensor_next(data, &reading);
+
+        samples[i] = (struct sensor_data_msg) {
+            .timestamp = now,
+            .sequence = (uint16_t)reading.sequence,
+            .flags = SENSOR_SOURCE_INTERNAL | sensor_id_flags(cfg->sensor_id)
+        };
+        sensor_data_from_float(&samples[i], reading.temperature_c, reading.humidity_percent,
+                               reading.pressure_pa);
+    }
+
+    return 0;
+}
 
 /* Public API to get fake sensor data */
-int fake_sensor_get_readings(float *temperature, float *humidity, float *pressure)
+int fake_sensor_get_readings(const struct device *dev, float *temperature, float *humidity,
+                             float *pressure)
 {
-    if (!temperature || !humidity || !pressure) {
+    if (!dev || !temperature || !humidity || !pressure) {
         return -EINVAL;
     }
 
-    *temperature = fake_sensor.temperature_c;
-    *humidity = fake_sensor.humidity_percent;
-    *pressure = fake_sensor.pressure_pa;
+    struct fake_sensor_data *data = dev->data;
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+    *temperature = data->temperature_c;
+    *humidity = data->humidity_percent;
+    *pressure = data->pressure_pa;
+    k_spin_unlock(&data->lock, key);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,709 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <zephyr/fs/fcb.h>
+#include <zephyr/storage/flash_map.h>
+#include <string.h>
+#include "messages.h"
+#include "sample_codec.h"
+#include "block_index.h"
+#include "flash_log.h"
+#include "pub_policy.h"
+#include "sensor_mgr.h"
+
+LOG_MODULE_REGISTER(flash_log, CONFIG_WEATHER_STATION_LOG_LEVEL);
+
+#define FLASH_LOG_AREA_ID   FIXED_PARTITION_ID(storage_partition)
+#define FLASH_LOG_MAGIC     0x474c5357  /* "WSLG" */
+#define FLASH_LOG_VERSION   2
+
+/* Largest flash write block size a block can be padded to */
+#define FLASH_LOG_ALIGN_MAX 16
+
+#define FLASH_LOG_PAYLOAD_SIZE \
+    (CONFIG_WEATHER_STATION_FLASH_LOG_BLOCK_SIZE - sizeof(struct flash_log_block_hdr))
+
+BUILD_ASSERT(FLASH_LOG_PAYLOAD_SIZE >= SAMPLE_CODEC_HDR_SIZE + SAMPLE_CODEC_MAX_SAMPLE_SIZE,
+             "Flash log block too small for two samples");
+
+struct flash_log_block {
+    struct flash_log_block_hdr hdr;
+    uint8_t payload[FLASH_LOG_PAYLOAD_SIZE];
+    uint8_t pad[FLASH_LOG_ALIGN_MAX];
+};
+
+static struct flash_sector flash_log_sectors[CONFIG_WEATHER_STATION_FLASH_LOG_MAX_SECTORS];
+static struct fcb flash_log_fcb;
+/* One entry per sector holding blocks, with the time range of its blocks */
+BLOCK_INDEX_DEFINE(flash_log_index, CONFIG_WEATHER_STATION_FLASH_LOG_MAX_SECTORS);
+
+/* The thread appends, the shell reads and clears */
+static K_MUTEX_DEFINE(flash_log_lock);
+
+/* Serialises readers, which share the read buffer */
+static K_MUTEX_DEFINE(flash_log_read_lock);
+static struct flash_log_block flash_log_read_buf;
+
+static struct flash_log_block flash_log_block;
+static struct sample_codec_encoder flash_log_encoder;
+static int64_t flash_log_deadline;
+static uint32_t flash_log_next_sequence;
+static uint64_t flash_log_time_base;
+static struct flash_log_block_hdr flash_log_newest;
+static bool flash_log_has_blocks;
+static bool flash_log_ready;
+
+static struct {
+    uint32_t blocks_written;
+    uint32_t bytes_written;
+    uint32_t sectors_erased;
+    uint32_t write_errors;
+    uint32_t recovery_blocks;
+    uint32_t recovery_us;
+    uint32_t index_us;
+} flash_log_stats;
+
+PUB_SUBSCRIBER_DEFINE(flash_log_sub);
+
+/* 0 for a sample block, -ENODATA for a marker, -EBADMSG or a read error otherwise */
+static int flash_log_read_hdr(const struct flash_area *fap, const struct fcb_entry *loc,
+                              struct flash_log_block_hdr *hdr)
+{
+    uint8_t prefix[LOG_BLOCK_PREFIX_SIZE];
+    uint32_t len = MIN(loc->fe_data_len, sizeof(prefix));
+
+    int rc = flash_area_read(fap, FCB_ENTRY_FA_DATA_OFF((*loc)), prefix, len);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return log_block_check(prefix, len, loc->fe_data_len, hdr);
+}
+
+static uint8_t flash_log_sector_id(const struct flash_sector *sector)
+{
+    return (uint8_t)(sector - flash_log_sectors);
+}
+
+/* Blocks written to the newest indexed sector extend its range, else the sector is added */
+static void flash_log_index_add(const struct flash_log_block_hdr *hdr,
+                                const struct fcb_entry *loc)
+{
+    uint8_t sector = flash_log_sector_id(loc->fe_sector);
+    struct block_index_entry newest;
+
+    if (block_index_get(&flash_log_index, flash_log_index.head - 1, &newest) &&
+        newest.sector == sector) {
+        block_index_extend(&flash_log_index, hdr->last_time);
+        return;
+    }
+
+    struct block_index_entry entry = {
+        .first_time = hdr->first_time,
+        .last_time = hdr->last_time,
+        .offset = loc->fe_sector->fs_off,
+        .sector = sector,
+    };
+
+    block_index_push(&flash_log_index, &entry);
+}
+
+/* Append one entry, dropping the oldest sector when the log is full */
+static int flash_log_append(const void *data, uint16_t len, struct fcb_entry *loc)
+{
+    int rc = fcb_append(&flash_log_fcb, len, loc);
+    if (rc == -ENOSPC) {
+        uint8_t oldest = flash_log_sector_id(flash_log_fcb.f_oldest);
+
+        rc = fcb_rotate(&flash_log_fcb);
+        if (rc != 0) {
+            return rc;
+        }
+        flash_log_stats.sectors_erased++;
+        block_index_drop_sector(&flash_log_index, oldest);
+        rc = fcb_append(&flash_log_fcb, len, loc);
+    }
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = flash_area_write(flash_log_fcb.fap, FCB_ENTRY_FA_DATA_OFF((*loc)), data, len);
+    if (rc != 0) {
+        // Without its CRC the entry is skipped on read
+        return rc;
+    }
+
+    return fcb_append_finish(&flash_log_fcb, loc);
+}
+
+static void flash_log_write_block(void)
+{
+    struct flash_log_block_hdr *hdr = &flash_log_block.hdr;
+
+    if (hdr->count == 0) {
+        return;
+    }
+
+    size_t len = sizeof(*hdr) + sample_codec_finish(&flash_log_encoder);
+
+    hdr->sequence = flash_log_next_sequence++;
+    hdr->format = FLASH_LOG_FORMAT_CODEC;
+    hdr->reserved = 0;
+
+    // Pad to the write block size, the count tells readers where data ends
+    len = ROUND_UP(len, flash_log_fcb.f_align);
+
+    struct fcb_entry loc;
+
+    int rc = flash_log_append(&flash_log_block, (uint16_t)len, &loc);
+    if (rc == 0) {
+        flash_log_index_add(hdr, &loc);
+        flash_log_newest = *hdr;
+        flash_log_has_blocks = true;
+        flash_log_stats.blocks_written++;
+        flash_log_stats.bytes_written += len;
+    } else {
+        flash_log_stats.write_errors++;
+        LOG_ERR("Failed to write block %u: %d", hdr->sequence, rc);
+    }
+
+    hdr->count = 0;
+}
+
+/* Log time of a sample, whose 32-bit uptime stamp wraps after 49.7 days */
+static uint64_t flash_log_time(uint32_t timestamp)
+{
+    int64_t now = k_uptime_get();
+    uint32_t age = (uint32_t)now - timestamp;
+
+    return flash_log_time_base + (uint64_t)now - age;
+}
+
+static void flash_log_add(const struct sensor_data_msg *msg)
+{
+    struct flash_log_block_hdr *hdr = &flash_log_block.hdr;
+    struct sample_record rec = {
+        .time = flash_log_time(msg->timestamp),
+        .temperature_centi_c = msg->temperature_centi_c,
+        .humidity_deci_pct = msg->humidity_deci_pct,
+        .pressure_pa_off = msg->pressure_pa_off,
+        .flags = msg->flags,
+    };
+
+    // The block is written when the next sample no longer fits
+    if (hdr->count > 0 && sample_codec_encode(&flash_log_encoder, &rec) == 0) {
+        hdr->count++;
+        hdr->last_time = rec.time;
+        return;
+    }
+
+    flash_log_write_block();
+
+    sample_codec_encoder_init(&flash_log_encoder, flash_log_block.payload,
+                              sizeof(flash_log_block.payload));
+    sample_codec_encode(&flash_log_encoder, &rec);
+    hdr->count = 1;
+    hdr->first_time = rec.time;
+    hdr->last_time = rec.time;
+    flash_log_deadline = k_uptime_get() + CONFIG_WEATHER_STATION_FLASH_LOG_FLUSH_MS;
+}
+
+static int flash_log_scan_entry(struct fcb_entry_ctx *ctx, void *arg)
+{
+    uint8_t prefix[LOG_BLOCK_PREFIX_SIZE];
+    uint32_t len = MIN(ctx->loc.fe_data_len, sizeof(prefix));
+
+    if (flash_area_read(ctx->fap, FCB_ENTRY_FA_DATA_OFF(ctx->loc), prefix, len) != 0) {
+        len = 0;
+    }
+    log_block_scan_add(arg, prefix, len, ctx->loc.fe_data_len);
+
+    return 0;
+}
+
+static int flash_log_erase_area(void)
+{
+    const struct flash_area *fap;
+
+    int rc = flash_area_open(FLASH_LOG_AREA_ID, &fap);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = flash_area_erase(fap, 0, fap->fa_size);
+    flash_area_close(fap);
+    return rc;
+}
+
+/*
+ * fcb_init() finds the oldest and the active sector from the sector
+ * headers and the end of the active sector, so only the active sector is
+ * walked here to find the newest block. Older sectors are only visited if
+ * a reset left the active one without a complete block.
+ */
+static int flash_log_recover(void)
+{
+    uint32_t start = k_cycle_get_32();
+    uint32_t count = ARRAY_SIZE(flash_log_sectors);
+    struct log_block_scan scan;
+
+    log_block_scan_init(&scan);
+
+    int rc = flash_area_get_sectors(FLASH_LOG_AREA_ID, &count, flash_log_sectors);
+    if (rc != 0) {
+        LOG_ERR("Cannot get the storage sectors: %d", rc);
+        return rc;
+    }
+
+    flash_log_fcb.f_magic = FLASH_LOG_MAGIC;
+    flash_log_fcb.f_version = FLASH_LOG_VERSION;
+    flash_log_fcb.f_sector_cnt = (uint8_t)count;
+    flash_log_fcb.f_scratch_cnt = 0;
+    flash_log_fcb.f_sectors = flash_log_sectors;
+
+    rc = fcb_init(FLASH_LOG_AREA_ID, &flash_log_fcb);
+    if (rc != 0) {
+        LOG_WRN("No sample log on the storage partition (%d), erasing it", rc);
+        rc = flash_log_erase_area();
+        if (rc == 0) {
+            rc = fcb_init(FLASH_LOG_AREA_ID, &flash_log_fcb);
+        }
+        if (rc != 0) {
+            LOG_ERR("Cannot initialize the sample log: %d", rc);
+            return rc;
+        }
+    }
+
+    if (flash_log_fcb.f_align > FLASH_LOG_ALIGN_MAX) {
+        LOG_ERR("Unsupported flash write block size %u", flash_log_fcb.f_align);
+        return -ENOTSUP;
+    }
+
+    uint32_t active = flash_log_fcb.f_active.fe_sector - flash_log_sectors;
+
+    for (uint32_t i = 0; i < count && !scan.found; i++) {
+        struct flash_sector *sector = &flash_log_sectors[(active + count - i) % count];
+
+        rc = fcb_walk(&flash_log_fcb, sector, flash_log_scan_entry, &scan);
+        if (rc != 0 || sector == flash_log_fcb.f_oldest) {
+            break;
+        }
+    }
+
+    // The newest block may be the marker of a cleared log
+    log_block_scan_resume(&scan, &flash_log_next_sequence, &flash_log_time_base);
+    if (log_block_scan_has_samples(&scan)) {
+        flash_log_newest = scan.newest;
+        flash_log_has_blocks = true;
+    }
+    if (scan.invalid > 0) {
+        LOG_WRN("Skipped %u entries that are not blocks", scan.invalid);
+    }
+
+    flash_log_stats.recovery_blocks = scan.blocks;
+    flash_log_stats.recovery_us = k_cyc_to_us_ceil32(k_cycle_get_32() - start);
+
+    if (scan.found) {
+        LOG_INF("Sample log recovered: block %u, log time %llu ms (%u blocks read in %u us)",
+                scan.newest.sequence, (unsigned long long)scan.newest.last_time, scan.blocks,
+                flash_log_stats.recovery_us);
+    } else {
+        LOG_INF("Sample log is empty (%u sectors of %u bytes)", count,
+                flash_log_sectors[0].fs_size);
+    }
+
+    return 0;
+}
+
+/* Sectors from the oldest to the active one */
+static uint32_t flash_log_used_sectors(void)
+{
+    uint32_t count = flash_log_fcb.f_sector_cnt;
+    uint32_t oldest = flash_log_fcb.f_oldest - flash_log_sectors;
+    uint32_t active = flash_log_fcb.f_active.fe_sector - flash_log_sectors;
+
+    return (active + count - oldest) % count + 1;
+}
+
+/* Sectors a sector is past the oldest one, it survives that many erases */
+static uint32_t flash_log_sector_age(const struct flash_sector *sector)
+{
+    uint32_t count = flash_log_fcb.f_sector_cnt;
+    uint32_t oldest = flash_log_fcb.f_oldest - flash_log_sectors;
+
+    return (flash_log_sector_id(sector) + count - oldest) % count;
+}
+
+/* Index the first block of a sector, the range of the sector before ends there */
+static int flash_log_index_sector(struct fcb_entry_ctx *ctx, void *arg)
+{
+    struct flash_log_block_hdr hdr;
+    int rc = flash_log_read_hdr(ctx->fap, &ctx->loc, &hdr);
+
+    ARG_UNUSED(arg);
+    if (rc != 0 && rc != -ENODATA) {
+        return 0;
+    }
+
+    block_index_extend(&flash_log_index, hdr.first_time);
+    flash_log_index_add(&hdr, &ctx->loc);
+    return 1;
+}
+
+/*
+ * Queries start reading at the sector found by binary search over the time
+ * range of each sector. Blocks are in time order, so a sector ends before
+ * the first block of the next one and only that block is read here: boot
+ * reads one entry per sector whatever the log size. Written blocks keep the
+ * range of the newest sector up to date.
+ */
+static void flash_log_build_index(void)
+{
+    uint32_t start = k_cycle_get_32();
+    uint32_t count = flash_log_fcb.f_sector_cnt;
+    uint32_t oldest = flash_log_fcb.f_oldest - flash_log_sectors;
+    uint32_t used = flash_log_used_sectors();
+
+    block_index_reset(&flash_log_index);
+    for (uint32_t i = 0; i < used; i++) {
+        (void)fcb_walk(&flash_log_fcb, &flash_log_sectors[(oldest + i) % count],
+                       flash_log_index_sector, NULL);
+    }
+
+    // The recovery scan found the end of the newest sector
+    if (flash_log_has_blocks) {
+        block_index_extend(&flash_log_index, flash_log_newest.last_time);
+    }
+
+    flash_log_stats.index_us = k_cyc_to_us_ceil32(k_cycle_get_32() - start);
+    LOG_INF("Query index holds %u sectors (built in %u us)",
+            block_index_count(&flash_log_index), flash_log_stats.index_us);
+}
+
+int flash_log_get_info(struct flash_log_info *info)
+{
+    memset(info, 0, sizeof(*info));
+
+    k_mutex_lock(&flash_log_lock, K_FOREVER);
+    if (!flash_log_ready) {
+        k_mutex_unlock(&flash_log_lock);
+        return -EAGAIN;
+    }
+
+    info->ready = true;
+    info->sector_count = flash_log_fcb.f_sector_cnt;
+    info->sector_size = flash_log_sectors[0].fs_size;
+    info->pending = flash_log_block.hdr.count;
+    info->blocks_written = flash_log_stats.blocks_written;
+    info->bytes_written = flash_log_stats.bytes_written;
+    info->sectors_erased = flash_log_stats.sectors_erased;
+    info->write_errors = flash_log_stats.write_errors;
+    info->recovery_blocks = flash_log_stats.recovery_blocks;
+    info->recovery_us = flash_log_stats.recovery_us;
+    info->index_sectors = block_index_count(&flash_log_index);
+    info->index_us = flash_log_stats.index_us;
+
+    if (flash_log_has_blocks) {
+        struct fcb_entry loc = {0};
+        struct flash_log_block_hdr hdr;
+
+        info->used_sectors = flash_log_used_sectors();
+        info->newest_sequence = flash_log_newest.sequence;
+        info->newest_time = flash_log_newest.last_time;
+
+        // The first readable block from the oldest sector
+        while (fcb_getnext(&flash_log_fcb, &loc) == 0) {
+            if (flash_log_read_hdr(flash_log_fcb.fap, &loc, &hdr) == 0) {
+                info->has_blocks = true;
+                info->oldest_sequence = hdr.sequence;
+                info->oldest_time = hdr.first_time;
+                break;
+            }
+        }
+    }
+    k_mutex_unlock(&flash_log_lock);
+
+    return 0;
+}
+
+int flash_log_flush(void)
+{
+    k_mutex_lock(&flash_log_lock, K_FOREVER);
+    if (!flash_log_ready) {
+        k_mutex_unlock(&flash_log_lock);
+        return -EAGAIN;
+    }
+
+    uint32_t errors = flash_log_stats.write_errors;
+
+    flash_log_write_block();
+    int rc = (flash_log_stats.write_errors != errors) ? -EIO : 0;
+    k_mutex_unlock(&flash_log_lock);
+
+    return rc;
+}
+
+/* Keep the sequence number and log time in a block without samples */
+static int flash_log_write_marker(void)
+{
+    uint8_t buf[ROUND_UP(sizeof(struct flash_log_block_hdr), FLASH_LOG_ALIGN_MAX)] = {0};
+    struct flash_log_block_hdr hdr = {
+        .sequence = flash_log_next_sequence++,
+        .first_time = flash_log_now(),
+        .format = FLASH_LOG_FORMAT_MARK,
+    };
+    struct fcb_entry loc;
+
+    hdr.last_time = hdr.first_time;
+    memcpy(buf, &hdr, sizeof(hdr));
+
+    int rc = flash_log_append(buf, (uint16_t)ROUND_UP(sizeof(hdr), flash_log_fcb.f_align), &loc);
+    if (rc == 0) {
+        flash_log_index_add(&hdr, &loc);
+    }
+
+    return rc;
+}
+
+int flash_log_clear(void)
+{
+    k_mutex_lock(&flash_log_lock, K_FOREVER);
+    if (!flash_log_ready) {
+        k_mutex_unlock(&flash_log_lock);
+        return -EAGAIN;
+    }
+
+    // fcb_clear() rotates out every used sector
+    uint32_t used = fcb_is_empty(&flash_log_fcb) ? 0 : flash_log_used_sectors();
+    int rc = fcb_clear(&flash_log_fcb);
+    if (rc == 0) {
+        flash_log_stats.sectors_erased += used;
+        flash_log_block.hdr.count = 0;
+        flash_log_has_blocks = false;
+        block_index_reset(&flash_log_index);
+
+        // Without the marker the log is empty all the same, a reboot restarts its numbering
+        int err = flash_log_write_marker();
+        if (err != 0) {
+            flash_log_stats.write_errors++;
+            LOG_ERR("Failed to write the clear marker: %d", err);
+        }
+        LOG_INF("Sample log cleared");
+    } else {
+        LOG_ERR("Failed to clear the sample log: %d", rc);
+    }
+    k_mutex_unlock(&flash_log_lock);
+
+    return rc;
+}
+
+uint64_t flash_log_now(void)
+{
+    return flash_log_time_base + (uint64_t)k_uptime_get();
+}
+
+struct flash_log_reader {
+    uint64_t from;
+    uint64_t to;
+    sample_record_cb cb;
+    void *user_data;
+};
+
+/* Hand the samples of a block in buf to the reader, false once it is done */
+static bool flash_log_read_block(const struct flash_log_reader *r,
+                                 const struct flash_log_block *buf, uint32_t len)
+{
+    struct sample_codec_decoder dec;
+    struct sample_record rec;
+
+    if (len < sizeof(buf->hdr) ||
+        sample_codec_decoder_init(&dec, buf->payload, len - sizeof(buf->hdr)) != 0) {
+        LOG_WRN("Skipping unreadable block %u", buf->hdr.sequence);
+        return true;
+    }
+
+    while (sample_codec_decode(&dec, &rec) == 0) {
+        if (rec.time < r->from) {
+            continue;
+        }
+        if (rec.time > r->to || !r->cb(&rec, r->user_data)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * The lock is only held to look up and copy one block at a time, so the
+ * thread keeps logging while samples are streamed out. If the sector being
+ * read is erased in between, reading carries on from the oldest sector
+ * left. Samples still in RAM are read last.
+ */
+int flash_log_read(uint64_t from, uint64_t to, sample_record_cb cb, void *user_data)
+{
+    const struct flash_log_reader r = {
+        .from = from,
+        .to = to,
+        .cb = cb,
+        .user_data = user_data,
+    };
+    struct block_index_entry entry;
+    struct fcb_entry loc = {0};
+    uint32_t erased = 0;
+    uint32_t age = 0;
+    bool in_flash = false;
+    bool more = true;
+    int rc = 0;
+
+    if (from > to) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&flash_log_read_lock, K_FOREVER);
+
+    k_mutex_lock(&flash_log_lock, K_FOREVER);
+    if (!flash_log_ready) {
+        rc = -EAGAIN;
+    } else if (block_index_get(&flash_log_index, block_index_find(&flash_log_index, from),
+                               &entry)) {
+        // The first entry of the sector is served next
+        loc.fe_sector = &flash_log_sectors[entry.sector];
+        erased = flash_log_stats.sectors_erased;
+        age = flash_log_sector_age(loc.fe_sector);
+        in_flash = true;
+    }
+    k_mutex_unlock(&flash_log_lock);
+
+    while (rc == 0 && more) {
+        struct flash_log_block_hdr hdr;
+        uint32_t len = 0;
+
+        k_mutex_lock(&flash_log_lock, K_FOREVER);
+        if (in_flash && flash_log_stats.sectors_erased - erased > age) {
+            loc = (struct fcb_entry){0};
+        }
+
+        if (in_flash && fcb_getnext(&flash_log_fcb, &loc) == 0) {
+            erased = flash_log_stats.sectors_erased;
+            age = flash_log_sector_age(loc.fe_sector);
+
+            rc = flash_log_read_hdr(flash_log_fcb.fap, &loc, &hdr);
+            if (rc == 0) {
+                if (hdr.first_time > to) {
+                    more = false;
+                } else if (hdr.last_time >= from &&
+                           loc.fe_data_len <= sizeof(flash_log_read_buf)) {
+                    rc = flash_area_read(flash_log_fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc),
+                                         &flash_log_read_buf, loc.fe_data_len);
+                    len = loc.fe_data_len;
+                }
+            } else if (rc == -ENODATA || rc == -EBADMSG) {
+                // Markers and entries that are not blocks hold no samples
+                rc = 0;
+            }
+        } else {
+            hdr = flash_log_block.hdr;
+            if (hdr.count > 0 && hdr.first_time <= to) {
+                len = sizeof(hdr) + sample_codec_finish(&flash_log_encoder);
+                memcpy(&flash_log_read_buf, &flash_log_block, len);
+            }
+            more = false;
+        }
+        k_mutex_unlock(&flash_log_lock);
+
+        if (rc == 0 && len > 0 && !flash_log_read_block(&r, &flash_log_read_buf, len)) {
+            more = false;
+        }
+    }
+
+    k_mutex_unlock(&flash_log_read_lock);
+    return rc;
+}
+
+static bool flash_log_query_add(const struct sample_record *rec, void *user_data)
+{
+    return sample_query_add(user_data, rec);
+}
+
+int flash_log_query(uint64_t from, uint64_t to, uint32_t step, enum sample_agg agg,
+                    sample_bucket_cb cb, void *user_data)
+{
+    struct sample_query q;
+
+    if (agg >= SAMPLE_AGG_COUNT) {
+        return -EINVAL;
+    }
+
+    sample_query_init(&q, from, to, step, agg, cb, user_data);
+
+    int rc = flash_log_read(from, to, flash_log_query_add, &q);
+    if (rc == 0) {
+        sample_query_finish(&q);
+    }
+
+    return rc;
+}
+
+/*
+ * Recovers the log, then collects the samples of every batch into the RAM
+ * block. Full blocks are written right away; a partial one is written once
+ * its first sample is CONFIG_WEATHER_STATION_FLASH_LOG_FLUSH_MS old, which
+ * bounds how much a reset can lose at low sampling rates.
+ */
+static void flash_log_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    const struct zbus_channel *chan;
+    struct sensor_batch_msg batch;
+
+    k_mutex_lock(&flash_log_lock, K_FOREVER);
+    int rc = flash_log_recover();
+    if (rc == 0) {
+        flash_log_build_index();
+    }
+    flash_log_ready = (rc == 0);
+    k_mutex_unlock(&flash_log_lock);
+
+    if (rc != 0) {
+        pub_policy_set_enable(&flash_log_sub, false);
+        return;
+    }
+
+    while (true) {
+        k_timeout_t timeout = K_FOREVER;
+
+        if (CONFIG_WEATHER_STATION_FLASH_LOG_FLUSH_MS > 0 && flash_log_block.hdr.count > 0) {
+            timeout = K_TIMEOUT_ABS_MS(flash_log_deadline);
+        }
+
+        rc = pub_policy_wait(&flash_log_sub, &chan, &batch, timeout);
+
+        k_mutex_lock(&flash_log_lock, K_FOREVER);
+        if (rc == 0 && chan == ZBUS_REF(ws_sensor_batch)) {
+            for (uint32_t i = 0; i < MIN(batch.count, SENSOR_BATCH_SIZE); i++) {
+                if (sensor_mgr_recorded(&batch.samples[i])) {
+                    flash_log_add(&batch.samples[i]);
+                }
+            }
+        }
+
+        if (CONFIG_WEATHER_STATION_FLASH_LOG_FLUSH_MS > 0 && flash_log_block.hdr.count > 0 &&
+            k_uptime_get() >= flash_log_deadline) {
+            flash_log_write_block();
+        }
+        k_mutex_unlock(&flash_log_lock);
+    }
+}
+
+K_THREAD_DEFINE(flash_log_tid, CONFIG_WEATHER_STATION_FLASH_LOG_STACK_SIZE,
+                flash_log_thread, NULL, NULL, NULL,
+                CONFIG_WEATHER_STATION_FLASH_LOG_PRIORITY, 0, 0);
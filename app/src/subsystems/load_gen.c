@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include "messages.h"
+#include "latency_stats.h"
+#include "load_gen.h"
+#include "load_match.h"
+#include "pub_policy.h"
+#include "sensor_mgr.h"
+
+LOG_MODULE_REGISTER(load_gen, CONFIG_WEATHER_STATION_LOG_LEVEL);
+
+#define LOAD_GEN_MAX_COUNT  CONFIG_WEATHER_STATION_LOAD_GEN_MAX_COUNT
+
+/* Half the 16-bit sequence range */
+#define LOAD_GEN_SEQ_OFFSET 0x8000U
+
+/* Bench triggers number on from one run to the next, generator thread only */
+static uint16_t load_gen_trigger_seq;
+
+/* A delivery may serve many folded triggers, so not a spinlock */
+static K_MUTEX_DEFINE(load_gen_lock);
+
+/* State of the running load, under load_gen_lock */
+static struct load_match load_gen_match = LOAD_MATCH_INIT(LOAD_GEN_MAX_COUNT);
+static bool load_gen_active;
+static bool load_gen_sending;
+static enum load_gen_mode load_gen_mode;
+static int64_t load_gen_last_delivery;
+
+/* Request handed to the generator thread */
+static uint32_t load_gen_count;
+static uint32_t load_gen_rate_hz;
+static struct load_gen_result *load_gen_result;
+
+static atomic_t load_gen_busy;
+K_SEM_DEFINE(load_gen_start, 0, 1);
+K_SEM_DEFINE(load_gen_done, 0, 1);
+K_SEM_DEFINE(load_gen_drained, 0, 1);
+
+static uint32_t load_gen_percentile(const uint32_t *sorted, size_t count, uint32_t pct)
+{
+    return k_cyc_to_us_ceil32(load_match_percentile(sorted, count, pct));
+}
+
+#if defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+static void load_gen_cpu_begin(k_thread_runtime_stats_t *start)
+{
+    k_thread_runtime_stats_all_get(start);
+}
+
+/* Share of the cycles since start not spent in the idle thread */
+static int32_t load_gen_cpu_end(const k_thread_runtime_stats_t *start)
+{
+    k_thread_runtime_stats_t end;
+
+    k_thread_runtime_stats_all_get(&end);
+
+    uint64_t all = end.execution_cycles - start->execution_cycles;
+    uint64_t busy = end.total_cycles - start->total_cycles;
+
+    return (all > 0) ? (int32_t)MIN(busy * 1000U / all, 1000U) : -1;
+}
+#endif
+
+void load_gen_delivered(const struct sensor_data_msg *msg)
+{
+    uint32_t now = k_cycle_get_32();
+    bool drained = false;
+
+    k_mutex_lock(&load_gen_lock, K_FOREVER);
+    // Only samples made or read for the bench name its messages. Every probe
+    // reads on a trigger, the primary one's sample stands for the read
+    if (load_gen_active && sensor_data_synthetic(msg) &&
+        (load_gen_mode != LOAD_GEN_TRIGGER || sensor_data_id(msg) == SENSOR_MGR_PRIMARY_ID)) {
+        uint16_t seq = (load_gen_mode == LOAD_GEN_TRIGGER) ? msg->trigger_seq : msg->sequence;
+        uint32_t extra = (load_gen_mode == LOAD_GEN_TRIGGER) ? msg->coalesced : 0;
+
+        if (load_match_delivered(&load_gen_match, seq, extra, now) > 0) {
+            load_gen_last_delivery = k_uptime_ticks();
+            drained = !load_gen_sending && load_gen_match.outstanding == 0;
+        }
+    }
+    k_mutex_unlock(&load_gen_lock);
+
+    if (drained) {
+        k_sem_give(&load_gen_drained);
+    }
+}
+
+static int load_gen_publish(uint32_t index, struct sensor_data_msg *sample)
+{
+    uint16_t seq = (uint16_t)(load_gen_match.base + index);
+    int rc;
+
+    // Stamp before publishing, the sample may arrive before the publish returns
+    k_mutex_lock(&load_gen_lock, K_FOREVER);
+    rc = load_match_sent(&load_gen_match, index, k_cycle_get_32());
+    k_mutex_unlock(&load_gen_lock);
+
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (load_gen_mode == LOAD_GEN_TRIGGER) {
+        struct trigger_msg trigger = {
+            .source = TRIGGER_BENCH,
+            .sequence = seq,
+            .stamp = latency_stamp()
+        };
+
+        rc = pub_policy_publish(ZBUS_REF(ws_trigger), &trigger);
+    } else {
+        sample->timestamp = k_uptime_get_32();
+        sample->sequence = seq;
+        sample->trigger_seq = seq;
+        latency_stats_mark_published(seq);
+        rc = pub_policy_publish(ZBUS_REF(ws_sensor_data), sample);
+    }
+
+    if (rc != 0) {
+        k_mutex_lock(&load_gen_lock, K_FOREVER);
+        load_match_failed(&load_gen_match, index);
+        k_mutex_unlock(&load_gen_lock);
+    }
+
+    return rc;
+}
+
+/* Generated sequence numbers, away from the ones the pipeline is using */
+static uint16_t load_gen_first_seq(struct sensor_data_msg *sample)
+{
+    if (load_gen_mode == LOAD_GEN_TRIGGER) {
+        uint16_t base = load_gen_trigger_seq;
+
+        load_gen_trigger_seq += (uint16_t)load_gen_count;
+        return base;
+    }
+
+    // Published samples repeat the latest values, marked as external and synthetic
+    if (sample_cache_latest(sensor_mgr_cache(), sample) != 0) {
+        *sample = (struct sensor_data_msg){
+            .flags = SENSOR_FLAG_TEMP_INVALID | SENSOR_FLAG_HUMIDITY_INVALID |
+                     SENSOR_FLAG_PRESSURE_INVALID
+        };
+    }
+    sample->flags = (sample->flags & ~SENSOR_SOURCE_INTERNAL) | SENSOR_SOURCE_EXTERNAL |
+                    SENSOR_FLAG_SYNTHETIC;
+
+    return (uint16_t)(sensor_mgr_next_sequence() + LOAD_GEN_SEQ_OFFSET);
+}
+
+static void load_gen_execute(struct load_gen_result *result)
+{
+    struct sensor_data_msg sample = {0};
+    uint16_t base = load_gen_first_seq(&sample);
+
+    *result = (struct load_gen_result){.cpu_permille = -1};
+
+    k_mutex_lock(&load_gen_lock, K_FOREVER);
+    // A sample serves the triggers folded into its read, a generated sample only itself
+    if (load_gen_mode == LOAD_GEN_TRIGGER) {
+        load_match_start(&load_gen_match, base, UINT8_MAX, true);
+    } else {
+        load_match_start(&load_gen_match, base, UINT16_MAX, false);
+    }
+    load_gen_sending = true;
+    load_gen_active = true;
+    k_mutex_unlock(&load_gen_lock);
+    k_sem_reset(&load_gen_drained);
+
+#if defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+    k_thread_runtime_stats_t cpu;
+
+    load_gen_cpu_begin(&cpu);
+#endif
+
+    int64_t start = k_uptime_ticks();
+
+    for (uint32_t i = 0; i < load_gen_count; i++) {
+        if (load_gen_mode == LOAD_GEN_TRIGGER) {
+            // Absolute deadlines, a late publish does not shift the ones after it
+            k_sleep(K_TIMEOUT_ABS_TICKS(start + (int64_t)i * CONFIG_SYS_CLOCK_TICKS_PER_SEC /
+                                        load_gen_rate_hz));
+        }
+
+        int rc = load_gen_publish(i, &sample);
+
+        if (rc == 0) {
+            result->sent++;
+        } else if (rc == -ENOBUFS) {
+            result->dropped++;
+        } else if (rc == -EAGAIN) {
+            result->timeouts++;
+        } else {
+            result->errors++;
+        }
+    }
+
+    int64_t send_end = k_uptime_ticks();
+
+    k_mutex_lock(&load_gen_lock, K_FOREVER);
+    load_gen_sending = false;
+    bool drained = (load_gen_match.outstanding == 0);
+    k_mutex_unlock(&load_gen_lock);
+
+    if (!drained) {
+        k_sem_take(&load_gen_drained, K_MSEC(CONFIG_WEATHER_STATION_LOAD_GEN_DRAIN_MS));
+    }
+
+#if defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+    result->cpu_permille = load_gen_cpu_end(&cpu);
+#endif
+
+    k_mutex_lock(&load_gen_lock, K_FOREVER);
+    load_gen_active = false;
+    int64_t last_delivery = load_gen_last_delivery;
+    k_mutex_unlock(&load_gen_lock);
+
+    // Deliveries have stopped, only this thread touches the match now
+    const uint32_t *latency = load_gen_match.cycles;
+    size_t delivered = load_match_collect(&load_gen_match);
+
+    result->delivered = delivered;
+    result->send_us = k_ticks_to_us_floor32(send_end - start);
+    result->elapsed_us = result->send_us;
+
+    if (delivered > 0) {
+        result->p50_us = load_gen_percentile(latency, delivered, 50);
+        result->p90_us = load_gen_percentile(latency, delivered, 90);
+        result->p99_us = load_gen_percentile(latency, delivered, 99);
+        result->max_us = k_cyc_to_us_ceil32(latency[delivered - 1]);
+        result->elapsed_us = k_ticks_to_us_floor32(MAX(last_delivery, send_end) - start);
+    }
+
+    LOG_INF("Load of %u messages done: %u sent, %u delivered", load_gen_count,
+            result->sent, result->delivered);
+}
+
+static void load_gen_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (true) {
+        k_sem_take(&load_gen_start, K_FOREVER);
+        load_gen_execute(load_gen_result);
+        k_sem_give(&load_gen_done);
+    }
+}
+
+K_THREAD_DEFINE(load_gen_tid, CONFIG_WEATHER_STATION_LOAD_GEN_STACK_SIZE,
+                load_gen_thread, NULL, NULL, NULL,
+                CONFIG_WEATHER_STATION_LOAD_GEN_PRIORITY, 0, 0);
+
+int load_gen_run(enum load_gen_mode mode, uint32_t count, uint32_t rate_hz,
+                 struct load_gen_result *result)
+{
+    if (count == 0 || count > LOAD_GEN_MAX_COUNT) {
+        return -EINVAL;
+    }
+
+    if (mode == LOAD_GEN_TRIGGER && (rate_hz == 0 || rate_hz > LOAD_GEN_MAX_RATE_HZ)) {
+        return -EINVAL;
+    }
+
+    if (!atomic_cas(&load_gen_busy, 0, 1)) {
+        return -EBUSY;
+    }
+
+    // The generator thread owns the load state until it signals completion
+    load_gen_mode = mode;
+    load_gen_count = count;
+    load_gen_rate_hz = rate_hz;
+    load_gen_result = result;
+
+    k_sem_give(&load_gen_start);
+    k_sem_take(&load_gen_done, K_FOREVER);
+
+    atomic_clear(&load_gen_busy);
+    return 0;
+}
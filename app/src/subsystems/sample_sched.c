@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include "messages.h"
+#include "latency_stats.h"
+#include "sample_sched.h"
+#include "adaptive_rate.h"
+#include "pub_policy.h"
+#include "sensor_mgr.h"
+
+LOG_MODULE_REGISTER(sample_sched, CONFIG_WEATHER_STATION_LOG_LEVEL);
+
+static struct k_spinlock sched_lock;
+static struct k_timer sched_timer;
+static struct k_work sched_work;
+
+static uint32_t sched_period_ms;
+static int64_t sched_epoch;         /* Tick the current schedule started at */
+static uint64_t sched_period_index; /* Deadline n is epoch + n * period */
+static uint32_t sched_sequence;
+static struct sample_sched_stats sched_stats;
+
+#if defined(CONFIG_WEATHER_STATION_ADAPTIVE_RATE)
+static struct adaptive_rate sched_adaptive;
+
+static const struct adaptive_rate_config sched_adaptive_config = {
+    .min_ms = CONFIG_WEATHER_STATION_ADAPTIVE_RATE_MIN_MS,
+    .max_ms = CONFIG_WEATHER_STATION_ADAPTIVE_RATE_MAX_MS,
+    .threshold = {
+        CONFIG_WEATHER_STATION_ADAPTIVE_RATE_TEMP_THRESHOLD,
+        CONFIG_WEATHER_STATION_ADAPTIVE_RATE_HUMIDITY_THRESHOLD,
+        CONFIG_WEATHER_STATION_ADAPTIVE_RATE_PRESSURE_THRESHOLD,
+    },
+};
+#endif
+
+/* Deadlines are derived from the epoch so ms to tick rounding never adds up */
+static int64_t sample_sched_deadline(uint64_t index)
+{
+    return sched_epoch + (int64_t)k_ms_to_ticks_ceil64(index * sched_period_ms);
+}
+
+static void sample_sched_timer_expiry(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+
+    k_work_submit(&sched_work);
+}
+
+static void sample_sched_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+    if (sched_period_ms == 0) {
+        k_spin_unlock(&sched_lock, key);
+        return;
+    }
+
+    int64_t now = k_uptime_ticks();
+    int64_t deadline = sample_sched_deadline(sched_period_index);
+    uint32_t late_ms = (uint32_t)k_ticks_to_ms_floor64(MAX(now - deadline, 0));
+    uint64_t elapsed = k_ticks_to_ms_floor64(now - sched_epoch) / sched_period_ms;
+    uint64_t next = MAX(sched_period_index + 1U, elapsed + 1U);
+
+    /* Deadlines that already passed are skipped rather than fired in a burst */
+    sched_stats.missed += (uint32_t)(next - sched_period_index - 1U);
+    if (late_ms > sched_period_ms / 10U) {
+        sched_stats.late++;
+    }
+    sched_stats.max_late_ms = MAX(sched_stats.max_late_ms, late_ms);
+    sched_period_index = next;
+
+    k_timer_start(&sched_timer, K_TIMEOUT_ABS_TICKS(sample_sched_deadline(next)), K_NO_WAIT);
+
+    struct trigger_msg trigger = {
+        .source = TRIGGER_TIMER,
+        .sequence = sched_sequence++,
+        .stamp = latency_stamp()
+    };
+    k_spin_unlock(&sched_lock, key);
+
+    /*
+     * A trigger shed by the ws_trigger policy shows up as a missed tick.
+     * This runs on the system workqueue, which must never wait for room.
+     */
+    int rc = pub_policy_try_publish(ZBUS_REF(ws_trigger), &trigger);
+
+    key = k_spin_lock(&sched_lock);
+    if (rc == 0) {
+        sched_stats.triggers++;
+    } else {
+        sched_stats.missed++;
+    }
+    k_spin_unlock(&sched_lock, key);
+
+    if (rc != 0) {
+        LOG_WRN("Periodic trigger %u dropped: %d", trigger.sequence, rc);
+    }
+}
+
+/* Restart the schedule from now, called with sched_lock held */
+static void sample_sched_restart(uint32_t period_ms)
+{
+    sched_period_ms = period_ms;
+    sched_epoch = k_uptime_ticks();
+    sched_period_index = 1;
+    sched_stats.max_late_ms = 0;
+
+    if (period_ms == 0) {
+        k_timer_stop(&sched_timer);
+    } else {
+        k_timer_start(&sched_timer, K_TIMEOUT_ABS_TICKS(sample_sched_deadline(1)),
+                      K_NO_WAIT);
+    }
+}
+
+int sample_sched_set_period(uint32_t period_ms)
+{
+    if (period_ms > CONFIG_WEATHER_STATION_SAMPLE_PERIOD_MAX_MS) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+    sched_stats.adaptive = false;
+    sched_stats.activity_pct = 0;
+    sample_sched_restart(period_ms);
+    k_spin_unlock(&sched_lock, key);
+
+    LOG_INF("Sampling period set to %u ms", period_ms);
+    return 0;
+}
+
+#if defined(CONFIG_WEATHER_STATION_ADAPTIVE_RATE)
+int sample_sched_set_adaptive(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+    uint32_t period_ms = (sched_period_ms != 0) ? sched_period_ms : sched_adaptive_config.max_ms;
+
+    adaptive_rate_init(&sched_adaptive, &sched_adaptive_config, period_ms);
+    sched_stats.adaptive = true;
+    sched_stats.activity_pct = 0;
+    sample_sched_restart(sched_adaptive.period_ms);
+    period_ms = sched_period_ms;
+    k_spin_unlock(&sched_lock, key);
+
+    LOG_INF("Adaptive sampling from %u ms (%u-%u ms)", period_ms,
+            sched_adaptive_config.min_ms, sched_adaptive_config.max_ms);
+    return 0;
+}
+
+/*
+ * Runs in the publisher's thread for every sample. Only the controller
+ * update and a timer restart happen here, both bounded and short. Every
+ * probe's real sample feeds the controller, the period is decided once per
+ * read on the primary probe's one. Synthetic samples are ignored.
+ */
+static void sample_sched_data_cb(const struct zbus_channel *chan)
+{
+    const struct sensor_data_msg *msg = zbus_chan_const_msg(chan);
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+    if (!sched_stats.adaptive || sensor_data_synthetic(msg)) {
+        k_spin_unlock(&sched_lock, key);
+        return;
+    }
+
+    if (!sensor_mgr_recorded(msg)) {
+        adaptive_rate_add(&sched_adaptive, msg);
+        k_spin_unlock(&sched_lock, key);
+        return;
+    }
+
+    uint32_t period_ms = adaptive_rate_update(&sched_adaptive, msg);
+    uint32_t old_ms = sched_period_ms;
+
+    sched_stats.activity_pct = sched_adaptive.activity_pct;
+    if (period_ms != old_ms) {
+        sched_stats.adjustments++;
+        sample_sched_restart(period_ms);
+    }
+    k_spin_unlock(&sched_lock, key);
+
+    if (period_ms != old_ms) {
+        LOG_DBG("Adaptive period %u -> %u ms", old_ms, period_ms);
+    }
+}
+
+ZBUS_LISTENER_DEFINE(sample_sched_lis, sample_sched_data_cb);
+ZBUS_CHAN_ADD_OBS(ws_sensor_data, sample_sched_lis, 1);
+#else
+int sample_sched_set_adaptive(void)
+{
+    return -ENOTSUP;
+}
+#endif
+
+uint32_t sample_sched_get_period(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+    uint32_t period_ms = sched_period_ms;
+
+    k_spin_unlock(&sched_lock, key);
+    return period_ms;
+}
+
+void sample_sched_get_stats(struct sample_sched_stats *stats)
+{
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+    *stats = sched_stats;
+    stats->period_ms = sched_period_ms;
+    k_spin_unlock(&sched_lock, key);
+}
+
+static int sample_sched_init(void)
+{
+    k_timer_init(&sched_timer, sample_sched_timer_expiry, NULL);
+    k_work_init(&sched_work, sample_sched_work_handler);
+
+    LOG_INF("Sample scheduler initialized");
+
+    int rc = sample_sched_set_period(CONFIG_WEATHER_STATION_SAMPLE_PERIOD_MS);
+
+    if (rc == 0 && IS_ENABLED(CONFIG_WEATHER_STATION_ADAPTIVE_RATE) &&
+        CONFIG_WEATHER_STATION_SAMPLE_PERIOD_MS != 0) {
+        rc = sample_sched_set_adaptive();
+    }
+    return rc;
+}
+
+SYS_INIT(sample_sched_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
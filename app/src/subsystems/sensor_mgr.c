@@ -4,42 +4,537 @@
  */
 
 #include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/rtio/rtio.h>
 #include <zephyr/zbus/zbus.h>
 #include "messages.h"
+#include "latency_stats.h"
+#include "sensor_mgr.h"
+#include "sample_cache.h"
+#include "pub_policy.h"
+#include "sample_filter.h"
 
 LOG_MODULE_REGISTER(sensor_mgr, CONFIG_WEATHER_STATION_LOG_LEVEL);
 
+/* One-shot read of all three channels through the sensor RTIO iodev */
+static struct sensor_chan_spec sensor_mgr_channels[] = {
+    {SENSOR_CHAN_AMBIENT_TEMP, 0},
+    {SENSOR_CHAN_HUMIDITY, 0},
+    {SENSOR_CHAN_PRESS, 0},
+};
+
+/* A probe, read through its own iodev so reads of all probes run at once */
+struct sensor_mgr_sensor {
+    const struct device *dev;
+    struct rtio_iodev *iodev;
+    uint8_t id;
+};
+
+#define SENSOR_MGR_IODEV_NAME(node_id) _CONCAT(sensor_mgr_iodev_, DT_DEP_ORD(node_id))
+#define SENSOR_MGR_CONFIG_NAME(node_id) _CONCAT(sensor_mgr_config_, DT_DEP_ORD(node_id))
+
+#define SENSOR_MGR_IODEV_DEFINE(node_id)                                                  \
+    static struct sensor_read_config SENSOR_MGR_CONFIG_NAME(node_id) = {                  \
+        .sensor = DEVICE_DT_GET(node_id),                                                 \
+        .is_streaming = false,                                                            \
+        .channels = sensor_mgr_channels,                                                  \
+        .count = ARRAY_SIZE(sensor_mgr_channels),                                         \
+        .max = ARRAY_SIZE(sensor_mgr_channels),                                           \
+    };                                                                                    \
+    RTIO_IODEV_DEFINE(SENSOR_MGR_IODEV_NAME(node_id), &__sensor_iodev_api,                \
+                      &SENSOR_MGR_CONFIG_NAME(node_id));
+
+#define SENSOR_MGR_SENSOR(node_id, sensor_id)                                             \
+    {                                                                                     \
+        .dev = DEVICE_DT_GET(node_id),                                                    \
+        .iodev = &SENSOR_MGR_IODEV_NAME(node_id),                                         \
+        .id = (sensor_id),                                                                \
+    },
+
+#if defined(CONFIG_WEATHER_STATION_FAKE_SENSOR)
+/* Every enabled fake sensor node is a probe */
+#define SENSOR_MGR_FAKE_SENSOR(node_id) SENSOR_MGR_SENSOR(node_id, DT_PROP(node_id, sensor_id))
+#define SENSOR_MGR_COUNT DT_NUM_INST_STATUS_OKAY(ws_fake_sensor)
+
+DT_FOREACH_STATUS_OKAY(ws_fake_sensor, SENSOR_MGR_IODEV_DEFINE)
+
+static const struct sensor_mgr_sensor sensor_mgr_sensors[] = {
+    DT_FOREACH_STATUS_OKAY(ws_fake_sensor, SENSOR_MGR_FAKE_SENSOR)
+};
+#else
+#define SENSOR_MGR_COUNT 1
+
+SENSOR_MGR_IODEV_DEFINE(DT_ALIAS(ws_sensor))
+
+static const struct sensor_mgr_sensor sensor_mgr_sensors[] = {
+    SENSOR_MGR_SENSOR(DT_ALIAS(ws_sensor), 0)
+};
+#endif
+
+BUILD_ASSERT(SENSOR_MGR_COUNT > 0, "No sensor enabled in devicetree");
+BUILD_ASSERT(SENSOR_MGR_COUNT <= SENSOR_ID_MAX + 1, "Sensor ids do not fit the sample flags");
+
+#if defined(CONFIG_WEATHER_STATION_TRIGGER_COALESCE)
+/* Triggers fold into the read in flight, so a probe never has more than one */
+#define SENSOR_MGR_READS SENSOR_MGR_COUNT
+#else
+#define SENSOR_MGR_READS (CONFIG_WEATHER_STATION_SENSOR_MGR_READS * SENSOR_MGR_COUNT)
+#endif
+
+/* Read buffers come from the context mempool and travel with the CQE */
+RTIO_DEFINE_WITH_MEMPOOL(sensor_mgr_rtio, SENSOR_MGR_READS, SENSOR_MGR_READS, SENSOR_MGR_READS,
+                         64, sizeof(void *));
+
+/* A read in flight, handed to the completion thread as RTIO userdata */
+struct sensor_mgr_request {
+    uint32_t trigger_seq;   /* Trigger the read was started for */
+    uint32_t coalesced;     /* Triggers folded in after the first, under sensor_req_lock */
+    uint32_t start;         /* Cycle stamp at submission */
+    uint16_t flags;         /* trigger_sample_flags() of every trigger served, same lock */
+    uint8_t sensor;         /* Index in sensor_mgr_sensors */
+};
+
+K_MEM_SLAB_DEFINE_STATIC(sensor_mgr_requests, sizeof(struct sensor_mgr_request),
+                         SENSOR_MGR_READS, 4);
+
+#if defined(CONFIG_WEATHER_STATION_FILTER)
+static const struct sample_filter_config sensor_filter_config = SAMPLE_FILTER_CONFIG_DEFAULT;
+
+/* One chain per probe, only the completion thread touches them */
+static struct sample_filter sensor_filters[SENSOR_MGR_COUNT];
+#endif
+
 static uint32_t sensor_sequence = 0;
+static atomic_t sensor_read_errors;
+static struct rollup sensor_rollup;
+static struct sample_cache sensor_cache;
+static struct sensor_batch_msg sensor_batch;
+static int64_t sensor_batch_deadline;
+
+/*
+ * Read in flight per probe, set by the acquisition thread and cleared by the
+ * completion thread. Triggers arriving meanwhile are folded into it.
+ */
+static struct k_spinlock sensor_req_lock;
+static struct sensor_mgr_request *sensor_in_flight[SENSOR_MGR_COUNT];
+static struct sensor_mgr_trigger_stats sensor_trigger_stats;
+
+struct sample_history *sensor_mgr_history(void)
+{
+    return &sensor_rollup.raw;
+}
+
+struct rollup *sensor_mgr_rollup(void)
+{
+    return &sensor_rollup;
+}
+
+struct sample_cache *sensor_mgr_cache(void)
+{
+    return &sensor_cache;
+}
+
+uint32_t sensor_mgr_read_errors(void)
+{
+    return (uint32_t)atomic_get(&sensor_read_errors);
+}
+
+void sensor_mgr_get_trigger_stats(struct sensor_mgr_trigger_stats *stats)
+{
+    k_spinlock_key_t key = k_spin_lock(&sensor_req_lock);
+
+    *stats = sensor_trigger_stats;
+    k_spin_unlock(&sensor_req_lock, key);
+}
+
+uint16_t sensor_mgr_next_sequence(void)
+{
+    // Only the completion thread writes it, a torn read is not possible on 32 bits
+    return (uint16_t)sensor_sequence;
+}
+
+size_t sensor_mgr_sensor_count(void)
+{
+    return SENSOR_MGR_COUNT;
+}
+
+const struct device *sensor_mgr_sensor(size_t index, uint8_t *id)
+{
+    if (index >= SENSOR_MGR_COUNT) {
+        return NULL;
+    }
+
+    if (id != NULL) {
+        *id = sensor_mgr_sensors[index].id;
+    }
+    return sensor_mgr_sensors[index].dev;
+}
+
+PUB_SUBSCRIBER_DEFINE(sensor_mgr_sub);
+
+/*
+ * Listeners run in the publisher's thread while it holds the channel, so
+ * puts never overlap, whoever publishes. Readers never wait on it.
+ */
+static void sensor_mgr_cache_cb(const struct zbus_channel *chan)
+{
+    const struct sensor_data_msg *msg = zbus_chan_const_msg(chan);
+
+    if (!sensor_data_synthetic(msg)) {
+        sample_cache_put(&sensor_cache, msg);
+    }
+}
+
+ZBUS_LISTENER_DEFINE(sensor_mgr_cache_lis, sensor_mgr_cache_cb);
+ZBUS_CHAN_ADD_OBS(ws_sensor_data, sensor_mgr_cache_lis, 0);
+
+static void sensor_mgr_flush_batch(void)
+{
+    if (sensor_batch.count == 0) {
+        return;
+    }
+
+    int rc = pub_policy_publish(ZBUS_REF(ws_sensor_batch), &sensor_batch);
+    if (rc != 0) {
+        LOG_ERR("Failed to publish sensor batch: %d", rc);
+    }
+
+    // History and rollups only need samples in order, not one by one
+    for (uint32_t i = 0; i < sensor_batch.count; i++) {
+        if (sensor_mgr_recorded(&sensor_batch.samples[i])) {
+            rollup_add(&sensor_rollup, &sensor_batch.samples[i]);
+        }
+    }
+
+    sensor_batch.count = 0;
+}
+
+static void sensor_mgr_batch_add(const struct sensor_data_msg *sample)
+{
+    if (sensor_batch.count == 0) {
+        sensor_batch_deadline = k_uptime_get() + CONFIG_WEATHER_STATION_BATCH_TIMEOUT_MS;
+    }
+
+    sensor_batch.samples[sensor_batch.count++] = *sample;
+    if (sensor_batch.count == SENSOR_BATCH_SIZE) {
+        sensor_mgr_flush_batch();
+    }
+}
+
+/* Fold a trigger into the read of a probe still in flight, false if it is idle */
+static bool sensor_mgr_coalesce(uint8_t sensor, const struct trigger_msg *msg)
+{
+    if (!IS_ENABLED(CONFIG_WEATHER_STATION_TRIGGER_COALESCE)) {
+        return false;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&sensor_req_lock);
+    struct sensor_mgr_request *req = sensor_in_flight[sensor];
+
+    if (req != NULL) {
+        req->coalesced++;
+        req->flags &= trigger_sample_flags(msg->source);
+    }
+    k_spin_unlock(&sensor_req_lock, key);
 
-static void sensor_mgr_trigger_handler(const struct zbus_channel *chan)
+    return req != NULL;
+}
+
+static void sensor_mgr_set_in_flight(uint8_t sensor, struct sensor_mgr_request *req)
+{
+    if (IS_ENABLED(CONFIG_WEATHER_STATION_TRIGGER_COALESCE)) {
+        k_spinlock_key_t key = k_spin_lock(&sensor_req_lock);
+
+        sensor_in_flight[sensor] = req;
+        k_spin_unlock(&sensor_req_lock, key);
+    }
+}
+
+/* Outcome of a trigger for one probe */
+#define SENSOR_MGR_QUEUED   0
+#define SENSOR_MGR_FOLDED   1
+
+/*
+ * Queue a read of one probe and return, the completion thread publishes it.
+ * Returns SENSOR_MGR_QUEUED if a read was queued, SENSOR_MGR_FOLDED if the
+ * trigger was folded into a read already in flight, or a negative errno if
+ * the probe could not be read.
+ */
+static int sensor_mgr_submit(uint8_t sensor, const struct trigger_msg *msg)
 {
-    const struct trigger_msg *msg = zbus_chan_const_msg(chan);
-    LOG_INF("Trigger received (source: %d, seq: %u)", msg->source, msg->sequence);
+    struct sensor_mgr_request *req;
 
-    // TODO: Read real sensors here
-    struct sensor_data_msg sensor_data = {
-        .timestamp = k_uptime_get(),
-        .temperature_c = 22.5f,
-        .humidity_percent = 45.0f,
-        .pressure_pa = 101325.0f,
-        .source_flags = SENSOR_SOURCE_INTERNAL,
-        .sequence = sensor_sequence++,
-        .status = 0
-    };
+    if (sensor_mgr_coalesce(sensor, msg)) {
+        return SENSOR_MGR_FOLDED;
+    }
+
+    if (k_mem_slab_alloc(&sensor_mgr_requests, (void **)&req, K_NO_WAIT) != 0) {
+        atomic_inc(&sensor_read_errors);
+        LOG_ERR("Too many sensor reads in flight");
+        return -ENOMEM;
+    }
+
+    req->trigger_seq = msg->sequence;
+    req->coalesced = 0;
+    req->flags = trigger_sample_flags(msg->source);
+    req->start = latency_stamp();
+    req->sensor = sensor;
+
+    // Published before the submit, the read may complete before it returns
+    sensor_mgr_set_in_flight(sensor, req);
 
-    // Publish sensor data
-    int rc = zbus_chan_pub(ZBUS_REF(ws_sensor_data), &sensor_data, K_SECONDS(2));
+    int rc = sensor_read_async_mempool(sensor_mgr_sensors[sensor].iodev, &sensor_mgr_rtio, req);
     if (rc != 0) {
-        LOG_ERR("Failed to publish sensor data: %d", rc);
+        sensor_mgr_set_in_flight(sensor, NULL);
+        k_mem_slab_free(&sensor_mgr_requests, req);
+        atomic_inc(&sensor_read_errors);
+        LOG_ERR("Failed to queue read of sensor %u: %d", sensor_mgr_sensors[sensor].id, rc);
+        return rc;
+    }
+    return SENSOR_MGR_QUEUED;
+}
+
+/*
+ * Every probe is read on each trigger. All reads are queued before any
+ * completes, so probes convert concurrently and each sample is published
+ * as soon as its own read is done, whatever the slower probes do.
+ */
+static void sensor_mgr_handle_trigger(const struct trigger_msg *msg)
+{
+    bool acquired = false;
+    bool folded = false;
+
+    latency_stats_record(LATENCY_STAGE_TRIGGER, msg->stamp);
+    LOG_DBG("Trigger received (source: %d, seq: %u)", msg->source, msg->sequence);
+
+    for (uint8_t i = 0; i < SENSOR_MGR_COUNT; i++) {
+        int rc = sensor_mgr_submit(i, msg);
+
+        acquired |= (rc == SENSOR_MGR_QUEUED);
+        folded |= (rc == SENSOR_MGR_FOLDED);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&sensor_req_lock);
+
+    sensor_trigger_stats.triggers++;
+    if (acquired) {
+        sensor_trigger_stats.acquisitions++;
+    } else if (folded) {
+        sensor_trigger_stats.coalesced++;
+    } else {
+        sensor_trigger_stats.failed++;
+    }
+    k_spin_unlock(&sensor_req_lock, key);
+}
+
+/* Convert a decoded q31 reading to an integer in units of 1/scale */
+static int sensor_mgr_decode_channel(const struct sensor_decoder_api *decoder,
+                                     const uint8_t *buf, enum sensor_channel type,
+                                     int64_t scale, int32_t *out, uint64_t *timestamp_ns)
+{
+    struct sensor_q31_data data = {0};
+    uint32_t fit = 0;
+
+    int rc = decoder->decode(buf, (struct sensor_chan_spec){type, 0}, &fit, 1, &data);
+    if (rc <= 0) {
+        return -ENODATA;
+    }
+
+    int64_t value = (int64_t)data.readings[0].value * scale;
+    int shift = 31 - data.shift;
+
+    if (shift > 0) {
+        value = (value + (1LL << (shift - 1))) >> shift;
+    } else {
+        value <<= -shift;
     }
+
+    *out = (int32_t)CLAMP(value, INT32_MIN, INT32_MAX);
+    *timestamp_ns = data.header.base_timestamp_ns;
+    return 0;
 }
 
-ZBUS_LISTENER_DEFINE(sensor_mgr_listener,
-                    sensor_mgr_trigger_handler);
+static void sensor_mgr_decode(const struct sensor_decoder_api *decoder, const uint8_t *buf,
+                              struct sensor_data_msg *sensor_data)
+{
+    uint64_t timestamp_ns = 0;
+    int32_t temp, humidity, pressure;
+
+    if (sensor_mgr_decode_channel(decoder, buf, SENSOR_CHAN_AMBIENT_TEMP, 100,
+                                  &temp, &timestamp_ns) == 0) {
+        sensor_data->temperature_centi_c = (int16_t)CLAMP(temp, INT16_MIN, INT16_MAX);
+    } else {
+        sensor_data->flags |= SENSOR_FLAG_TEMP_INVALID;
+    }
+
+    if (sensor_mgr_decode_channel(decoder, buf, SENSOR_CHAN_HUMIDITY, 10,
+                                  &humidity, &timestamp_ns) == 0) {
+        sensor_data->humidity_deci_pct = (uint16_t)CLAMP(humidity, 0, 1000);
+    } else {
+        sensor_data->flags |= SENSOR_FLAG_HUMIDITY_INVALID;
+    }
+
+    // The sensor API reports pressure in kPa
+    if (sensor_mgr_decode_channel(decoder, buf, SENSOR_CHAN_PRESS, 1000,
+                                  &pressure, &timestamp_ns) == 0) {
+        sensor_data->pressure_pa_off = (uint16_t)CLAMP(pressure - (int32_t)SENSOR_PRESSURE_BASE_PA,
+                                                       0, UINT16_MAX);
+    } else {
+        sensor_data->flags |= SENSOR_FLAG_PRESSURE_INVALID;
+    }
+
+    if (timestamp_ns != 0) {
+        sensor_data->timestamp = (uint32_t)(timestamp_ns / NSEC_PER_MSEC);
+    }
+}
+
+/*
+ * Publish stage: waits for read completions, decodes them and publishes the
+ * samples. Reads complete in whatever context the driver finishes them in.
+ */
+static void sensor_mgr_rx_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    const struct sensor_decoder_api *decoders[SENSOR_MGR_COUNT];
+    int rc;
+
+    // Probes may use different drivers, each with its own decoder
+    for (size_t i = 0; i < SENSOR_MGR_COUNT; i++) {
+        rc = sensor_get_decoder(sensor_mgr_sensors[i].dev, &decoders[i]);
+        if (rc != 0) {
+            LOG_ERR("Sensor %u has no decoder: %d", sensor_mgr_sensors[i].id, rc);
+            decoders[i] = NULL;
+        }
+    }
+
+    while (true) {
+        struct rtio_cqe *cqe = rtio_cqe_consume_block(&sensor_mgr_rtio);
+        uint32_t read_done = latency_stamp();
+        struct sensor_mgr_request *req = cqe->userdata;
+        const struct sensor_mgr_sensor *sensor = &sensor_mgr_sensors[req->sensor];
+        const struct sensor_decoder_api *decoder = decoders[req->sensor];
+        int result = cqe->result;
+        uint8_t *buf = NULL;
+        uint32_t buf_len = 0;
+
+        if (result == 0) {
+            result = rtio_cqe_get_mempool_buffer(&sensor_mgr_rtio, cqe, &buf, &buf_len);
+        }
+        rtio_cqe_release(&sensor_mgr_rtio, cqe);
+        latency_stats_record(LATENCY_STAGE_ACQUIRE, req->start);
+
+        // Triggers arriving from here on start a new read
+        k_spinlock_key_t key = k_spin_lock(&sensor_req_lock);
+        uint32_t trigger_seq = req->trigger_seq;
+        uint32_t coalesced = req->coalesced;
+        uint16_t flags = req->flags;
+
+        if (sensor_in_flight[req->sensor] == req) {
+            sensor_in_flight[req->sensor] = NULL;
+        }
+        k_spin_unlock(&sensor_req_lock, key);
+        k_mem_slab_free(&sensor_mgr_requests, req);
+
+        struct sensor_data_msg sensor_data = {
+            .timestamp = k_uptime_get_32(),
+            .sequence = (uint16_t)sensor_sequence++,
+            .flags = SENSOR_SOURCE_INTERNAL | sensor_id_flags(sensor->id) | flags
+        };
+
+        sensor_data_set_served(&sensor_data, trigger_seq, coalesced);
+
+        if (result == 0 && decoder == NULL) {
+            result = -ENOTSUP;
+        }
+
+        if (result == 0) {
+            sensor_mgr_decode(decoder, buf, &sensor_data);
+#if defined(CONFIG_WEATHER_STATION_FILTER)
+            sample_filter_apply(&sensor_filters[sensor - sensor_mgr_sensors], &sensor_data);
+#endif
+        } else {
+            atomic_inc(&sensor_read_errors);
+            sensor_data.flags |= SENSOR_FLAG_ERROR | SENSOR_FLAG_TEMP_INVALID |
+                                 SENSOR_FLAG_HUMIDITY_INVALID | SENSOR_FLAG_PRESSURE_INVALID;
+            LOG_ERR("Read of sensor %u failed: %d", sensor->id, result);
+        }
+        rtio_release_buffer(&sensor_mgr_rtio, buf, buf_len);
+        latency_stats_record(LATENCY_STAGE_DECODE, read_done);
+
+        // Stamp before publishing, observers may run before the publish returns
+        latency_stats_mark_published(sensor_data.sequence);
+        rc = pub_policy_publish(ZBUS_REF(ws_sensor_data), &sensor_data);
+        if (rc != 0) {
+            LOG_ERR("Failed to publish sensor data: %d", rc);
+        }
+    }
+}
+
+K_THREAD_DEFINE(sensor_mgr_rx_tid, CONFIG_WEATHER_STATION_SENSOR_MGR_STACK_SIZE,
+                sensor_mgr_rx_thread, NULL, NULL, NULL,
+                CONFIG_WEATHER_STATION_SENSOR_MGR_PRIORITY, 0, 0);
+
+/*
+ * Acquisition runs on its own thread so publishing ws_trigger only costs
+ * queueing a copy of the message, whatever the sensors or observers do.
+ * The thread only submits reads, it never waits for one. It also observes
+ * ws_sensor_data to build batches and flushes them on their deadline.
+ */
+static void sensor_mgr_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    const struct zbus_channel *chan;
+    union {
+        struct trigger_msg trigger;
+        struct sensor_data_msg data;
+    } msg;
+
+    while (true) {
+        k_timeout_t timeout = K_FOREVER;
+
+        if (sensor_batch.count > 0) {
+            timeout = K_TIMEOUT_ABS_MS(sensor_batch_deadline);
+        }
+
+        if (pub_policy_wait(&sensor_mgr_sub, &chan, &msg, timeout) == 0) {
+            if (chan == ZBUS_REF(ws_trigger)) {
+                sensor_mgr_handle_trigger(&msg.trigger);
+            } else if (chan == ZBUS_REF(ws_sensor_data)) {
+                latency_stats_delivered(LATENCY_STAGE_BATCHER, msg.data.sequence);
+                // Batches feed the display and the flash log, keep synthetic samples out
+                if (!sensor_data_synthetic(&msg.data)) {
+                    sensor_mgr_batch_add(&msg.data);
+                }
+            }
+        }
+
+        if (sensor_batch.count > 0 && k_uptime_get() >= sensor_batch_deadline) {
+            sensor_mgr_flush_batch();
+        }
+    }
+}
+
+K_THREAD_DEFINE(sensor_mgr_tid, CONFIG_WEATHER_STATION_SENSOR_MGR_STACK_SIZE,
+                sensor_mgr_thread, NULL, NULL, NULL,
+                CONFIG_WEATHER_STATION_SENSOR_MGR_PRIORITY, 0, 0);
 
 static int sensor_mgr_init(void)
 {
+    rollup_init(&sensor_rollup);
+    sample_cache_init(&sensor_cache);
+#if defined(CONFIG_WEATHER_STATION_FILTER)
+    for (size_t i = 0; i < SENSOR_MGR_COUNT; i++) {
+        sample_filter_init(&sensor_filters[i], &sensor_filter_config);
+    }
+#endif
     LOG_INF("Sensor manager initialized");
     return 0;
 }
@@ -7,14 +7,28 @@
 #include <zephyr/shell/shell.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/zbus/zbus.h>
+#include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "messages.h"
+#include "latency_stats.h"
+#include "sample_sched.h"
+#include "aggregator.h"
+#include "sensor_mgr.h"
+#include "flash_log.h"
+#include "pub_policy.h"
+#include "value_fmt.h"
+#include "load_gen.h"
+
+#if defined(CONFIG_WEATHER_STATION_EXPORT)
+#include <zephyr/sys/base64.h>
+#include "sample_export.h"
+#endif
 
 LOG_MODULE_REGISTER(shell_iface, CONFIG_WEATHER_STATION_LOG_LEVEL);
 
 static uint32_t trigger_sequence = 0;
-static struct sensor_data_msg last_sensor_data = {0};
-static bool has_sensor_data = false;
 
 static int cmd_trigger(const struct shell *shell, size_t argc, char **argv)
 {
@@ -25,11 +39,15 @@ static int cmd_trigger(const struct shell *shell, size_t argc, char **argv)
 
     struct trigger_msg trigger = {
         .source = TRIGGER_MANUAL,
-        .sequence = trigger_sequence++
+        .sequence = trigger_sequence++,
+        .stamp = latency_stamp()
     };
 
-    int rc = zbus_chan_pub(ZBUS_REF(ws_trigger), &trigger, K_SECONDS(1));
-    if (rc != 0) {
+    int rc = pub_policy_publish(ZBUS_REF(ws_trigger), &trigger);
+    if (rc == -ENOBUFS || rc == -EAGAIN) {
+        shell_error(shell, "Trigger dropped, acquisition is overloaded (see ws bus)");
+        return rc;
+    } else if (rc != 0) {
         shell_error(shell, "Failed to publish trigger: %d", rc);
         return rc;
     }
@@ -40,24 +58,104 @@ static int cmd_trigger(const struct shell *shell, size_t argc, char **argv)
 
 static int cmd_show(const struct shell *shell, size_t argc, char **argv)
 {
-    if (argc > 1) {
-        shell_error(shell, "Usage: ws show");
+    struct sensor_data_msg last_sensor_data;
+    int rc;
+
+    if (argc > 2) {
+        shell_error(shell, "Usage: ws show [sensor_id]");
         return -EINVAL;
     }
 
-    if (!has_sensor_data) {
+    if (argc == 2) {
+        char *end;
+        unsigned long id = strtoul(argv[1], &end, 10);
+
+        if (*end != '\0' || id > SENSOR_ID_MAX) {
+            shell_error(shell, "Invalid sensor id: %s (0-%u)", argv[1], SENSOR_ID_MAX);
+            return -EINVAL;
+        }
+        rc = sample_cache_get(sensor_mgr_cache(), (uint8_t)id, &last_sensor_data);
+    } else {
+        rc = sample_cache_latest(sensor_mgr_cache(), &last_sensor_data);
+    }
+
+    if (rc != 0) {
         shell_error(shell, "No sensor data available");
         return -ENODATA;
     }
 
+    char temp[VALUE_FMT_LEN], humidity[VALUE_FMT_LEN], pressure[VALUE_FMT_LEN];
+
+    value_fmt_temperature(temp, sizeof(temp), &last_sensor_data);
+    value_fmt_humidity(humidity, sizeof(humidity), &last_sensor_data);
+    value_fmt_pressure(pressure, sizeof(pressure), &last_sensor_data);
+
     shell_print(shell, "Latest Sensor Data:");
-    shell_print(shell, "  Timestamp: %llu ms", last_sensor_data.timestamp);
-    shell_print(shell, "  Temperature: %.1f°C", last_sensor_data.temperature_c);
-    shell_print(shell, "  Humidity: %.1f%%", last_sensor_data.humidity_percent);
-    shell_print(shell, "  Pressure: %.1f Pa", last_sensor_data.pressure_pa);
-    shell_print(shell, "  Source: %s", (last_sensor_data.source_flags & SENSOR_SOURCE_INTERNAL) ? "INTERNAL" : "EXTERNAL");
-    shell_print(shell, "  Sequence: %u", last_sensor_data.sequence);
-    shell_print(shell, "  Status: %d", last_sensor_data.status);
+    shell_print(shell, "  Timestamp: %u ms", last_sensor_data.timestamp);
+    shell_print(shell, "  Temperature: %s°C", temp);
+    shell_print(shell, "  Humidity: %s%%", humidity);
+    shell_print(shell, "  Pressure: %s Pa", pressure);
+    shell_print(shell, "  Source: %s", (last_sensor_data.flags & SENSOR_SOURCE_INTERNAL) ? "INTERNAL" : "EXTERNAL");
+    shell_print(shell, "  Sensor: %u", sensor_data_id(&last_sensor_data));
+    shell_print(shell, "  Sequence: %u (trigger %u, %u coalesced)", last_sensor_data.sequence,
+                last_sensor_data.trigger_seq, last_sensor_data.coalesced);
+    shell_print(shell, "  Status: %s", (last_sensor_data.flags & SENSOR_FLAG_ERROR) ? "ERROR" : "OK");
+
+    return 0;
+}
+
+static void format_derived(char *buf, size_t len, bool valid, int32_t value,
+                           unsigned int decimals)
+{
+    if (valid) {
+        value_fmt_fixed(buf, len, value, decimals);
+    } else {
+        snprintf(buf, len, "n/a");
+    }
+}
+
+static int cmd_derived(const struct shell *shell, size_t argc, char **argv)
+{
+    if (argc > 1) {
+        shell_error(shell, "Usage: ws derived");
+        return -EINVAL;
+    }
+
+    if (!IS_ENABLED(CONFIG_WEATHER_STATION_DERIVED)) {
+        shell_error(shell, "Derived metrics disabled");
+        return -ENOTSUP;
+    }
+
+    static const uint16_t all_invalid = DERIVED_FLAG_DEW_POINT_INVALID |
+                                        DERIVED_FLAG_HEAT_INDEX_INVALID |
+                                        DERIVED_FLAG_ABS_HUMIDITY_INVALID |
+                                        DERIVED_FLAG_SEA_LEVEL_INVALID;
+    struct derived_data_msg d;
+
+    int rc = zbus_chan_read(ZBUS_REF(ws_derived), &d, K_MSEC(100));
+    if (rc != 0 || (d.flags & all_invalid) == all_invalid) {
+        shell_error(shell, "No derived metrics available");
+        return -ENODATA;
+    }
+
+    char dew[VALUE_FMT_LEN], heat[VALUE_FMT_LEN], rho[VALUE_FMT_LEN], p0[VALUE_FMT_LEN];
+
+    format_derived(dew, sizeof(dew), !(d.flags & DERIVED_FLAG_DEW_POINT_INVALID),
+                   d.dew_point_centi_c, 2);
+    format_derived(heat, sizeof(heat), !(d.flags & DERIVED_FLAG_HEAT_INDEX_INVALID),
+                   d.heat_index_centi_c, 2);
+    format_derived(rho, sizeof(rho), !(d.flags & DERIVED_FLAG_ABS_HUMIDITY_INVALID),
+                   d.abs_humidity_centi_g_m3, 2);
+    format_derived(p0, sizeof(p0), !(d.flags & DERIVED_FLAG_SEA_LEVEL_INVALID),
+                   (int32_t)MIN(d.sea_level_pa, INT32_MAX), 0);
+
+    shell_print(shell, "Derived Metrics (sensor %u, sample %u):",
+                (d.flags & SENSOR_ID_MASK) >> SENSOR_ID_SHIFT, d.sequence);
+    shell_print(shell, "  Timestamp: %u ms", d.timestamp);
+    shell_print(shell, "  Dew Point: %s°C", dew);
+    shell_print(shell, "  Heat Index: %s°C", heat);
+    shell_print(shell, "  Absolute Humidity: %s g/m³", rho);
+    shell_print(shell, "  Sea-level Pressure: %s Pa", p0);
 
     return 0;
 }
@@ -70,28 +168,819 @@ static int cmd_status(const struct shell *shell, size_t argc, char **argv)
     }
 
     shell_print(shell, "Weather Station Status:");
-    shell_print(shell, "  Sensor Data Available: %s", has_sensor_data ? "YES" : "NO");
+    shell_print(shell, "  Sensor Data Available: %s",
+                sample_cache_sensors(sensor_mgr_cache()) != 0 ? "YES" : "NO");
     shell_print(shell, "  Last Trigger Sequence: %u", trigger_sequence);
+    struct sensor_mgr_trigger_stats triggers;
+
+    sensor_mgr_get_trigger_stats(&triggers);
+    shell_print(shell, "  Triggers Served: %u (acquisitions: %u, coalesced: %u, failed: %u)",
+                triggers.triggers, triggers.acquisitions, triggers.coalesced, triggers.failed);
+    shell_print(shell, "  Sensors: %u (read errors: %u)", (uint32_t)sensor_mgr_sensor_count(),
+                sensor_mgr_read_errors());
+    for (size_t i = 0; i < sensor_mgr_sensor_count(); i++) {
+        uint8_t id;
+        const struct device *dev = sensor_mgr_sensor(i, &id);
+
+        shell_print(shell, "    %u: %s (%s)", id, dev->name,
+                    device_is_ready(dev) ? "ready" : "not ready");
+    }
+    shell_print(shell, "  History Samples: %u/%u", sample_history_count(sensor_mgr_history()),
+                SAMPLE_HISTORY_SIZE);
+    struct sample_sched_stats sched;
+
+    sample_sched_get_stats(&sched);
+    shell_print(shell, "  Sampling Period: %u ms%s", sched.period_ms,
+                sched.period_ms == 0 ? " (manual only)" : (sched.adaptive ? " (adaptive)" : ""));
+#if defined(CONFIG_WEATHER_STATION_ADAPTIVE_RATE)
+    if (sched.adaptive) {
+        shell_print(shell, "  Adaptive Rate: %u-%u ms, activity %u%% of threshold, %u changes",
+                    CONFIG_WEATHER_STATION_ADAPTIVE_RATE_MIN_MS,
+                    CONFIG_WEATHER_STATION_ADAPTIVE_RATE_MAX_MS, sched.activity_pct,
+                    sched.adjustments);
+    }
+#endif
+    shell_print(shell, "  Periodic Triggers: %u (late: %u, missed: %u)",
+                sched.triggers, sched.late, sched.missed);
     shell_print(shell, "  System Uptime: %llu ms", k_uptime_get());
 
     return 0;
 }
 
-static void shell_iface_sensor_data_handler(const struct zbus_channel *chan)
+static int cmd_history(const struct shell *shell, size_t argc, char **argv)
+{
+    unsigned long count = 10;
+
+    if (argc > 2) {
+        shell_error(shell, "Usage: ws history [n]");
+        return -EINVAL;
+    }
+
+    if (argc == 2) {
+        char *end;
+
+        count = strtoul(argv[1], &end, 10);
+        if (*end != '\0' || count == 0) {
+            shell_error(shell, "Invalid sample count: %s", argv[1]);
+            return -EINVAL;
+        }
+    }
+
+    struct sample_history *hist = sensor_mgr_history();
+    struct sample_history_cursor cursor;
+    struct sample_history_entry entry;
+
+    sample_history_cursor_init(hist, &cursor, (uint32_t)MIN(count, UINT32_MAX));
+    if (cursor.remaining == 0) {
+        shell_error(shell, "No sensor history available");
+        return -ENODATA;
+    }
+
+    shell_print(shell, "Sensor %u History (newest first, %u of %u samples):",
+                SENSOR_MGR_PRIMARY_ID, cursor.remaining, sample_history_count(hist));
+
+    while (sample_history_prev(hist, &cursor, &entry) == 0) {
+        char temp[VALUE_FMT_LEN] = "n/a";
+        char humidity[VALUE_FMT_LEN] = "n/a";
+        char pressure[VALUE_FMT_LEN] = "n/a";
+
+        if (entry.temperature_centi_c != SAMPLE_HISTORY_TEMP_INVALID) {
+            value_fmt_fixed(temp, sizeof(temp), entry.temperature_centi_c, 2);
+        }
+        if (entry.humidity_deci_pct != SAMPLE_HISTORY_HUMIDITY_INVALID) {
+            value_fmt_fixed(humidity, sizeof(humidity), entry.humidity_deci_pct, 1);
+        }
+        if (entry.pressure_pa != 0) {
+            value_fmt_fixed(pressure, sizeof(pressure), (int32_t)entry.pressure_pa, 0);
+        }
+
+        shell_print(shell, "  %u ms: T=%s°C H=%s%% P=%s Pa",
+                    entry.timestamp, temp, humidity, pressure);
+    }
+
+    return 0;
+}
+
+PUB_SUBSCRIBER_DEFINE(shell_iface_sub);
+
+static int cmd_rate(const struct shell *shell, size_t argc, char **argv)
+{
+    if (argc > 2) {
+        shell_error(shell, "Usage: ws rate [period_ms|auto]");
+        return -EINVAL;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "auto") == 0) {
+        int rc = sample_sched_set_adaptive();
+        if (rc != 0) {
+            shell_error(shell, "Adaptive sampling not available: %d", rc);
+            return rc;
+        }
+    } else if (argc == 2) {
+        char *end;
+        unsigned long period_ms = strtoul(argv[1], &end, 10);
+
+        if (*end != '\0' || period_ms > CONFIG_WEATHER_STATION_SAMPLE_PERIOD_MAX_MS) {
+            shell_error(shell, "Invalid period: %s (0-%u ms)", argv[1],
+                        CONFIG_WEATHER_STATION_SAMPLE_PERIOD_MAX_MS);
+            return -EINVAL;
+        }
+
+        int rc = sample_sched_set_period((uint32_t)period_ms);
+        if (rc != 0) {
+            shell_error(shell, "Failed to set period: %d", rc);
+            return rc;
+        }
+    }
+
+    struct sample_sched_stats sched;
+
+    sample_sched_get_stats(&sched);
+    if (sched.period_ms == 0) {
+        shell_print(shell, "Periodic sampling stopped");
+    } else {
+        shell_print(shell, "Sampling every %u ms%s", sched.period_ms,
+                    sched.adaptive ? " (adaptive)" : "");
+    }
+    shell_print(shell, "  Triggers: %u", sched.triggers);
+    shell_print(shell, "  Late: %u (max %u ms)", sched.late, sched.max_late_ms);
+    shell_print(shell, "  Missed: %u", sched.missed);
+
+    return 0;
+}
+
+static int cmd_stats(const struct shell *shell, size_t argc, char **argv)
+{
+    if (argc > 1) {
+        shell_error(shell, "Usage: ws stats [reset | window <name>]");
+        return -EINVAL;
+    }
+
+    if (!IS_ENABLED(CONFIG_WEATHER_STATION_LATENCY_STATS)) {
+        shell_error(shell, "Latency statistics disabled");
+        return -ENOTSUP;
+    }
+
+    shell_print(shell, "Pipeline Latency (us, resolved to log2 buckets):");
+    shell_print(shell, "  %-8s %10s %8s %8s %8s %8s", "Stage", "Count", "p50", "p90", "p99", "max");
+
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        struct latency_summary sum;
+
+        latency_stats_summary(stage, &sum);
+        shell_print(shell, "  %-8s %10u %8u %8u %8u %8u",
+                    latency_stats_stage_name(stage), sum.count,
+                    k_cyc_to_us_ceil32(sum.p50), k_cyc_to_us_ceil32(sum.p90),
+                    k_cyc_to_us_ceil32(sum.p99), k_cyc_to_us_ceil32(sum.max));
+    }
+
+    return 0;
+}
+
+static int cmd_stats_reset(const struct shell *shell, size_t argc, char **argv)
+{
+    if (argc > 1) {
+        shell_error(shell, "Usage: ws stats reset");
+        return -EINVAL;
+    }
+
+    latency_stats_reset();
+    shell_print(shell, "Latency statistics cleared");
+    return 0;
+}
+
+static int cmd_stats_window(const struct shell *shell, size_t argc, char **argv)
+{
+    static const struct {
+        const char *name;
+        const char *unit;
+        unsigned int decimals;
+    } channels[AGGREGATE_CHANNELS] = {
+        {"Temperature", "°C", 2},
+        {"Humidity", "%", 1},
+        {"Pressure", "Pa", 0},
+    };
+
+    if (argc != 2) {
+        shell_error(shell, "Usage: ws stats window <1m|1h|24h|all>");
+        return -EINVAL;
+    }
+
+    int window = aggregator_window_by_name(argv[1]);
+    if (window < 0) {
+        shell_error(shell, "Unknown window: %s (1m, 1h, 24h, all)", argv[1]);
+        return -EINVAL;
+    }
+
+    struct aggregate_msg agg;
+
+    aggregator_query(window, &agg);
+    shell_print(shell, "Statistics of sensor %u over %s:", SENSOR_MGR_PRIMARY_ID,
+                aggregator_window_name(window));
+
+    for (int ch = 0; ch < AGGREGATE_CHANNELS; ch++) {
+        const struct aggregate_stats *st = &agg.channels[ch];
+        char min[VALUE_FMT_LEN], max[VALUE_FMT_LEN], mean[VALUE_FMT_LEN];
+        char stddev[VALUE_FMT_LEN];
+
+        if (st->count == 0) {
+            shell_print(shell, "  %s: no samples", channels[ch].name);
+            continue;
+        }
+
+        value_fmt_fixed(min, sizeof(min), st->min, channels[ch].decimals);
+        value_fmt_fixed(max, sizeof(max), st->max, channels[ch].decimals);
+        value_fmt_fixed(mean, sizeof(mean), st->mean, channels[ch].decimals);
+        value_fmt_fixed(stddev, sizeof(stddev), (int32_t)MIN(st->stddev, INT32_MAX),
+                     channels[ch].decimals);
+        shell_print(shell, "  %s (%s): n=%u min=%s max=%s mean=%s stddev=%s",
+                    channels[ch].name, channels[ch].unit, st->count, min, max, mean, stddev);
+    }
+
+    return 0;
+}
+
+static int cmd_bus(const struct shell *shell, size_t argc, char **argv)
+{
+    if (argc > 1) {
+        shell_error(shell, "Usage: ws bus [reset]");
+        return -EINVAL;
+    }
+
+    struct pub_channel pc;
+
+    shell_print(shell, "Channel Overload (queue depth now/max/bound):");
+    for (size_t i = 0; pub_policy_get(i, &pc) == 0; i++) {
+        shell_print(shell, "  %s: %s, %u published, %u timeouts, %u dropped, depth %u/%u/%u",
+                    pc.name, pub_policy_name(pc.policy), pc.stats.published,
+                    pc.stats.timeouts, pc.stats.dropped, pc.stats.depth,
+                    pc.stats.max_depth, pc.depth);
+        if (pc.policy == PUB_POLICY_BLOCK) {
+            shell_print(shell, "    blocks up to %u ms", pc.timeout_ms);
+        }
+    }
+
+    return 0;
+}
+
+static int cmd_bus_reset(const struct shell *shell, size_t argc, char **argv)
+{
+    if (argc > 1) {
+        shell_error(shell, "Usage: ws bus reset");
+        return -EINVAL;
+    }
+
+    pub_policy_reset();
+    shell_print(shell, "Channel counters cleared");
+    return 0;
+}
+
+struct trend_ctx {
+    const struct shell *shell;
+    uint32_t rows;
+};
+
+static void format_range(char *buf, size_t len, int32_t min, int32_t avg, int32_t max,
+                         int32_t invalid, unsigned int decimals)
+{
+    char lo[VALUE_FMT_LEN], mid[VALUE_FMT_LEN], hi[VALUE_FMT_LEN];
+
+    if (avg == invalid) {
+        snprintf(buf, len, "n/a");
+        return;
+    }
+
+    value_fmt_fixed(lo, sizeof(lo), min, decimals);
+    value_fmt_fixed(mid, sizeof(mid), avg, decimals);
+    value_fmt_fixed(hi, sizeof(hi), max, decimals);
+    snprintf(buf, len, "%s/%s/%s", lo, mid, hi);
+}
+
+static bool trend_print(enum rollup_tier tier, const struct rollup_record *rec, void *user_data)
+{
+    struct trend_ctx *ctx = user_data;
+    char temp[40], humidity[40], pressure[40];
+
+    if (ctx->rows == 0) {
+        return false;
+    }
+    ctx->rows--;
+
+    format_range(temp, sizeof(temp), rec->temp_min, rec->temp_avg, rec->temp_max,
+                 SAMPLE_HISTORY_TEMP_INVALID, 2);
+    format_range(humidity, sizeof(humidity), rec->humidity_min, rec->humidity_avg,
+                 rec->humidity_max, SAMPLE_HISTORY_HUMIDITY_INVALID, 1);
+    if (rec->pressure_avg == SAMPLE_HISTORY_PRESSURE_INVALID) {
+        snprintf(pressure, sizeof(pressure), "n/a");
+    } else {
+        format_range(pressure, sizeof(pressure),
+                     rec->pressure_min + SENSOR_PRESSURE_BASE_PA,
+                     rec->pressure_avg + SENSOR_PRESSURE_BASE_PA,
+                     rec->pressure_max + SENSOR_PRESSURE_BASE_PA, -1, 0);
+    }
+
+    shell_print(ctx->shell, "  %u ms n=%u T=%s°C H=%s%% P=%s Pa",
+                rec->start, rec->count, temp, humidity, pressure);
+    return true;
+}
+
+static int cmd_trend(const struct shell *shell, size_t argc, char **argv)
+{
+    unsigned long seconds;
+    unsigned long rows = 20;
+    char *end;
+
+    if (argc < 2 || argc > 3) {
+        shell_error(shell, "Usage: ws trend <seconds> [rows]");
+        return -EINVAL;
+    }
+
+    seconds = strtoul(argv[1], &end, 10);
+    if (*end != '\0' || seconds == 0 || seconds > UINT32_MAX / MSEC_PER_SEC) {
+        shell_error(shell, "Invalid span: %s", argv[1]);
+        return -EINVAL;
+    }
+
+    if (argc == 3) {
+        rows = strtoul(argv[2], &end, 10);
+        if (*end != '\0' || rows == 0) {
+            shell_error(shell, "Invalid row count: %s", argv[2]);
+            return -EINVAL;
+        }
+    }
+
+    struct rollup *r = sensor_mgr_rollup();
+    uint32_t span_ms = (uint32_t)seconds * MSEC_PER_SEC;
+    uint32_t now = k_uptime_get_32();
+    uint32_t from = (now > span_ms) ? now - span_ms : 0;
+    uint32_t step_ms = MAX(span_ms / rows, 1U);
+    // One row per step over the span picks how coarse the tier may be
+    enum rollup_tier tier = rollup_select_tier(r, from, step_ms);
+    struct trend_ctx ctx = {
+        .shell = shell,
+        .rows = (uint32_t)MIN(rows, UINT32_MAX),
+    };
+
+    shell_print(shell, "Trend of sensor %u over %lu s in %u ms steps from the %s tier "
+                "(min/avg/max, newest first):", SENSOR_MGR_PRIMARY_ID, seconds, step_ms,
+                rollup_tier_name(tier));
+
+    // Rows finer than the step, raw samples or minutes, are merged into it
+    if (rollup_query_steps(r, tier, from, now, step_ms, trend_print, &ctx) == 0) {
+        shell_print(shell, "  No data");
+    }
+
+    return 0;
+}
+
+static int cmd_log_info(const struct shell *shell, size_t argc, char **argv)
 {
-    const struct sensor_data_msg *msg = zbus_chan_const_msg(chan);
-    last_sensor_data = *msg;
-    has_sensor_data = true;
+    struct flash_log_info info;
+
+    if (argc > 1) {
+        shell_error(shell, "Usage: ws log info");
+        return -EINVAL;
+    }
+
+    int rc = flash_log_get_info(&info);
+    if (rc != 0) {
+        shell_error(shell, "Sample log not available: %d", rc);
+        return rc;
+    }
+
+    shell_print(shell, "Sample Log:");
+    shell_print(shell, "  Sectors: %u/%u used (%u bytes each)", info.used_sectors,
+                info.sector_count, info.sector_size);
+    if (info.has_blocks) {
+        shell_print(shell, "  Blocks: %u to %u", info.oldest_sequence, info.newest_sequence);
+        shell_print(shell, "  Log Time: %llu to %llu ms", info.oldest_time, info.newest_time);
+    } else {
+        shell_print(shell, "  Blocks: none");
+    }
+    shell_print(shell, "  Buffered Samples: %u", info.pending);
+    shell_print(shell, "  Written Since Boot: %u blocks, %u bytes", info.blocks_written,
+                info.bytes_written);
+    shell_print(shell, "  Sectors Erased: %u", info.sectors_erased);
+    shell_print(shell, "  Write Errors: %u", info.write_errors);
+    shell_print(shell, "  Recovery: %u blocks read in %u us", info.recovery_blocks,
+                info.recovery_us);
+    shell_print(shell, "  Query Index: %u sectors (built in %u us)", info.index_sectors,
+                info.index_us);
+    shell_print(shell, "  Log Time Now: %llu ms", flash_log_now());
+
+    return 0;
 }
 
-ZBUS_LISTENER_DEFINE(shell_iface_listener,
-                    shell_iface_sensor_data_handler);
+static int cmd_log_flush(const struct shell *shell, size_t argc, char **argv)
+{
+    if (argc > 1) {
+        shell_error(shell, "Usage: ws log flush");
+        return -EINVAL;
+    }
+
+    int rc = flash_log_flush();
+    if (rc != 0) {
+        shell_error(shell, "Failed to flush the sample log: %d", rc);
+        return rc;
+    }
+
+    shell_print(shell, "Buffered samples written");
+    return 0;
+}
+
+static int cmd_log_clear(const struct shell *shell, size_t argc, char **argv)
+{
+    if (argc > 1) {
+        shell_error(shell, "Usage: ws log clear");
+        return -EINVAL;
+    }
+
+    int rc = flash_log_clear();
+    if (rc != 0) {
+        shell_error(shell, "Failed to clear the sample log: %d", rc);
+        return rc;
+    }
+
+    shell_print(shell, "Sample log cleared");
+    return 0;
+}
+
+struct query_ctx {
+    const struct shell *shell;
+    uint32_t rows;
+};
+
+static bool query_print(const struct sample_bucket *bucket, void *user_data)
+{
+    struct query_ctx *ctx = user_data;
+    char temp[16] = "n/a";
+    char humidity[16] = "n/a";
+    char pressure[16] = "n/a";
+
+    if (bucket->valid & BIT(STATS_TEMPERATURE)) {
+        value_fmt_fixed(temp, sizeof(temp), bucket->values[STATS_TEMPERATURE], 2);
+    }
+    if (bucket->valid & BIT(STATS_HUMIDITY)) {
+        value_fmt_fixed(humidity, sizeof(humidity), bucket->values[STATS_HUMIDITY], 1);
+    }
+    if (bucket->valid & BIT(STATS_PRESSURE)) {
+        value_fmt_fixed(pressure, sizeof(pressure), bucket->values[STATS_PRESSURE], 0);
+    }
+
+    shell_print(ctx->shell, "  %llu ms n=%u T=%s°C H=%s%% P=%s Pa",
+                bucket->start, bucket->count, temp, humidity, pressure);
+    ctx->rows++;
+    return true;
+}
+
+/* Log time in ms, or "now" */
+static int parse_log_time(const char *arg, uint64_t *time)
+{
+    char *end;
+
+    if (strcmp(arg, "now") == 0) {
+        *time = flash_log_now();
+        return 0;
+    }
+
+    errno = 0;
+    unsigned long long value = strtoull(arg, &end, 10);
+    if (*end != '\0' || errno != 0) {
+        return -EINVAL;
+    }
+
+    *time = value;
+    return 0;
+}
+
+static int cmd_query(const struct shell *shell, size_t argc, char **argv)
+{
+    uint64_t from, to;
+    uint32_t step = 0;
+    int agg = SAMPLE_AGG_AVG;
+
+    if (argc < 3 || argc > 5) {
+        shell_error(shell, "Usage: ws query <from> <to> [step] [avg|min|max|last]");
+        return -EINVAL;
+    }
+
+    if (parse_log_time(argv[1], &from) != 0 || parse_log_time(argv[2], &to) != 0 ||
+        from > to) {
+        shell_error(shell, "Invalid range: %s to %s (log time in ms or \"now\")",
+                    argv[1], argv[2]);
+        return -EINVAL;
+    }
+
+    if (argc >= 4) {
+        char *end;
+        unsigned long value = strtoul(argv[3], &end, 10);
+
+        if (*end != '\0' || value > UINT32_MAX) {
+            shell_error(shell, "Invalid step: %s", argv[3]);
+            return -EINVAL;
+        }
+        step = (uint32_t)value;
+    }
+
+    if (argc == 5) {
+        agg = sample_agg_by_name(argv[4]);
+        if (agg < 0) {
+            shell_error(shell, "Unknown aggregate: %s (avg, min, max, last)", argv[4]);
+            return -EINVAL;
+        }
+    }
+
+    struct query_ctx ctx = {
+        .shell = shell,
+    };
+
+    if (step == 0) {
+        shell_print(shell, "Sensor %u samples from %llu to %llu ms (oldest first):",
+                    SENSOR_MGR_PRIMARY_ID, from, to);
+    } else {
+        shell_print(shell, "Sensor %u samples from %llu to %llu ms, %s per %u ms (oldest first):",
+                    SENSOR_MGR_PRIMARY_ID, from, to, sample_agg_name(agg), step);
+    }
+
+    int rc = flash_log_query(from, to, step, agg, query_print, &ctx);
+    if (rc != 0) {
+        shell_error(shell, "Query failed: %d", rc);
+        return rc;
+    }
+
+    if (ctx.rows == 0) {
+        shell_print(shell, "  No data");
+    }
+
+    return 0;
+}
+
+#if defined(CONFIG_WEATHER_STATION_EXPORT)
+/* One chunk, and the base64 line a binary chunk is printed as */
+static uint8_t export_chunk[CONFIG_WEATHER_STATION_EXPORT_CHUNK_SIZE];
+static char export_line[4 * DIV_ROUND_UP(CONFIG_WEATHER_STATION_EXPORT_CHUNK_SIZE, 3) + 1];
+
+static int export_write_csv(const uint8_t *data, size_t len, void *user_data)
+{
+    const struct shell *shell = user_data;
+
+    shell_fprintf(shell, SHELL_NORMAL, "%.*s", (int)len, (const char *)data);
+    return 0;
+}
+
+static int export_write_bin(const uint8_t *data, size_t len, void *user_data)
+{
+    const struct shell *shell = user_data;
+    size_t olen;
+
+    int rc = base64_encode((uint8_t *)export_line, sizeof(export_line), &olen, data, len);
+    if (rc != 0) {
+        return rc;
+    }
+
+    shell_print(shell, "%s", export_line);
+    return 0;
+}
+
+static bool export_add(const struct sample_record *rec, void *user_data)
+{
+    return sample_export_add(user_data, rec) == 0;
+}
+
+static int cmd_export(const struct shell *shell, size_t argc, char **argv)
+{
+    struct sample_export exp;
+    uint64_t from, to;
+    int format = SAMPLE_EXPORT_CSV;
+
+    if (argc < 3 || argc > 4) {
+        shell_error(shell, "Usage: ws export [csv|bin] <from> <to>");
+        return -EINVAL;
+    }
+
+    if (argc == 4) {
+        format = sample_export_format_by_name(argv[1]);
+        if (format < 0) {
+            shell_error(shell, "Unknown format: %s (csv, bin)", argv[1]);
+            return -EINVAL;
+        }
+    }
+
+    if (parse_log_time(argv[argc - 2], &from) != 0 ||
+        parse_log_time(argv[argc - 1], &to) != 0 || from > to) {
+        shell_error(shell, "Invalid range: %s to %s (log time in ms or \"now\")",
+                    argv[argc - 2], argv[argc - 1]);
+        return -EINVAL;
+    }
+
+    int rc = sample_export_init(&exp, format, export_chunk, sizeof(export_chunk), from, to,
+                                (format == SAMPLE_EXPORT_CSV) ? export_write_csv :
+                                                                export_write_bin,
+                                (void *)shell);
+    if (rc == 0) {
+        rc = flash_log_read(from, to, export_add, &exp);
+    }
+    if (rc == 0) {
+        rc = sample_export_finish(&exp);
+    }
+    if (rc == 0) {
+        rc = exp.err;
+    }
+
+    if (rc != 0) {
+        shell_error(shell, "Export failed after %u samples: %d", exp.records, rc);
+        return rc;
+    }
+
+    LOG_DBG("Exported %u samples in %u chunks", exp.records, exp.chunks);
+    return 0;
+}
+#endif /* CONFIG_WEATHER_STATION_EXPORT */
+
+#if defined(CONFIG_WEATHER_STATION_LOAD_GEN)
+
+static int bench_parse(const struct shell *shell, const char *what, const char *arg,
+                       uint32_t max, uint32_t *out)
+{
+    char *end;
+    unsigned long value = strtoul(arg, &end, 10);
+
+    if (*end != '\0' || value == 0 || value > max) {
+        shell_error(shell, "Invalid %s: %s (1-%u)", what, arg, max);
+        return -EINVAL;
+    }
+
+    *out = (uint32_t)value;
+    return 0;
+}
+
+/* Messages per second with one decimal */
+static void bench_format_rate(char *buf, size_t len, uint32_t msgs, uint32_t us)
+{
+    uint64_t rate = (us > 0) ? (uint64_t)msgs * 10U * USEC_PER_SEC / us : 0;
+
+    value_fmt_fixed(buf, len, (int32_t)MIN(rate, INT32_MAX), 1);
+}
+
+static int bench_run(const struct shell *shell, enum load_gen_mode mode, uint32_t count,
+                     uint32_t rate_hz)
+{
+    struct load_gen_result res;
+
+    int rc = load_gen_run(mode, count, rate_hz, &res);
+    if (rc == -EBUSY) {
+        shell_error(shell, "A load generator run is in progress");
+        return rc;
+    } else if (rc != 0) {
+        shell_error(shell, "Load generator failed: %d", rc);
+        return rc;
+    }
+
+    char sent_rate[VALUE_FMT_LEN], delivered_rate[VALUE_FMT_LEN];
+
+    bench_format_rate(sent_rate, sizeof(sent_rate), res.sent, res.send_us);
+    bench_format_rate(delivered_rate, sizeof(delivered_rate), res.delivered, res.elapsed_us);
+
+    shell_print(shell, "  Sent: %u in %u ms, %s/s", res.sent, res.send_us / USEC_PER_MSEC,
+                sent_rate);
+    shell_print(shell, "  Delivered: %u in %u ms, %s/s, %u lost", res.delivered,
+                res.elapsed_us / USEC_PER_MSEC, delivered_rate, res.sent - res.delivered);
+    shell_print(shell, "  Publish failures: %u dropped, %u timeouts, %u errors",
+                res.dropped, res.timeouts, res.errors);
+
+    if (res.delivered > 0) {
+        shell_print(shell, "  Latency (us): p50 %u, p90 %u, p99 %u, max %u",
+                    res.p50_us, res.p90_us, res.p99_us, res.max_us);
+    }
+
+    if (res.cpu_permille >= 0) {
+        char cpu[VALUE_FMT_LEN];
+
+        value_fmt_fixed(cpu, sizeof(cpu), res.cpu_permille, 1);
+        shell_print(shell, "  CPU: %s%% busy", cpu);
+    } else {
+        shell_print(shell, "  CPU: not measured (needs CONFIG_SCHED_THREAD_USAGE_ALL)");
+    }
+
+    return 0;
+}
+
+static int cmd_bench_trigger(const struct shell *shell, size_t argc, char **argv)
+{
+    uint32_t count, rate_hz;
+
+    if (argc != 3) {
+        shell_error(shell, "Usage: ws bench trigger <count> <rate_hz>");
+        return -EINVAL;
+    }
+
+    if (bench_parse(shell, "count", argv[1], CONFIG_WEATHER_STATION_LOAD_GEN_MAX_COUNT,
+                    &count) != 0 ||
+        bench_parse(shell, "rate", argv[2], LOAD_GEN_MAX_RATE_HZ, &rate_hz) != 0) {
+        return -EINVAL;
+    }
+
+    shell_print(shell, "Triggering %u reads at %u Hz...", count, rate_hz);
+    return bench_run(shell, LOAD_GEN_TRIGGER, count, rate_hz);
+}
+
+static int cmd_bench_publish(const struct shell *shell, size_t argc, char **argv)
+{
+    uint32_t count;
+
+    if (argc != 2) {
+        shell_error(shell, "Usage: ws bench publish <count>");
+        return -EINVAL;
+    }
+
+    if (bench_parse(shell, "count", argv[1], CONFIG_WEATHER_STATION_LOAD_GEN_MAX_COUNT,
+                    &count) != 0) {
+        return -EINVAL;
+    }
+
+    shell_print(shell, "Publishing %u samples...", count);
+    return bench_run(shell, LOAD_GEN_PUBLISH, count, 0);
+}
+
+#endif /* CONFIG_WEATHER_STATION_LOAD_GEN */
+
+/*
+ * Commands read samples from the sensor manager cache. The subscription
+ * only remains as the pipeline stage measuring delivery to a consumer
+ * thread, which is also where "ws bench" ends its latencies.
+ */
+static void shell_iface_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    const struct zbus_channel *chan;
+    struct sensor_data_msg msg;
+
+    while (pub_policy_wait(&shell_iface_sub, &chan, &msg, K_FOREVER) == 0) {
+        if (chan == ZBUS_REF(ws_sensor_data)) {
+            latency_stats_delivered(LATENCY_STAGE_SHELL, msg.sequence);
+#if defined(CONFIG_WEATHER_STATION_LOAD_GEN)
+            load_gen_delivered(&msg);
+#endif
+        }
+    }
+}
+
+K_THREAD_DEFINE(shell_iface_tid, CONFIG_WEATHER_STATION_SHELL_IFACE_STACK_SIZE,
+                shell_iface_thread, NULL, NULL, NULL,
+                CONFIG_WEATHER_STATION_SHELL_IFACE_PRIORITY, 0, 0);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    ws_stats_subcommands,
+    SHELL_CMD(reset, NULL, "Clear the latency histograms", cmd_stats_reset),
+    SHELL_CMD(window, NULL, "Sample statistics over <1m|1h|24h|all>", cmd_stats_window),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    ws_bus_subcommands,
+    SHELL_CMD(reset, NULL, "Clear the channel counters", cmd_bus_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    ws_log_subcommands,
+    SHELL_CMD(info, NULL, "Show the flash sample log usage", cmd_log_info),
+    SHELL_CMD(flush, NULL, "Write the buffered samples now", cmd_log_flush),
+    SHELL_CMD(clear, NULL, "Erase the flash sample log", cmd_log_clear),
+    SHELL_SUBCMD_SET_END
+);
+
+#if defined(CONFIG_WEATHER_STATION_LOAD_GEN)
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    ws_bench_subcommands,
+    SHELL_CMD(trigger, NULL, "Trigger <count> reads at <rate_hz>", cmd_bench_trigger),
+    SHELL_CMD(publish, NULL, "Publish <count> samples back to back", cmd_bench_publish),
+    SHELL_SUBCMD_SET_END
+);
+#endif
 
 SHELL_STATIC_SUBCMD_SET_CREATE(
     ws_subcommands,
     SHELL_CMD(trigger, NULL, "Request immediate sensor reading", cmd_trigger),
-    SHELL_CMD(show, NULL, "Display latest sensor data", cmd_show),
+    SHELL_CMD(show, NULL, "Display latest sensor data [sensor_id]", cmd_show),
+    SHELL_CMD(derived, NULL, "Display the latest derived metrics", cmd_derived),
     SHELL_CMD(status, NULL, "Show subsystem health and statistics", cmd_status),
+    SHELL_CMD(history, NULL, "Show the last [n] samples (default 10)", cmd_history),
+    SHELL_CMD(rate, NULL, "Show or set the sampling period [ms|auto], 0 stops", cmd_rate),
+    SHELL_CMD(trend, NULL, "Show min/avg/max over the last <seconds> [rows]", cmd_trend),
+    SHELL_CMD(stats, &ws_stats_subcommands, "Show per-stage latency percentiles", cmd_stats),
+    SHELL_CMD(bus, &ws_bus_subcommands, "Show channel overload policies and counters", cmd_bus),
+    SHELL_CMD(log, &ws_log_subcommands, "Persistent sample log commands", NULL),
+    SHELL_CMD(query, NULL, "Aggregate logged samples: <from> <to> [step] [agg]", cmd_query),
+#if defined(CONFIG_WEATHER_STATION_EXPORT)
+    SHELL_CMD(export, NULL, "Stream logged samples: [csv|bin] <from> <to>", cmd_export),
+#endif
+#if defined(CONFIG_WEATHER_STATION_LOAD_GEN)
+    SHELL_CMD(bench, &ws_bench_subcommands, "Load the running pipeline", NULL),
+#endif
     SHELL_SUBCMD_SET_END
 );
 
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host side of the native_sim benchmark clock. Built into the native
+ * simulator runner, so it can use the host C library directly.
+ */
+
+#include <stdint.h>
+#include <time.h>
+
+uint64_t bench_host_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,654 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Pipeline benchmarks.
+ *
+ * Every result is printed as a single line:
+ *
+ *   BENCH <name> key=value key=value ...
+ *
+ * Latencies are in ns and summarised as min/p50/p90/p99/max over
+ * CONFIG_WEATHER_STATION_BENCH_ITERATIONS samples; throughput is in
+ * messages per second. Grep for "^BENCH " to collect the results.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/rtio/rtio.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/zbus/zbus.h>
+#include <stdlib.h>
+#include "messages.h"
+#include "sample_history.h"
+#include "sample_codec.h"
+#include "fake_sensor.h"
+#include "pub_policy.h"
+#include "derived_metrics.h"
+#include "sample_filter.h"
+
+#define BENCH_ITERATIONS CONFIG_WEATHER_STATION_BENCH_ITERATIONS
+#define BENCH_OBSERVERS  CONFIG_WEATHER_STATION_BENCH_OBSERVERS
+#define BENCH_BURST      256
+
+PUB_SUBSCRIBER_DECLARE(sensor_mgr_sub);
+PUB_SUBSCRIBER_DECLARE(shell_iface_sub);
+PUB_SUBSCRIBER_DECLARE(display_mgr_sub);
+PUB_SUBSCRIBER_DECLARE(aggregator_sub);
+#if defined(CONFIG_WEATHER_STATION_DERIVED)
+PUB_SUBSCRIBER_DECLARE(derived_mgr_sub);
+#endif
+
+/*
+ * Time base. On hardware this is the cycle counter. Simulated time stands
+ * still while code runs on native_sim, so the host clock is used there.
+ */
+#if defined(CONFIG_NATIVE_LIBRARY)
+extern uint64_t bench_host_now_ns(void);
+#endif
+
+static inline uint64_t bench_now(void)
+{
+#if defined(CONFIG_NATIVE_LIBRARY)
+    return bench_host_now_ns();
+#elif defined(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+    return k_cycle_get_64();
+#else
+    return k_cycle_get_32();
+#endif
+}
+
+static inline uint32_t bench_ns_between(uint64_t start, uint64_t end)
+{
+#if defined(CONFIG_NATIVE_LIBRARY)
+    return (uint32_t)MIN(end - start, UINT32_MAX);
+#elif defined(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+    return (uint32_t)MIN(k_cyc_to_ns_floor64(end - start), UINT32_MAX);
+#else
+    // 32-bit counters wrap, the unsigned difference is still right
+    return (uint32_t)MIN(k_cyc_to_ns_floor64((uint32_t)end - (uint32_t)start), UINT32_MAX);
+#endif
+}
+
+static inline uint32_t bench_ns_since(uint64_t start)
+{
+    return bench_ns_between(start, bench_now());
+}
+
+static const char *bench_time_base(void)
+{
+    return IS_ENABLED(CONFIG_NATIVE_LIBRARY) ? "host" : "cycles";
+}
+
+/* Latency samples of the running benchmark */
+static uint32_t bench_samples[BENCH_ITERATIONS];
+
+static int bench_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint32_t bench_percentile(const uint32_t *sorted, size_t count, uint32_t pct)
+{
+    size_t index = (count * pct + 99U) / 100U;
+
+    return sorted[CLAMP(index, 1U, count) - 1U];
+}
+
+static void bench_report_latency(const char *name, uint32_t *samples, size_t count)
+{
+    uint64_t sum = 0;
+
+    zassert_true(count > 0, "%s: no samples", name);
+    qsort(samples, count, sizeof(samples[0]), bench_cmp);
+
+    for (size_t i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+
+    printk("BENCH %s n=%u min_ns=%u mean_ns=%u p50_ns=%u p90_ns=%u p99_ns=%u "
+           "max_ns=%u clock=%s\n",
+           name, (unsigned int)count, samples[0], (uint32_t)(sum / count),
+           bench_percentile(samples, count, 50), bench_percentile(samples, count, 90),
+           bench_percentile(samples, count, 99), samples[count - 1], bench_time_base());
+}
+
+static void bench_report_throughput(const char *name, uint32_t observers,
+                                    uint32_t msgs, uint32_t elapsed_ns)
+{
+    uint64_t rate = (elapsed_ns > 0) ? (uint64_t)msgs * NSEC_PER_SEC / elapsed_ns : 0;
+
+    printk("BENCH %s observers=%u msgs=%u elapsed_ns=%u msgs_per_sec=%u clock=%s\n",
+           name, observers, msgs, elapsed_ns, (uint32_t)rate, bench_time_base());
+}
+
+/* Subscribers of the application channels, disabled while isolating a stage */
+static struct k_sem *const bench_app_observers[] = {
+    &sensor_mgr_sub,
+    &shell_iface_sub,
+    &display_mgr_sub,
+    &aggregator_sub,
+#if defined(CONFIG_WEATHER_STATION_DERIVED)
+    &derived_mgr_sub,
+#endif
+};
+
+static void bench_app_observers_enable(bool enable)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(bench_app_observers); i++) {
+        pub_policy_set_enable(bench_app_observers[i], enable);
+    }
+}
+
+/*
+ * Stage costs
+ */
+
+static struct sample_history bench_history;
+
+/* Synchronous read of the fake sensor through its RTIO iodev */
+static struct sensor_chan_spec bench_channels[] = {
+    {SENSOR_CHAN_AMBIENT_TEMP, 0},
+    {SENSOR_CHAN_HUMIDITY, 0},
+    {SENSOR_CHAN_PRESS, 0},
+};
+
+static struct sensor_read_config bench_read_config = {
+    .sensor = FAKE_SENSOR_DEV,
+    .is_streaming = false,
+    .channels = bench_channels,
+    .count = ARRAY_SIZE(bench_channels),
+    .max = ARRAY_SIZE(bench_channels),
+};
+
+RTIO_IODEV_DEFINE(bench_iodev, &__sensor_iodev_api, &bench_read_config);
+RTIO_DEFINE(bench_rtio, 1, 1);
+
+ZBUS_CHAN_DEFINE(bench_chan,
+                struct sensor_data_msg,
+                NULL,
+                NULL,
+                ZBUS_OBSERVERS_EMPTY,
+                ZBUS_MSG_INIT(.timestamp = 0)
+);
+
+ZTEST(pipeline_bench, test_stage_sensor_fill)
+{
+    const struct device *dev = FAKE_SENSOR_DEV;
+    struct sensor_data_msg sample;
+
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        uint64_t start = bench_now();
+
+        zassert_ok(fake_sensor_fill(dev, &sample, 1));
+        bench_samples[i] = bench_ns_since(start);
+    }
+
+    bench_report_latency("stage_sensor_fill", bench_samples, BENCH_ITERATIONS);
+}
+
+ZTEST(pipeline_bench, test_stage_sensor_read_decode)
+{
+    const struct device *dev = FAKE_SENSOR_DEV;
+    const struct sensor_decoder_api *decoder;
+    static uint32_t decode_samples[BENCH_ITERATIONS];
+    uint8_t buf[64];
+
+    zassert_ok(sensor_get_decoder(dev, &decoder));
+
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        struct sensor_q31_data data;
+        uint64_t start = bench_now();
+
+        zassert_ok(sensor_read(&bench_iodev, &bench_rtio, buf, sizeof(buf)));
+        uint64_t read_done = bench_now();
+
+        for (size_t c = 0; c < ARRAY_SIZE(bench_channels); c++) {
+            uint32_t fit = 0;
+
+            zassert_equal(decoder->decode(buf, bench_channels[c], &fit, 1, &data), 1);
+        }
+
+        bench_samples[i] = bench_ns_between(start, read_done);
+        decode_samples[i] = bench_ns_since(read_done);
+    }
+
+    bench_report_latency("stage_sensor_read", bench_samples, BENCH_ITERATIONS);
+    bench_report_latency("stage_decode", decode_samples, BENCH_ITERATIONS);
+}
+
+ZTEST(pipeline_bench, test_stage_history_append)
+{
+    struct sensor_data_msg sample = {
+        .temperature_centi_c = 2150,
+        .humidity_deci_pct = 455,
+        .pressure_pa_off = 51325,
+        .flags = SENSOR_SOURCE_INTERNAL
+    };
+
+    sample_history_init(&bench_history);
+
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        sample.timestamp += 100;
+
+        uint64_t start = bench_now();
+
+        sample_history_append(&bench_history, &sample);
+        bench_samples[i] = bench_ns_since(start);
+    }
+
+    bench_report_latency("stage_history_append", bench_samples, BENCH_ITERATIONS);
+}
+
+/* Decode a finished block, timing each sample; returns the block length */
+static uint32_t bench_codec_decode(struct sample_codec_encoder *enc,
+                                   const struct sample_record *records,
+                                   size_t first, size_t end, uint32_t *decode_samples)
+{
+    struct sample_codec_decoder dec;
+    struct sample_record rec;
+    uint32_t len = sample_codec_finish(enc);
+
+    zassert_ok(sample_codec_decoder_init(&dec, enc->buf, len));
+    for (size_t i = first; i < end; i++) {
+        uint64_t start = bench_now();
+
+        zassert_ok(sample_codec_decode(&dec, &rec));
+        decode_samples[i] = bench_ns_since(start);
+        zassert_equal(rec.time, records[i].time);
+    }
+
+    return len;
+}
+
+ZTEST(pipeline_bench, test_stage_codec)
+{
+    const struct device *dev = FAKE_SENSOR_DEV;
+    static struct sample_record records[BENCH_ITERATIONS];
+    static uint32_t decode_samples[BENCH_ITERATIONS];
+    static uint8_t block[256];
+    struct sample_codec_encoder enc;
+    struct sensor_data_msg sample;
+    uint32_t blocks = 1;
+    uint32_t bytes = 0;
+    size_t first = 0;
+
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        zassert_ok(fake_sensor_fill(dev, &sample, 1));
+        records[i] = (struct sample_record){
+            .time = i * 10000U,
+            .temperature_centi_c = sample.temperature_centi_c,
+            .humidity_deci_pct = sample.humidity_deci_pct,
+            .pressure_pa_off = sample.pressure_pa_off,
+            .flags = sample.flags,
+        };
+    }
+
+    // Blocks of the default flash log size, each decoded once it is full
+    sample_codec_encoder_init(&enc, block, sizeof(block));
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        uint64_t start = bench_now();
+        int rc = sample_codec_encode(&enc, &records[i]);
+
+        bench_samples[i] = bench_ns_since(start);
+        if (rc == -ENOSPC) {
+            bytes += bench_codec_decode(&enc, records, first, i, decode_samples);
+            blocks++;
+            first = i;
+
+            start = bench_now();
+            sample_codec_encoder_init(&enc, block, sizeof(block));
+            zassert_ok(sample_codec_encode(&enc, &records[i]));
+            bench_samples[i] = bench_ns_since(start);
+        }
+    }
+    bytes += bench_codec_decode(&enc, records, first, BENCH_ITERATIONS, decode_samples);
+
+    bench_report_latency("stage_codec_encode", bench_samples, BENCH_ITERATIONS);
+    bench_report_latency("stage_codec_decode", decode_samples, BENCH_ITERATIONS);
+    printk("BENCH codec_size samples=%u blocks=%u bytes=%u msg_bytes=%u\n",
+           BENCH_ITERATIONS, blocks, bytes,
+           (uint32_t)(BENCH_ITERATIONS * sizeof(struct sensor_data_msg)));
+}
+
+#if defined(CONFIG_WEATHER_STATION_FILTER)
+ZTEST(pipeline_bench, test_stage_filter)
+{
+    const struct device *dev = FAKE_SENSOR_DEV;
+    static struct sensor_data_msg samples[BENCH_ITERATIONS];
+    static struct sample_filter filter;
+    static const struct sample_filter_config config = SAMPLE_FILTER_CONFIG_DEFAULT;
+
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        zassert_ok(fake_sensor_fill(dev, &samples[i], 1));
+    }
+
+    // The configured chain on every channel, as run before each publish
+    sample_filter_init(&filter, &config);
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        uint64_t start = bench_now();
+
+        sample_filter_apply(&filter, &samples[i]);
+        bench_samples[i] = bench_ns_since(start);
+    }
+
+    bench_report_latency("stage_filter", bench_samples, BENCH_ITERATIONS);
+}
+#endif
+
+/*
+ * Derived metrics against the libm formulas they replace: the reference
+ * calls logf, expf and powf for every sample, the kernels use integer
+ * tables and polynomials. Errors are reported in thousandths of the unit.
+ */
+#define BENCH_ALTITUDE_M 500
+
+struct bench_derived_ref {
+    float dew_point;
+    float heat_index;
+    float abs_humidity;
+    float sea_level;
+};
+
+static float bench_heat_index_libm(float t, float rh)
+{
+    float f = t * 1.8f + 32.0f;
+    float hi = 0.5f * (f + 61.0f + (f - 68.0f) * 1.2f + rh * 0.094f);
+
+    if ((hi + f) / 2.0f >= 80.0f) {
+        hi = -42.379f + 2.04901523f * f + 10.14333127f * rh - 0.22475541f * f * rh -
+             0.00683783f * f * f - 0.05481717f * rh * rh + 0.00122874f * f * f * rh +
+             0.00085282f * f * rh * rh - 0.00000199f * f * f * rh * rh;
+        if (rh < 13.0f && f > 80.0f && f < 112.0f) {
+            hi -= ((13.0f - rh) / 4.0f) * sqrtf((17.0f - fabsf(f - 95.0f)) / 17.0f);
+        } else if (rh > 85.0f && f >= 80.0f && f <= 87.0f) {
+            hi += ((rh - 85.0f) / 10.0f) * ((87.0f - f) / 5.0f);
+        }
+    }
+
+    return (hi - 32.0f) / 1.8f;
+}
+
+static void bench_derived_libm(const struct sensor_data_msg *sample, struct bench_derived_ref *ref)
+{
+    float t = sample->temperature_centi_c / 100.0f;
+    float rh = sample->humidity_deci_pct / 10.0f;
+    float gamma = logf(rh / 100.0f) + 17.625f * t / (243.04f + t);
+    float svp = 610.94f * expf(17.625f * t / (243.04f + t));
+
+    ref->dew_point = 243.04f * gamma / (17.625f - gamma);
+    ref->heat_index = bench_heat_index_libm(t, rh);
+    ref->abs_humidity = svp * rh / 100.0f / (461.5f * (t + 273.15f)) * 1000.0f;
+    ref->sea_level = (float)sensor_data_pressure(sample) *
+                     powf(1.0f - 2.25577e-5f * BENCH_ALTITUDE_M, -5.25588f);
+}
+
+static uint32_t bench_milli_error(float value, float reference)
+{
+    return (uint32_t)(fabsf(value - reference) * 1000.0f + 0.5f);
+}
+
+ZTEST(pipeline_bench, test_stage_derived)
+{
+    static struct sensor_data_msg samples[BENCH_ITERATIONS];
+    static uint32_t libm_samples[BENCH_ITERATIONS];
+    struct derived_station station;
+    uint32_t err_dew = 0, err_heat = 0, err_rho = 0, err_p0 = 0;
+
+    derived_station_init(&station, BENCH_ALTITUDE_M);
+
+    // Spread over the range a station sees: -30 to 50 °C, 5 to 100 %
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        samples[i] = (struct sensor_data_msg){
+            .temperature_centi_c = (int16_t)(-3000 + (i * 7919U) % 8001U),
+            .humidity_deci_pct = (uint16_t)(50 + (i * 4099U) % 951U),
+            .pressure_pa_off = (uint16_t)(40000 + (i * 373U) % 15000U),
+            .flags = SENSOR_SOURCE_INTERNAL,
+        };
+    }
+
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        struct derived_data_msg out;
+        struct bench_derived_ref ref;
+        uint64_t start = bench_now();
+
+        derived_metrics_compute(&station, &samples[i], &out);
+        bench_samples[i] = bench_ns_since(start);
+
+        start = bench_now();
+        bench_derived_libm(&samples[i], &ref);
+        libm_samples[i] = bench_ns_since(start);
+
+        if (!(out.flags & DERIVED_FLAG_DEW_POINT_INVALID)) {
+            err_dew = MAX(err_dew, bench_milli_error(out.dew_point_centi_c / 100.0f,
+                                                     ref.dew_point));
+        }
+        // The regression is only meaningful up to its stated range
+        if (ref.heat_index < 70.0f) {
+            err_heat = MAX(err_heat, bench_milli_error(out.heat_index_centi_c / 100.0f,
+                                                       ref.heat_index));
+        }
+        err_rho = MAX(err_rho, bench_milli_error(out.abs_humidity_centi_g_m3 / 100.0f,
+                                                 ref.abs_humidity));
+        err_p0 = MAX(err_p0, bench_milli_error((float)out.sea_level_pa, ref.sea_level));
+    }
+
+    bench_report_latency("stage_derived_fixed", bench_samples, BENCH_ITERATIONS);
+    bench_report_latency("stage_derived_libm", libm_samples, BENCH_ITERATIONS);
+    printk("BENCH derived_error n=%u dew_point_mc=%u heat_index_mc=%u "
+           "abs_humidity_mg_m3=%u sea_level_mpa=%u\n",
+           BENCH_ITERATIONS, err_dew, err_heat, err_rho, err_p0);
+}
+
+ZTEST(pipeline_bench, test_stage_publish)
+{
+    struct sensor_data_msg sample = {0};
+
+    // No observers: the cost of zbus itself, copy and channel locking
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        sample.sequence = (uint16_t)i;
+
+        uint64_t start = bench_now();
+
+        zassert_ok(zbus_chan_pub(&bench_chan, &sample, K_NO_WAIT));
+        bench_samples[i] = bench_ns_since(start);
+    }
+
+    bench_report_latency("stage_publish", bench_samples, BENCH_ITERATIONS);
+}
+
+/*
+ * End to end: ws_trigger publish until the matching sample is published on
+ * ws_sensor_data, through the sensor_mgr acquisition and completion threads.
+ */
+
+static K_SEM_DEFINE(bench_data_sem, 0, 1);
+static uint64_t bench_data_time;
+static uint8_t bench_data_trigger_seq;
+
+static void bench_data_cb(const struct zbus_channel *chan)
+{
+    const struct sensor_data_msg *msg = zbus_chan_const_msg(chan);
+
+    bench_data_time = bench_now();
+    bench_data_trigger_seq = msg->trigger_seq;
+    k_sem_give(&bench_data_sem);
+}
+
+ZBUS_LISTENER_DEFINE(bench_data_lis, bench_data_cb);
+
+ZTEST(pipeline_bench, test_e2e_trigger_to_data)
+{
+    zassert_ok(zbus_chan_add_obs(ZBUS_REF(ws_sensor_data), &bench_data_lis, K_SECONDS(1)));
+
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        struct trigger_msg trigger = {
+            .source = TRIGGER_EXTERNAL,
+            .sequence = (uint32_t)i
+        };
+
+        k_sem_reset(&bench_data_sem);
+
+        uint64_t start = bench_now();
+
+        zassert_ok(zbus_chan_pub(ZBUS_REF(ws_trigger), &trigger, K_SECONDS(1)));
+        zassert_ok(k_sem_take(&bench_data_sem, K_SECONDS(1)), "no sample for trigger %u", i);
+        zassert_equal(bench_data_trigger_seq, (uint8_t)i);
+        bench_samples[i] = bench_ns_between(start, bench_data_time);
+    }
+
+    zassert_ok(zbus_chan_rm_obs(ZBUS_REF(ws_sensor_data), &bench_data_lis, K_SECONDS(1)));
+    bench_report_latency("e2e_trigger_to_data", bench_samples, BENCH_ITERATIONS);
+}
+
+/*
+ * Fan-out: message subscribers with their own threads, like the pipeline
+ * stages, attached to bench_chan in groups of 1, 2 and BENCH_OBSERVERS.
+ */
+
+static K_SEM_DEFINE(bench_rx_sem, 0, K_SEM_MAX_LIMIT);
+static uint64_t bench_rx_time[BENCH_OBSERVERS];
+
+static void bench_observer_thread(void *p1, void *p2, void *p3)
+{
+    const struct zbus_observer *sub = p1;
+    uint64_t *rx_time = p2;
+    const struct zbus_channel *chan;
+    struct sensor_data_msg msg;
+
+    ARG_UNUSED(p3);
+
+    while (true) {
+        if (zbus_sub_wait_msg(sub, &chan, &msg, K_FOREVER) == 0) {
+            *rx_time = bench_now();
+            k_sem_give(&bench_rx_sem);
+        }
+    }
+}
+
+#define BENCH_OBSERVER_DEFINE(i, _)                                                  \
+    ZBUS_MSG_SUBSCRIBER_DEFINE(bench_sub##i);                                        \
+    K_THREAD_DEFINE(bench_sub##i##_tid, 1024, bench_observer_thread,                 \
+                    (void *)&bench_sub##i, &bench_rx_time[i], NULL,                  \
+                    CONFIG_WEATHER_STATION_SENSOR_MGR_PRIORITY, 0, 0)
+
+#define BENCH_OBSERVER_REF(i, _) &bench_sub##i
+
+LISTIFY(BENCH_OBSERVERS, BENCH_OBSERVER_DEFINE, (;));
+
+static const struct zbus_observer *const bench_observers[] = {
+    LISTIFY(BENCH_OBSERVERS, BENCH_OBSERVER_REF, (,))
+};
+
+static void bench_observers_attach(uint32_t count, bool attach)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        if (attach) {
+            zassert_ok(zbus_chan_add_obs(&bench_chan, bench_observers[i], K_SECONDS(1)));
+        } else {
+            zassert_ok(zbus_chan_rm_obs(&bench_chan, bench_observers[i], K_SECONDS(1)));
+        }
+    }
+}
+
+static void bench_wait_delivered(uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        zassert_ok(k_sem_take(&bench_rx_sem, K_SECONDS(1)), "lost %u deliveries", count - i);
+    }
+}
+
+static void bench_fanout(uint32_t observers)
+{
+    struct sensor_data_msg sample = {0};
+    char name[32];
+
+    bench_observers_attach(observers, true);
+    k_sem_reset(&bench_rx_sem);
+
+    // Delivery latency: one message in flight, time until the last observer has it
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        sample.sequence = (uint16_t)i;
+
+        uint64_t start = bench_now();
+
+        zassert_ok(zbus_chan_pub(&bench_chan, &sample, K_SECONDS(1)));
+        bench_wait_delivered(observers);
+
+        uint64_t last = start;
+
+        for (uint32_t o = 0; o < observers; o++) {
+            last = MAX(last, bench_rx_time[o]);
+        }
+        bench_samples[i] = bench_ns_between(start, last);
+    }
+
+    snprintk(name, sizeof(name), "delivery_obs%u", observers);
+    bench_report_latency(name, bench_samples, BENCH_ITERATIONS);
+
+    // Throughput: publish back to back, then wait for every delivery
+    uint64_t start = bench_now();
+
+    for (uint32_t i = 0; i < BENCH_BURST; i++) {
+        sample.sequence = (uint16_t)i;
+        zassert_ok(zbus_chan_pub(&bench_chan, &sample, K_SECONDS(1)));
+    }
+    bench_wait_delivered(BENCH_BURST * observers);
+
+    bench_report_throughput("throughput", observers, BENCH_BURST, bench_ns_since(start));
+    bench_observers_attach(observers, false);
+}
+
+ZTEST(pipeline_bench, test_fanout_1)
+{
+    bench_fanout(1);
+}
+
+ZTEST(pipeline_bench, test_fanout_2)
+{
+    bench_fanout(2);
+}
+
+ZTEST(pipeline_bench, test_fanout_n)
+{
+    bench_fanout(BENCH_OBSERVERS);
+}
+
+static void *pipeline_bench_setup(void)
+{
+    struct fake_sensor_config cfg = {
+        .waveform = FAKE_SENSOR_WAVE_RANDOM_WALK,
+        .seed = CONFIG_WEATHER_STATION_FAKE_SENSOR_SEED,
+        .period = 64,
+        .quiet = true,
+    };
+
+    zassert_ok(fake_sensor_configure(FAKE_SENSOR_DEV, &cfg));
+    return NULL;
+}
+
+static void pipeline_bench_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    // Keep only the acquisition stage attached, the rest is measured in isolation
+    bench_app_observers_enable(false);
+    pub_policy_set_enable(&sensor_mgr_sub, true);
+}
+
+static void pipeline_bench_after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    bench_app_observers_enable(true);
+}
+
+ZTEST_SUITE(pipeline_bench, NULL, pipeline_bench_setup, pipeline_bench_before,
+            pipeline_bench_after, NULL);
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include "adaptive_rate.h"
+
+static struct adaptive_rate test_rate;
+
+static const struct adaptive_rate_config test_config = {
+    .min_ms = 1000,
+    .max_ms = 60000,
+    .threshold = {10, 10, 5},   /* 0.1 °C, 1 % and 5 Pa per minute */
+};
+
+static struct sensor_data_msg make_sample(uint8_t id, uint32_t timestamp, int16_t temp)
+{
+    return (struct sensor_data_msg){
+        .timestamp = timestamp,
+        .temperature_centi_c = temp,
+        .humidity_deci_pct = 450,
+        .pressure_pa_off = 51325,
+        .flags = SENSOR_SOURCE_INTERNAL | sensor_id_flags(id),
+    };
+}
+
+// Test setup function
+static void test_rate_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    adaptive_rate_init(&test_rate, &test_config, 10000);
+}
+
+/* Test cases for the adaptive sampling period */
+
+static void test_rate_bounds(void)
+{
+    adaptive_rate_init(&test_rate, &test_config, 0);
+    zassert_equal(test_rate.period_ms, 1000, "Clamped to the minimum");
+
+    adaptive_rate_init(&test_rate, &test_config, 3600000);
+    zassert_equal(test_rate.period_ms, 60000, "Clamped to the maximum");
+}
+
+static void test_rate_first_sample(void)
+{
+    struct sensor_data_msg msg = make_sample(0, 0, 2000);
+
+    zassert_equal(adaptive_rate_update(&test_rate, &msg), 10000, "No delta yet");
+    zassert_equal(test_rate.activity_pct, 0, "No activity yet");
+}
+
+static void test_rate_fast_change(void)
+{
+    struct sensor_data_msg msg = make_sample(0, 0, 2000);
+    uint32_t timestamp = 0;
+    uint32_t period = 10000;
+
+    adaptive_rate_update(&test_rate, &msg);
+
+    // 0.5 °C per sample is at least 3 °C per minute, far above 0.1 °C
+    for (int i = 1; i <= 8; i++) {
+        timestamp += period;
+        msg = make_sample(0, timestamp, (int16_t)(2000 + 50 * i));
+        period = adaptive_rate_update(&test_rate, &msg);
+    }
+
+    zassert_equal(period, 1000, "Should settle at the minimum period");
+    zassert_true(test_rate.activity_pct >= 100, "Change above the threshold");
+}
+
+static void test_rate_quiet(void)
+{
+    struct sensor_data_msg msg = make_sample(0, 0, 2000);
+    uint32_t timestamp = 0;
+    uint32_t period = 10000;
+
+    adaptive_rate_update(&test_rate, &msg);
+
+    // A one count change is quantisation and stays quiet
+    for (int i = 1; i < ADAPTIVE_RATE_QUIET_SAMPLES; i++) {
+        timestamp += period;
+        msg = make_sample(0, timestamp, (int16_t)(2000 + (i & 1)));
+        zassert_equal(adaptive_rate_update(&test_rate, &msg), 10000, "Not yet quiet long enough");
+    }
+
+    timestamp += period;
+    msg = make_sample(0, timestamp, 2000);
+    zassert_equal(adaptive_rate_update(&test_rate, &msg), 15000, "Stretched by half");
+
+    for (int i = 0; i < 10 * ADAPTIVE_RATE_QUIET_SAMPLES; i++) {
+        timestamp += period;
+        msg = make_sample(0, timestamp, 2000);
+        period = adaptive_rate_update(&test_rate, &msg);
+    }
+    zassert_equal(period, 60000, "Should settle at the maximum period");
+}
+
+static void test_rate_per_sensor(void)
+{
+    struct sensor_data_msg msg;
+
+    // Two steady sensors that disagree must not look like a fast change
+    for (int i = 0; i < 2 * ADAPTIVE_RATE_QUIET_SAMPLES; i++) {
+        msg = make_sample(0, 10000U * i, 2000);
+        adaptive_rate_update(&test_rate, &msg);
+        msg = make_sample(1, 10000U * i + 5, 2500);
+        adaptive_rate_add(&test_rate, &msg);
+        zassert_true(test_rate.activity_pct < ADAPTIVE_RATE_QUIET_PCT, "Sensors are steady");
+    }
+    zassert_true(test_rate.period_ms > 10000, "Period should stretch");
+}
+
+static void test_rate_once_per_read(void)
+{
+    struct sensor_data_msg msg;
+
+    // Three steady sensors stretch the period after as many reads as one would
+    for (int i = 0; i <= ADAPTIVE_RATE_QUIET_SAMPLES; i++) {
+        zassert_equal(test_rate.period_ms, 10000, "Stretched after %d reads", i);
+        msg = make_sample(1, 10000U * i, 2500);
+        adaptive_rate_add(&test_rate, &msg);
+        msg = make_sample(2, 10000U * i, 2400);
+        adaptive_rate_add(&test_rate, &msg);
+        msg = make_sample(0, 10000U * i, 2000);
+        adaptive_rate_update(&test_rate, &msg);
+    }
+    zassert_equal(test_rate.period_ms, 15000, "Stretched once");
+
+    // A fast change on another sensor decides the next read, then is cleared
+    msg = make_sample(1, 50000, 2600);
+    adaptive_rate_add(&test_rate, &msg);
+    msg = make_sample(0, 50000, 2000);
+    zassert_equal(adaptive_rate_update(&test_rate, &msg), 7500, "Halved by the fastest sensor");
+    zassert_true(test_rate.activity_pct >= 100, "Activity of the fastest sensor");
+
+    msg = make_sample(0, 57500, 2000);
+    zassert_equal(adaptive_rate_update(&test_rate, &msg), 7500, "Change not counted twice");
+    zassert_equal(test_rate.activity_pct, 0, "Only the primary sensor changed");
+}
+
+static void test_rate_invalid(void)
+{
+    struct sensor_data_msg msg = make_sample(0, 0, 2000);
+
+    adaptive_rate_update(&test_rate, &msg);
+
+    // Invalid fields and failed reads are ignored
+    msg = make_sample(0, 10000, -4000);
+    msg.flags |= SENSOR_FLAG_TEMP_INVALID;
+    zassert_equal(adaptive_rate_update(&test_rate, &msg), 10000, "Invalid temperature");
+    zassert_equal(test_rate.activity_pct, 0, "No valid change");
+
+    msg = make_sample(0, 20000, 3000);
+    msg.flags |= SENSOR_FLAG_ERROR;
+    zassert_equal(adaptive_rate_update(&test_rate, &msg), 10000, "Failed read");
+}
+
+/* ZTEST definitions */
+
+ZTEST(adaptive_rate, test_bounds)
+{
+    test_rate_bounds();
+}
+
+ZTEST(adaptive_rate, test_first_sample)
+{
+    test_rate_first_sample();
+}
+
+ZTEST(adaptive_rate, test_fast_change)
+{
+    test_rate_fast_change();
+}
+
+ZTEST(adaptive_rate, test_quiet)
+{
+    test_rate_quiet();
+}
+
+ZTEST(adaptive_rate, test_per_sensor)
+{
+    test_rate_per_sensor();
+}
+
+ZTEST(adaptive_rate, test_once_per_read)
+{
+    test_rate_once_per_read();
+}
+
+ZTEST(adaptive_rate, test_invalid)
+{
+    test_rate_invalid();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(adaptive_rate, NULL, NULL, test_rate_setup, NULL, NULL);
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include "block_index.h"
+
+BLOCK_INDEX_DEFINE(test_index, 8);
+
+/* Block n covers [n * 1000, n * 1000 + 900] and lives in sector n / 4 */
+static void push_blocks(uint32_t first, uint32_t count)
+{
+    for (uint32_t n = first; n < first + count; n++) {
+        struct block_index_entry entry = {
+            .first_time = n * 1000,
+            .last_time = n * 1000 + 900,
+            .offset = n * 100,
+            .len = 100,
+            .sector = (uint8_t)(n / 4),
+        };
+
+        block_index_push(&test_index, &entry);
+    }
+}
+
+// Test setup function
+static void test_index_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    block_index_reset(&test_index);
+}
+
+/* Test cases for the block index */
+
+static void test_index_find(void)
+{
+    struct block_index_entry entry;
+
+    zassert_equal(block_index_find(&test_index, 0), test_index.head, "Empty index finds nothing");
+
+    push_blocks(0, 6);
+
+    zassert_equal(block_index_find(&test_index, 0), 0, "Range start before the first block");
+    zassert_equal(block_index_find(&test_index, 2500), 2, "Inside block 2");
+    zassert_equal(block_index_find(&test_index, 2950), 3, "Gap after block 2");
+    zassert_equal(block_index_find(&test_index, 5900), 5, "End of the last block");
+    zassert_equal(block_index_find(&test_index, 6000), 6, "After the last block");
+
+    zassert_true(block_index_get(&test_index, 2, &entry), "Block 2 should be held");
+    zassert_equal(entry.offset, 200, "Entry should match");
+    zassert_false(block_index_get(&test_index, 6, &entry), "Position past the newest");
+}
+
+static void test_index_wraps(void)
+{
+    struct block_index_entry entry;
+
+    push_blocks(0, 12);
+
+    zassert_equal(block_index_count(&test_index), 8, "Index should be full");
+    zassert_false(block_index_get(&test_index, 3, &entry), "Oldest blocks should be dropped");
+    zassert_equal(block_index_find(&test_index, 0), 4, "Search starts at the oldest held");
+    zassert_equal(block_index_find(&test_index, 10100), 10, "Search across the wrap");
+    zassert_true(block_index_get(&test_index, 11, &entry), "Newest block should be held");
+    zassert_equal(entry.first_time, 11000, "Entry should match");
+}
+
+static void test_index_drop_sector(void)
+{
+    struct block_index_entry entry;
+
+    push_blocks(0, 8);
+
+    block_index_drop_sector(&test_index, 1);
+    zassert_equal(block_index_count(&test_index), 8, "Only the oldest sector can be dropped");
+
+    block_index_drop_sector(&test_index, 0);
+    zassert_equal(block_index_count(&test_index), 4, "Sector 0 blocks should be dropped");
+    zassert_false(block_index_get(&test_index, 0, &entry), "Dropped block should be gone");
+    zassert_equal(block_index_find(&test_index, 0), 4, "Search starts after the drop");
+}
+
+static void test_index_extend(void)
+{
+    struct block_index_entry entry;
+
+    zassert_false(block_index_extend(&test_index, 100), "Empty index has nothing to extend");
+
+    push_blocks(0, 2);
+
+    // Block 1 grows to cover [1000, 2500]
+    zassert_true(block_index_extend(&test_index, 2500), "Newest entry should be extended");
+    zassert_true(block_index_get(&test_index, 1, &entry), "Block 1 should be held");
+    zassert_equal(entry.last_time, 2500, "Range should be extended");
+    zassert_equal(block_index_find(&test_index, 2200), 1, "Extended range should be found");
+
+    block_index_extend(&test_index, 2000);
+    zassert_true(block_index_get(&test_index, 1, &entry), "Block 1 should be held");
+    zassert_equal(entry.last_time, 2500, "Range should never shrink");
+}
+
+static void test_index_time_wrap(void)
+{
+    uint64_t wrap = (uint64_t)UINT32_MAX + 1U;
+
+    // Sectors on both sides of the 32-bit wrap of the log time
+    for (uint32_t n = 0; n < 4; n++) {
+        struct block_index_entry entry = {
+            .first_time = wrap - 2000U + n * 1000U,
+            .last_time = wrap - 2000U + n * 1000U + 900U,
+            .sector = (uint8_t)n,
+        };
+
+        block_index_push(&test_index, &entry);
+    }
+
+    zassert_equal(block_index_find(&test_index, wrap - 1500U), 0, "Before the wrap");
+    zassert_equal(block_index_find(&test_index, wrap - 50U), 2, "Gap before the wrap");
+    zassert_equal(block_index_find(&test_index, wrap + 1200U), 3, "After the wrap");
+    zassert_equal(block_index_find(&test_index, 100), 0, "Low 32 bits are not mistaken");
+}
+
+/* ZTEST definitions */
+
+ZTEST(block_index, test_find)
+{
+    test_index_find();
+}
+
+ZTEST(block_index, test_wraps)
+{
+    test_index_wraps();
+}
+
+ZTEST(block_index, test_drop_sector)
+{
+    test_index_drop_sector();
+}
+
+ZTEST(block_index, test_extend)
+{
+    test_index_extend();
+}
+
+ZTEST(block_index, test_time_wrap)
+{
+    test_index_time_wrap();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(block_index, NULL, NULL, test_index_setup, NULL, NULL);
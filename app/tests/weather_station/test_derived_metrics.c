@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include "derived_metrics.h"
+
+/*
+ * Test cases for the fixed-point derived metrics. Expected values come from
+ * the floating-point formulas in derived_metrics.h, the tolerances are the
+ * error bounds stated there.
+ */
+
+static void test_derived_vapour_pressure(void)
+{
+    // Table entries are exact
+    zassert_equal(derived_vapour_pressure(2000), 233344, "Entry at 20 °C");
+    zassert_equal(derived_vapour_pressure(DERIVED_TEMP_MIN), 1897, "First entry");
+    zassert_equal(derived_vapour_pressure(DERIVED_TEMP_MAX), 2002300, "Last entry");
+
+    static const struct {
+        int32_t temp;
+        uint32_t expected;
+    } cases[] = {
+        {2050, 240666},
+        {-1230, 23876},
+        {3525, 569586},
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        uint32_t svp = derived_vapour_pressure(cases[i].temp);
+
+        zassert_within(svp, cases[i].expected, cases[i].expected * 12 / 10000,
+                       "Case %zu: %u", i, svp);
+    }
+}
+
+static void test_derived_dew_point(void)
+{
+    static const struct {
+        int32_t temp;
+        uint32_t humidity;
+        int32_t expected;
+    } cases[] = {
+        {2000, 500, 926},
+        {2500, 800, 2131},
+        {-1000, 600, -1630},
+        {550, 950, 476},
+        {3000, 100, -495},
+    };
+    int32_t dew;
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        zassert_ok(derived_dew_point(cases[i].temp, cases[i].humidity, &dew), "Case %zu", i);
+        zassert_within(dew, cases[i].expected, 3, "Case %zu: %d", i, dew);
+    }
+
+    // Saturated air is at its dew point
+    zassert_ok(derived_dew_point(1234, 1000, &dew), "Saturated");
+    zassert_within(dew, 1234, 3, "Dew point %d", dew);
+    zassert_true(dew <= 1234, "Dew point above the temperature");
+
+    zassert_equal(derived_dew_point(2000, 0, &dew), -EDOM, "Dry air has no dew point");
+    zassert_equal(derived_dew_point(7000, 500, &dew), -EDOM, "Temperature out of range");
+    zassert_equal(derived_dew_point(-3500, 300, &dew), -EDOM, "Dew point out of range");
+}
+
+static void test_derived_abs_humidity(void)
+{
+    static const struct {
+        int32_t temp;
+        uint32_t humidity;
+        uint32_t expected;
+    } cases[] = {
+        {2000, 500, 862},
+        {3000, 800, 2423},
+        {0, 1000, 485},
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        uint32_t rho = derived_abs_humidity(cases[i].temp, cases[i].humidity);
+
+        zassert_within(rho, cases[i].expected, cases[i].expected * 12 / 10000 + 1,
+                       "Case %zu: %u", i, rho);
+    }
+
+    zassert_equal(derived_abs_humidity(2000, 0), 0, "Dry air");
+}
+
+static void test_derived_heat_index(void)
+{
+    static const struct {
+        int32_t temp;
+        uint32_t humidity;
+        int32_t expected;
+    } cases[] = {
+        {1500, 500, 1386},      // Simple formula
+        {3200, 700, 4041},      // Regression
+        {4000, 100, 3671},      // Dry adjustment
+        {2800, 900, 3400},      // Humid adjustment
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        int32_t hi = derived_heat_index(cases[i].temp, cases[i].humidity);
+
+        zassert_within(hi, cases[i].expected, 3, "Case %zu: %d", i, hi);
+    }
+}
+
+static void test_derived_sea_level(void)
+{
+    struct derived_station station;
+
+    derived_station_init(&station, 0);
+    zassert_equal(derived_sea_level(&station, 101325), 101325, "No reduction at sea level");
+
+    static const struct {
+        int32_t altitude;
+        uint32_t expected;
+    } cases[] = {
+        {500, 100836},
+        {1500, 113840},
+        {-200, 92779},
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        derived_station_init(&station, cases[i].altitude);
+        uint32_t p0 = derived_sea_level(&station, 95000);
+
+        zassert_within(p0, cases[i].expected, 1, "Case %zu: %u", i, p0);
+    }
+
+    derived_station_init(&station, 20000);
+    zassert_equal(station.altitude_m, DERIVED_ALTITUDE_MAX, "Altitude clamped");
+}
+
+static void test_derived_compute(void)
+{
+    struct derived_station station;
+    struct sensor_data_msg sample = {
+        .timestamp = 1000,
+        .sequence = 7,
+        .temperature_centi_c = 2000,
+        .humidity_deci_pct = 500,
+        .pressure_pa_off = 101325 - SENSOR_PRESSURE_BASE_PA,
+        .flags = SENSOR_SOURCE_INTERNAL | sensor_id_flags(3),
+    };
+    struct derived_data_msg out;
+
+    derived_station_init(&station, 0);
+    derived_metrics_compute(&station, &sample, &out);
+
+    zassert_equal(out.timestamp, 1000, "Timestamp of the sample");
+    zassert_equal(out.sequence, 7, "Sequence of the sample");
+    zassert_equal(out.flags, sensor_id_flags(3), "All valid, sensor id kept");
+    zassert_within(out.dew_point_centi_c, 926, 3, "Dew point");
+    zassert_within(out.heat_index_centi_c, 1936, 3, "Heat index");
+    zassert_within(out.abs_humidity_centi_g_m3, 862, 2, "Absolute humidity");
+    zassert_equal(out.sea_level_pa, 101325, "Sea-level pressure");
+
+    sample.flags |= SENSOR_FLAG_HUMIDITY_INVALID | SENSOR_FLAG_PRESSURE_INVALID;
+    derived_metrics_compute(&station, &sample, &out);
+
+    zassert_equal(out.flags & ~SENSOR_ID_MASK,
+                  DERIVED_FLAG_DEW_POINT_INVALID | DERIVED_FLAG_HEAT_INDEX_INVALID |
+                  DERIVED_FLAG_ABS_HUMIDITY_INVALID | DERIVED_FLAG_SEA_LEVEL_INVALID,
+                  "Metrics of invalid fields flagged");
+}
+
+/* ZTEST definitions */
+
+ZTEST(derived_metrics, test_vapour_pressure)
+{
+    test_derived_vapour_pressure();
+}
+
+ZTEST(derived_metrics, test_dew_point)
+{
+    test_derived_dew_point();
+}
+
+ZTEST(derived_metrics, test_abs_humidity)
+{
+    test_derived_abs_humidity();
+}
+
+ZTEST(derived_metrics, test_heat_index)
+{
+    test_derived_heat_index();
+}
+
+ZTEST(derived_metrics, test_sea_level)
+{
+    test_derived_sea_level();
+}
+
+ZTEST(derived_metrics, test_compute)
+{
+    test_derived_compute();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(derived_metrics, NULL, NULL, NULL, NULL, NULL);
@@ -21,8 +21,8 @@ static void mock_display_mgr_sensor_data_handler(const struct zbus_channel *chan
     last_received_data = *msg;
 
     // In tests, we'll verify the data rather than logging it
-    LOG_DBG("Test: Sensor data received (seq: %u, temp: %.1f°C)",
-           msg->sequence, msg->temperature_c);
+    LOG_DBG("Test: Sensor data received (seq: %u, temp: %d centi-°C)",
+           msg->sequence, msg->temperature_centi_c);
 }
 
 ZBUS_LISTENER_DEFINE(test_display_listener, mock_display_mgr_sensor_data_handler);
@@ -66,12 +66,11 @@ static void test_display_sensor_data_reception(void)
 {
     struct sensor_data_msg test_data = {
         .timestamp = 123456,
-        .temperature_c = 22.5f,
-        .humidity_percent = 45.0f,
-        .pressure_pa = 101325.0f,
-        .source_flags = SENSOR_SOURCE_INTERNAL,
-        .sequence = 1,
-        .status = 0
+        .temperature_centi_c = 2250,
+        .humidity_deci_pct = 450,
+        .pressure_pa_off = 101325 - SENSOR_PRESSURE_BASE_PA,
+        .flags = SENSOR_SOURCE_INTERNAL,
+        .sequence = 1
     };
 
     // Publish test data to the sensor data channel
@@ -84,33 +83,30 @@ static void test_display_sensor_data_reception(void)
     // Verify the data was received and processed
     zassert_equal(sensor_data_received_count, 1, "Should have received exactly one sensor data message");
     zassert_equal(last_received_data.sequence, test_data.sequence, "Sequence number should match");
-    zassert_equal(last_received_data.temperature_c, test_data.temperature_c, "Temperature should match");
-    zassert_equal(last_received_data.humidity_percent, test_data.humidity_percent, "Humidity should match");
-    zassert_equal(last_received_data.pressure_pa, test_data.pressure_pa, "Pressure should match");
-    zassert_equal(last_received_data.source_flags, test_data.source_flags, "Source flags should match");
-    zassert_equal(last_received_data.status, test_data.status, "Status should match");
+    zassert_equal(last_received_data.temperature_centi_c, test_data.temperature_centi_c, "Temperature should match");
+    zassert_equal(last_received_data.humidity_deci_pct, test_data.humidity_deci_pct, "Humidity should match");
+    zassert_equal(last_received_data.pressure_pa_off, test_data.pressure_pa_off, "Pressure should match");
+    zassert_equal(last_received_data.flags, test_data.flags, "Flags should match");
 }
 
 static void test_display_multiple_data_messages(void)
 {
     struct sensor_data_msg test_data1 = {
         .timestamp = 1000,
-        .temperature_c = 20.0f,
-        .humidity_percent = 50.0f,
-        .pressure_pa = 101000.0f,
-        .source_flags = SENSOR_SOURCE_INTERNAL,
-        .sequence = 1,
-        .status = 0
+        .temperature_centi_c = 2000,
+        .humidity_deci_pct = 500,
+        .pressure_pa_off = 101000 - SENSOR_PRESSURE_BASE_PA,
+        .flags = SENSOR_SOURCE_INTERNAL,
+        .sequence = 1
     };
 
     struct sensor_data_msg test_data2 = {
         .timestamp = 2000,
-        .temperature_c = 25.0f,
-        .humidity_percent = 40.0f,
-        .pressure_pa = 102000.0f,
-        .source_flags = SENSOR_SOURCE_EXTERNAL,
-        .sequence = 2,
-        .status = 0
+        .temperature_centi_c = 2500,
+        .humidity_deci_pct = 400,
+        .pressure_pa_off = 102000 - SENSOR_PRESSURE_BASE_PA,
+        .flags = SENSOR_SOURCE_EXTERNAL,
+        .sequence = 2
     };
 
     // Publish first message
@@ -127,19 +123,18 @@ static void test_display_multiple_data_messages(void)
     // Verify both messages were received
     zassert_equal(sensor_data_received_count, 2, "Should have received exactly two sensor data messages");
     zassert_equal(last_received_data.sequence, test_data2.sequence, "Last sequence should be from second message");
-    zassert_equal(last_received_data.temperature_c, test_data2.temperature_c, "Last temperature should be from second message");
+    zassert_equal(last_received_data.temperature_centi_c, test_data2.temperature_centi_c, "Last temperature should be from second message");
 }
 
 static void test_display_error_status_handling(void)
 {
     struct sensor_data_msg test_data = {
         .timestamp = 9999,
-        .temperature_c = 0.0f,
-        .humidity_percent = 0.0f,
-        .pressure_pa = 0.0f,
-        .source_flags = SENSOR_SOURCE_INTERNAL,
-        .sequence = 100,
-        .status = -EINVAL  // Error status
+        .temperature_centi_c = 0,
+        .humidity_deci_pct = 0,
+        .pressure_pa_off = 0,
+        .flags = SENSOR_SOURCE_INTERNAL | SENSOR_FLAG_ERROR,  // Error status
+        .sequence = 100
     };
 
     // Publish error data
@@ -151,7 +146,7 @@ static void test_display_error_status_handling(void)
 
     // Verify error data was received and processed
     zassert_equal(sensor_data_received_count, 1, "Should have received error data message");
-    zassert_equal(last_received_data.status, -EINVAL, "Error status should be preserved");
+    zassert_true(last_received_data.flags & SENSOR_FLAG_ERROR, "Error status should be preserved");
     zassert_equal(last_received_data.sequence, test_data.sequence, "Sequence should match even for error data");
 }
 
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include "load_match.h"
+
+#define TEST_CAPACITY 8
+
+static struct load_match test_match = LOAD_MATCH_INIT(TEST_CAPACITY);
+
+/* Send count messages, message i stamped at 100 * i */
+static void send_messages(uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        zassert_equal(load_match_sent(&test_match, i, 100U * i), 0, "Message %u sent", i);
+    }
+}
+
+// Test setup function
+static void test_match_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    load_match_start(&test_match, 1000, UINT16_MAX, false);
+}
+
+/* Test cases for the load generator message matching */
+
+static void test_match_one_by_one(void)
+{
+    send_messages(3);
+    zassert_equal(test_match.outstanding, 3, "Every message outstanding");
+
+    // Each sample serves only the message it names
+    zassert_equal(load_match_delivered(&test_match, 1000, 0, 50), 1, "Message 0 served");
+    zassert_equal(load_match_delivered(&test_match, 1002, 0, 450), 1, "Message 2 served");
+    zassert_equal(test_match.outstanding, 1, "Message 1 still outstanding");
+
+    // Once passed, a message can no longer be matched
+    zassert_equal(load_match_delivered(&test_match, 1001, 0, 500), 0, "Message 1 passed");
+    zassert_equal(load_match_delivered(&test_match, 1002, 0, 500), 0, "Message 2 served once");
+
+    zassert_equal(load_match_collect(&test_match), 2, "Two messages delivered");
+    zassert_equal(test_match.cycles[0], 50, "Latency of message 0");
+    zassert_equal(test_match.cycles[1], 250, "Latency of message 2");
+}
+
+static void test_match_folded(void)
+{
+    load_match_start(&test_match, 1000, UINT16_MAX, true);
+    send_messages(5);
+    load_match_failed(&test_match, 1);
+
+    // A read serves every pending trigger up to the one it names
+    zassert_equal(load_match_delivered(&test_match, 1003, 0, 400), 3, "Folded triggers served");
+    zassert_equal(test_match.outstanding, 1, "Trigger 4 still outstanding");
+    zassert_equal(test_match.state[1], LOAD_MATCH_FAILED, "Failed trigger not served");
+
+    zassert_equal(load_match_delivered(&test_match, 1004, 0, 450), 1, "Last trigger served");
+    zassert_equal(test_match.outstanding, 0, "Run drained");
+
+    zassert_equal(load_match_collect(&test_match), 4, "Four triggers delivered");
+    zassert_equal(test_match.cycles[0], 50, "Sorted latencies");
+    zassert_equal(test_match.cycles[3], 400, "Oldest trigger has the longest latency");
+}
+
+static void test_match_folded_count(void)
+{
+    // Samples carry the low byte of the trigger sequence: 254, 255, 0, 1, 2
+    load_match_start(&test_match, 254, UINT8_MAX, true);
+    send_messages(5);
+
+    // The read started for trigger 0 had triggers 1 and 2 folded into it
+    zassert_equal(load_match_delivered(&test_match, 254, 2, 300), 3, "Folded triggers served");
+    zassert_equal(test_match.cycles[2], 100, "Latency of the last folded trigger");
+
+    // The count may include triggers of other sources, it never runs past sent
+    zassert_equal(load_match_delivered(&test_match, 1, 5, 500), 2, "Triggers 3 and 4 served");
+    zassert_equal(test_match.outstanding, 0, "Run drained");
+
+    // Another sample of a passed read is not mistaken for a later trigger
+    zassert_equal(load_match_delivered(&test_match, 254, 0, 600), 0, "Passed read ignored");
+}
+
+static void test_match_wraparound(void)
+{
+    load_match_start(&test_match, UINT16_MAX - 1, UINT16_MAX, false);
+    send_messages(4);
+
+    // Sequences 65534, 65535, 0, 1
+    zassert_equal(load_match_delivered(&test_match, 0, 0, 250), 1, "Sequence 0 is message 2");
+    zassert_equal(test_match.state[2], LOAD_MATCH_DONE, "Message 2 served");
+    zassert_equal(load_match_delivered(&test_match, 1, 0, 350), 1, "Sequence 1 is message 3");
+    zassert_equal(load_match_delivered(&test_match, UINT16_MAX, 0, 400), 0, "Message 1 passed");
+    zassert_equal(test_match.outstanding, 2, "Messages 0 and 1 lost");
+}
+
+static void test_match_ignored(void)
+{
+    send_messages(2);
+
+    // Samples of the periodic schedule and messages not sent yet
+    zassert_equal(load_match_delivered(&test_match, 999, 0, 10), 0, "Before the run");
+    zassert_equal(load_match_delivered(&test_match, 1002, 0, 10), 0, "Not sent yet");
+    zassert_equal(load_match_delivered(&test_match, 1000 + 0x8000, 0, 10), 0, "Far away");
+    zassert_equal(test_match.outstanding, 2, "Nothing matched");
+
+    zassert_equal(load_match_sent(&test_match, TEST_CAPACITY, 0), -ENOSPC, "Past capacity");
+}
+
+static void test_match_drain_timeout(void)
+{
+    send_messages(4);
+    load_match_failed(&test_match, 3);
+    zassert_equal(load_match_delivered(&test_match, 1000, 0, 40), 1, "Message 0 served");
+
+    // The run ends with messages 1 and 2 missing: lost, not delivered
+    zassert_equal(test_match.outstanding, 2, "Two messages outstanding");
+    zassert_equal(load_match_collect(&test_match), 1, "Only message 0 delivered");
+
+    // A sample arriving after the run was collected leaves it alone
+    zassert_equal(load_match_delivered(&test_match, 1002, 0, 500), 0, "Late sample ignored");
+    zassert_equal(test_match.cycles[0], 40, "Latencies kept");
+}
+
+static void test_match_percentile(void)
+{
+    uint32_t sorted[100];
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(sorted); i++) {
+        sorted[i] = i + 1;
+    }
+
+    // Nearest rank: the smallest value with at least pct percent at or below it
+    zassert_equal(load_match_percentile(sorted, 100, 50), 50, "p50 of 100");
+    zassert_equal(load_match_percentile(sorted, 100, 99), 99, "p99 of 100");
+    zassert_equal(load_match_percentile(sorted, 100, 100), 100, "p100 is the maximum");
+    zassert_equal(load_match_percentile(sorted, 100, 0), 1, "p0 is the minimum");
+    zassert_equal(load_match_percentile(sorted, 10, 90), 9, "p90 of 10");
+    zassert_equal(load_match_percentile(sorted, 10, 99), 10, "p99 of 10 rounds up");
+    zassert_equal(load_match_percentile(sorted, 1, 50), 1, "Single value");
+    zassert_equal(load_match_percentile(sorted, 0, 50), 0, "No values");
+}
+
+/* ZTEST definitions */
+
+ZTEST(load_match, test_one_by_one)
+{
+    test_match_one_by_one();
+}
+
+ZTEST(load_match, test_folded)
+{
+    test_match_folded();
+}
+
+ZTEST(load_match, test_folded_count)
+{
+    test_match_folded_count();
+}
+
+ZTEST(load_match, test_wraparound)
+{
+    test_match_wraparound();
+}
+
+ZTEST(load_match, test_ignored)
+{
+    test_match_ignored();
+}
+
+ZTEST(load_match, test_drain_timeout)
+{
+    test_match_drain_timeout();
+}
+
+ZTEST(load_match, test_percentile)
+{
+    test_match_percentile();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(load_match, NULL, NULL, test_match_setup, NULL, NULL);
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include <string.h>
+#include "log_block.h"
+
+/* Entries as the boot scan sees them, oldest first */
+static uint8_t test_entries[6][128];
+static uint32_t test_entry_len[6];
+
+/* A sample block of count samples, one per second from first_time */
+static void make_block(int n, uint32_t sequence, uint64_t first_time, uint16_t count)
+{
+    struct flash_log_block_hdr hdr = {
+        .sequence = sequence,
+        .first_time = first_time,
+        .last_time = first_time + (count - 1U) * 1000U,
+        .count = count,
+        .format = FLASH_LOG_FORMAT_CODEC,
+    };
+    struct sample_codec_encoder enc;
+
+    sample_codec_encoder_init(&enc, &test_entries[n][sizeof(hdr)],
+                              sizeof(test_entries[n]) - sizeof(hdr));
+    for (uint16_t i = 0; i < count; i++) {
+        struct sample_record rec = {
+            .time = first_time + i * 1000U,
+            .temperature_centi_c = (int16_t)(2000 + i),
+            .humidity_deci_pct = 500,
+            .pressure_pa_off = 51325,
+        };
+
+        sample_codec_encode(&enc, &rec);
+    }
+
+    memcpy(test_entries[n], &hdr, sizeof(hdr));
+    test_entry_len[n] = sizeof(hdr) + sample_codec_finish(&enc);
+}
+
+/* The block written by "ws log clear" */
+static void make_marker(int n, uint32_t sequence, uint64_t time)
+{
+    struct flash_log_block_hdr hdr = {
+        .sequence = sequence,
+        .first_time = time,
+        .last_time = time,
+        .format = FLASH_LOG_FORMAT_MARK,
+    };
+
+    memset(test_entries[n], 0, sizeof(test_entries[n]));
+    memcpy(test_entries[n], &hdr, sizeof(hdr));
+    test_entry_len[n] = sizeof(hdr);
+}
+
+static void scan_entries(struct log_block_scan *scan, int count)
+{
+    log_block_scan_init(scan);
+    for (int n = 0; n < count; n++) {
+        log_block_scan_add(scan, test_entries[n], MIN(test_entry_len[n], LOG_BLOCK_PREFIX_SIZE),
+                           test_entry_len[n]);
+    }
+}
+
+// Test setup function
+static void test_log_block_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    memset(test_entries, 0, sizeof(test_entries));
+    memset(test_entry_len, 0, sizeof(test_entry_len));
+}
+
+/* Test cases for the flash log blocks and boot scan */
+
+static void test_log_block_newest(void)
+{
+    struct log_block_scan scan;
+    uint32_t next_sequence;
+    uint64_t time_base;
+
+    make_block(0, 7, 10000, 5);
+    make_block(1, 8, 15000, 5);
+
+    scan_entries(&scan, 2);
+    zassert_true(log_block_scan_has_samples(&scan), "Sample blocks should be found");
+    zassert_equal(scan.newest.sequence, 8, "Newest block should win");
+    zassert_equal(scan.blocks, 2, "Every entry should be counted");
+    zassert_equal(scan.invalid, 0, "Both entries are blocks");
+
+    log_block_scan_resume(&scan, &next_sequence, &time_base);
+    zassert_equal(next_sequence, 9, "Numbering should carry on");
+    zassert_equal(time_base, 19001, "Log time should carry on after the last sample");
+}
+
+static void test_log_block_partial_ignored(void)
+{
+    struct log_block_scan scan;
+    struct flash_log_block_hdr hdr;
+
+    make_block(0, 3, 1000, 4);
+    make_block(1, 4, 5000, 4);
+    // Last block cut short: the header promises more than the entry holds
+    make_block(2, 5, 9000, 4);
+    test_entry_len[2] -= 2;
+    // Too short to even hold a header
+    make_block(3, 6, 13000, 4);
+    test_entry_len[3] = sizeof(hdr) - 1;
+
+    zassert_equal(log_block_check(test_entries[2], LOG_BLOCK_PREFIX_SIZE, test_entry_len[2],
+                                  &hdr), -EBADMSG, "Truncated block should be rejected");
+
+    scan_entries(&scan, 4);
+    zassert_equal(scan.newest.sequence, 4, "Newest complete block should win");
+    zassert_equal(scan.invalid, 2, "Partial entries should be skipped");
+}
+
+static void test_log_block_torn_ignored(void)
+{
+    struct log_block_scan scan;
+    struct flash_log_block_hdr hdr;
+
+    make_block(0, 10, 1000, 3);
+    // Header written, payload still erased
+    make_block(1, 11, 4000, 3);
+    memset(&test_entries[1][sizeof(hdr)], 0xff, sizeof(test_entries[1]) - sizeof(hdr));
+    // Count disagrees with the codec block
+    make_block(2, 12, 7000, 3);
+    test_entries[2][offsetof(struct flash_log_block_hdr, count)] = 2;
+    // Unknown format
+    make_block(3, 13, 10000, 3);
+    test_entries[3][offsetof(struct flash_log_block_hdr, format)] = 0xff;
+
+    scan_entries(&scan, 4);
+    zassert_equal(scan.newest.sequence, 10, "Only the intact block should count");
+    zassert_equal(scan.invalid, 3, "Torn entries should be skipped");
+
+    zassert_equal(log_block_check(test_entries[1], LOG_BLOCK_PREFIX_SIZE, test_entry_len[1],
+                                  &hdr), -EBADMSG, "Erased payload should be rejected");
+}
+
+static void test_log_block_empty(void)
+{
+    struct log_block_scan scan;
+    uint32_t next_sequence = 1;
+    uint64_t time_base = 1;
+
+    scan_entries(&scan, 0);
+    zassert_false(scan.found, "Empty log has no newest block");
+    log_block_scan_resume(&scan, &next_sequence, &time_base);
+    zassert_equal(next_sequence, 0, "Empty log starts at block 0");
+    zassert_equal(time_base, 0, "Empty log starts at time 0");
+}
+
+static void test_log_block_clear_marker(void)
+{
+    struct log_block_scan scan;
+    struct flash_log_block_hdr hdr;
+    uint32_t next_sequence;
+    uint64_t time_base;
+
+    // A cleared log holds only the marker
+    make_marker(0, 20, 50000);
+    zassert_equal(log_block_check(test_entries[0], test_entry_len[0], test_entry_len[0], &hdr),
+                  -ENODATA, "Marker holds no samples");
+
+    scan_entries(&scan, 1);
+    zassert_true(scan.found, "Marker should be found");
+    zassert_false(log_block_scan_has_samples(&scan), "Cleared log has no samples");
+    log_block_scan_resume(&scan, &next_sequence, &time_base);
+    zassert_equal(next_sequence, 21, "Numbering should carry on after a clear");
+    zassert_equal(time_base, 50001, "Log time should carry on after a clear");
+
+    // Blocks written after the clear
+    make_block(1, 21, 52000, 2);
+    scan_entries(&scan, 2);
+    zassert_true(log_block_scan_has_samples(&scan), "New block should be found");
+    zassert_equal(scan.newest.sequence, 21, "Block after the marker should win");
+}
+
+static void test_log_block_time_wrap(void)
+{
+    struct log_block_scan scan;
+    struct flash_log_block_hdr hdr;
+    struct sample_codec_decoder dec;
+    struct sample_codec_encoder enc;
+    struct sample_record rec;
+    uint32_t next_sequence;
+    uint64_t time_base;
+    uint64_t wrap = (uint64_t)UINT32_MAX + 1U;
+
+    // After 49.7 days of sampling the log time passes 32 bits
+    make_block(0, 30, wrap - 3000U, 4);
+    make_block(1, 31, wrap + 2000U, 4);
+    zassert_equal(log_block_check(test_entries[0], LOG_BLOCK_PREFIX_SIZE, test_entry_len[0],
+                                  &hdr), 0, "Block spanning the wrap should be accepted");
+    zassert_equal(hdr.last_time, wrap, "Range should run past 32 bits");
+
+    zassert_ok(sample_codec_decoder_init(&dec, &test_entries[0][sizeof(hdr)],
+                                         test_entry_len[0] - sizeof(hdr)), "Codec block");
+    for (int i = 0; i < 4; i++) {
+        zassert_ok(sample_codec_decode(&dec, &rec), "Sample %d", i);
+        zassert_equal(rec.time, wrap - 3000U + i * 1000U, "Time of sample %d", i);
+    }
+
+    scan_entries(&scan, 2);
+    zassert_equal(scan.invalid, 0, "Both blocks should be valid");
+    log_block_scan_resume(&scan, &next_sequence, &time_base);
+    zassert_equal(time_base, wrap + 5001U, "Log time should carry on past 32 bits");
+
+    // A gap the 32-bit deltas cannot code ends the block
+    sample_codec_encoder_init(&enc, test_entries[2], sizeof(test_entries[2]));
+    rec.time = 1000;
+    zassert_ok(sample_codec_encode(&enc, &rec), "First sample");
+    rec.time += (uint64_t)INT32_MAX + 1U;
+    zassert_equal(sample_codec_encode(&enc, &rec), -ENOSPC, "Gap too long for one block");
+}
+
+/* ZTEST definitions */
+
+ZTEST(log_block, test_newest)
+{
+    test_log_block_newest();
+}
+
+ZTEST(log_block, test_partial_ignored)
+{
+    test_log_block_partial_ignored();
+}
+
+ZTEST(log_block, test_torn_ignored)
+{
+    test_log_block_torn_ignored();
+}
+
+ZTEST(log_block, test_empty)
+{
+    test_log_block_empty();
+}
+
+ZTEST(log_block, test_clear_marker)
+{
+    test_log_block_clear_marker();
+}
+
+ZTEST(log_block, test_time_wrap)
+{
+    test_log_block_time_wrap();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(log_block, NULL, NULL, test_log_block_setup, NULL, NULL);
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include "msg_ring.h"
+#include "messages.h"
+
+#define TEST_SLOTS 3
+
+static struct msg_ring test_ring = MSG_RING_INIT(struct sensor_data_msg, TEST_SLOTS);
+
+static struct sensor_data_msg make_sample(uint16_t sequence)
+{
+    return (struct sensor_data_msg){
+        .timestamp = 1000U * sequence,
+        .sequence = sequence,
+        .temperature_centi_c = (int16_t)(2000 + sequence),
+        .flags = SENSOR_SOURCE_INTERNAL,
+    };
+}
+
+/* Put sample sequence, stamped with its sequence */
+static int put_sample(uint16_t sequence, bool overwrite)
+{
+    struct sensor_data_msg msg = make_sample(sequence);
+
+    return msg_ring_put(&test_ring, sequence, &msg, overwrite);
+}
+
+/* Take the oldest sample and check its sequence */
+static void expect_sample(uint16_t sequence)
+{
+    struct sensor_data_msg msg;
+    uint32_t stamp;
+
+    zassert_equal(msg_ring_peek(&test_ring, &stamp), 0, "Sample %u queued", sequence);
+    zassert_equal(stamp, sequence, "Stamp of sample %u", sequence);
+    zassert_equal(msg_ring_get(&test_ring, &msg), 0, "Sample %u taken", sequence);
+    zassert_equal(msg.sequence, sequence, "Oldest sample first");
+    zassert_equal(msg.temperature_centi_c, 2000 + sequence, "Whole message copied");
+}
+
+// Test setup function
+static void test_ring_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    msg_ring_clear(&test_ring);
+}
+
+/* Test cases for the subscriber message ring */
+
+static void test_ring_empty(void)
+{
+    struct sensor_data_msg msg;
+    uint32_t stamp;
+
+    zassert_equal(msg_ring_peek(&test_ring, &stamp), -ENODATA, "Empty ring");
+    zassert_equal(msg_ring_get(&test_ring, &msg), -ENODATA, "Nothing to take");
+    zassert_true(msg_ring_has_room(&test_ring), "Room in an empty ring");
+}
+
+static void test_ring_fifo(void)
+{
+    // Enough puts and gets to wrap around the slots twice
+    for (uint16_t i = 0; i < 2 * TEST_SLOTS; i += 2) {
+        zassert_equal(put_sample(i, false), 0, "Room for sample %u", i);
+        zassert_equal(put_sample(i + 1, false), 0, "Room for sample %u", i + 1);
+        expect_sample(i);
+        expect_sample(i + 1);
+    }
+    zassert_equal(test_ring.count, 0, "Every sample taken");
+}
+
+static void test_ring_drop_newest(void)
+{
+    for (uint16_t i = 0; i < TEST_SLOTS; i++) {
+        zassert_equal(put_sample(i, false), 0, "Room for sample %u", i);
+    }
+
+    // A full ring keeps what it has
+    zassert_false(msg_ring_has_room(&test_ring), "Ring is full");
+    zassert_equal(put_sample(TEST_SLOTS, false), -ENOBUFS, "Newest sample refused");
+    zassert_equal(test_ring.count, TEST_SLOTS, "Bound kept");
+
+    for (uint16_t i = 0; i < TEST_SLOTS; i++) {
+        expect_sample(i);
+    }
+}
+
+static void test_ring_drop_oldest(void)
+{
+    for (uint16_t i = 0; i < TEST_SLOTS; i++) {
+        zassert_equal(put_sample(i, true), 0, "Room for sample %u", i);
+    }
+
+    // Each put past the bound replaces the oldest sample
+    zassert_equal(put_sample(TEST_SLOTS, true), 1, "Oldest sample replaced");
+    zassert_equal(put_sample(TEST_SLOTS + 1, true), 1, "Oldest sample replaced");
+    zassert_equal(test_ring.count, TEST_SLOTS, "Bound kept");
+
+    for (uint16_t i = 2; i < TEST_SLOTS + 2; i++) {
+        expect_sample(i);
+    }
+}
+
+static void test_ring_reserve(void)
+{
+    // Reservations hold room for later puts, up to the bound
+    zassert_equal(put_sample(0, false), 0, "Room for sample 0");
+    for (int i = 1; i < TEST_SLOTS; i++) {
+        zassert_equal(msg_ring_reserve(&test_ring), 0, "Reservation %d", i);
+    }
+    zassert_false(msg_ring_has_room(&test_ring), "Every free slot promised");
+    zassert_equal(msg_ring_reserve(&test_ring), -ENOBUFS, "No room left to reserve");
+
+    // A put uses up a reservation, a release gives one back
+    zassert_equal(put_sample(1, false), 0, "Reserved put");
+    zassert_equal(test_ring.reserved, TEST_SLOTS - 2, "Reservation used");
+    msg_ring_release(&test_ring);
+    zassert_equal(test_ring.reserved, TEST_SLOTS - 3, "Reservation given back");
+    zassert_true(msg_ring_has_room(&test_ring), "Released slot is free again");
+
+    msg_ring_release(&test_ring);
+    zassert_equal(test_ring.reserved, 0, "Release without a reservation");
+
+    // Taking a message makes room
+    zassert_equal(put_sample(2, false), 0, "Room for sample 2");
+    zassert_equal(msg_ring_reserve(&test_ring), -ENOBUFS, "Ring is full");
+    expect_sample(0);
+    zassert_equal(msg_ring_reserve(&test_ring), 0, "Room after a get");
+
+    msg_ring_clear(&test_ring);
+    zassert_equal(test_ring.count, 0, "Messages cleared");
+    zassert_equal(test_ring.reserved, 0, "Reservations cleared");
+}
+
+/* ZTEST definitions */
+
+ZTEST(msg_ring, test_empty)
+{
+    test_ring_empty();
+}
+
+ZTEST(msg_ring, test_fifo)
+{
+    test_ring_fifo();
+}
+
+ZTEST(msg_ring, test_drop_newest)
+{
+    test_ring_drop_newest();
+}
+
+ZTEST(msg_ring, test_drop_oldest)
+{
+    test_ring_drop_oldest();
+}
+
+ZTEST(msg_ring, test_reserve)
+{
+    test_ring_reserve();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(msg_ring, NULL, NULL, test_ring_setup, NULL, NULL);
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include "rollup.h"
+
+static struct rollup test_rollup;
+
+struct collect_ctx {
+    uint32_t count;
+    struct rollup_record records[8];
+};
+
+static bool collect(enum rollup_tier tier, const struct rollup_record *rec, void *user_data)
+{
+    struct collect_ctx *ctx = user_data;
+
+    ARG_UNUSED(tier);
+    if (ctx->count < ARRAY_SIZE(ctx->records)) {
+        ctx->records[ctx->count++] = *rec;
+    }
+    return true;
+}
+
+static void add_sample(uint32_t timestamp, int16_t temp_centi_c)
+{
+    struct sensor_data_msg msg = {
+        .timestamp = timestamp,
+        .temperature_centi_c = temp_centi_c,
+        .humidity_deci_pct = 500,
+        .pressure_pa_off = 51325,
+        .flags = SENSOR_SOURCE_INTERNAL
+    };
+
+    rollup_add(&test_rollup, &msg);
+}
+
+// Test setup function
+static void test_rollup_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    rollup_init(&test_rollup);
+}
+
+/* Test cases for the rollup tiers */
+
+static void test_rollup_minute_records(void)
+{
+    struct collect_ctx ctx = {0};
+
+    add_sample(1000, 2000);
+    add_sample(30000, 2200);
+    add_sample(61000, 2400);
+
+    rollup_query(&test_rollup, ROLLUP_TIER_MINUTE, 0, UINT32_MAX, collect, &ctx);
+    zassert_equal(ctx.count, 2, "Closed and open minute expected");
+
+    // Newest first: the open minute, then the closed one
+    zassert_equal(ctx.records[0].start, 60000, "Open minute start");
+    zassert_equal(ctx.records[0].count, 1, "Open minute count");
+    zassert_equal(ctx.records[1].start, 0, "Closed minute start");
+    zassert_equal(ctx.records[1].count, 2, "Closed minute count");
+    zassert_equal(ctx.records[1].temp_min, 2000, "Closed minute min");
+    zassert_equal(ctx.records[1].temp_max, 2200, "Closed minute max");
+    zassert_equal(ctx.records[1].temp_avg, 2100, "Closed minute avg");
+    zassert_equal(ctx.records[1].pressure_avg, 51325, "Pressure kept as offset");
+}
+
+static void test_rollup_hour_outlives_minutes(void)
+{
+    struct collect_ctx ctx = {0};
+    uint32_t oldest;
+
+    // More minutes than the minute ring holds, all in the first hour
+    for (uint32_t m = 0; m < ROLLUP_MINUTES + 2; m++) {
+        add_sample(m * ROLLUP_MINUTE_MS, (int16_t)(m * 10));
+    }
+
+    zassert_true(rollup_tier_oldest(&test_rollup, ROLLUP_TIER_MINUTE, &oldest),
+                 "Minute tier should hold data");
+    zassert_true(oldest > 0, "Oldest minutes should have been overwritten");
+
+    rollup_query(&test_rollup, ROLLUP_TIER_HOUR, 0, UINT32_MAX, collect, &ctx);
+    zassert_equal(ctx.count, 1, "Single open hour expected");
+    zassert_equal(ctx.records[0].count, ROLLUP_MINUTES + 2, "Hour should count every sample");
+    zassert_equal(ctx.records[0].temp_min, 0, "Hour should keep the overwritten minutes");
+}
+
+static void test_rollup_select_tier(void)
+{
+    for (uint32_t m = 0; m < 3; m++) {
+        add_sample(m * ROLLUP_MINUTE_MS, 2000);
+    }
+
+    // Fine steps over covered data use the raw samples
+    zassert_equal(rollup_select_tier(&test_rollup, 0, 1000), ROLLUP_TIER_RAW,
+                  "Raw tier should be picked for fine steps");
+    // Coarser steps use the coarsest tier that still has the data
+    zassert_equal(rollup_select_tier(&test_rollup, 0, ROLLUP_MINUTE_MS), ROLLUP_TIER_MINUTE,
+                  "Minute tier should be picked for minute steps");
+    zassert_equal(rollup_select_tier(&test_rollup, 0, ROLLUP_HOUR_MS), ROLLUP_TIER_HOUR,
+                  "Hour tier should be picked for hour steps");
+}
+
+static void test_rollup_raw_range(void)
+{
+    struct collect_ctx ctx = {0};
+    uint32_t oldest;
+
+    add_sample(1000, 100);
+    add_sample(2000, 200);
+    add_sample(3000, 300);
+
+    zassert_true(rollup_tier_oldest(&test_rollup, ROLLUP_TIER_RAW, &oldest), "Raw has data");
+    zassert_equal(oldest, 1000, "Oldest raw sample");
+
+    rollup_query(&test_rollup, ROLLUP_TIER_RAW, 1500, 2500, collect, &ctx);
+    zassert_equal(ctx.count, 1, "Only the sample inside the range");
+    zassert_equal(ctx.records[0].temp_avg, 200, "Sample value");
+}
+
+static void test_rollup_raw_steps(void)
+{
+    struct collect_ctx ctx = {0};
+
+    for (uint32_t t = 1000; t <= 8000; t += 1000) {
+        add_sample(t, (int16_t)(t / 10));
+    }
+
+    // 4 s steps: 8000 alone, then 4000-7000, then 1000-3000
+    zassert_equal(rollup_query_steps(&test_rollup, ROLLUP_TIER_RAW, 0, 8000, 4000,
+                                     collect, &ctx), 3, "One row per step");
+    zassert_equal(ctx.records[0].count, 1, "Newest step");
+    zassert_equal(ctx.records[1].start, 4000, "Step starts at its oldest sample");
+    zassert_equal(ctx.records[1].count, 4, "Samples merged into the step");
+    zassert_equal(ctx.records[1].temp_min, 400, "Step min");
+    zassert_equal(ctx.records[1].temp_max, 700, "Step max");
+    zassert_equal(ctx.records[1].temp_avg, 550, "Step avg");
+    zassert_equal(ctx.records[1].humidity_avg, 500, "Step humidity avg");
+    zassert_equal(ctx.records[2].count, 3, "Oldest step");
+    zassert_equal(ctx.records[2].temp_avg, 200, "Oldest step avg");
+}
+
+/* ZTEST definitions */
+
+ZTEST(rollup, test_minute_records)
+{
+    test_rollup_minute_records();
+}
+
+ZTEST(rollup, test_hour_outlives_minutes)
+{
+    test_rollup_hour_outlives_minutes();
+}
+
+ZTEST(rollup, test_select_tier)
+{
+    test_rollup_select_tier();
+}
+
+ZTEST(rollup, test_raw_range)
+{
+    test_rollup_raw_range();
+}
+
+ZTEST(rollup, test_raw_steps)
+{
+    test_rollup_raw_steps();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(rollup, NULL, NULL, test_rollup_setup, NULL, NULL);
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include "sample_cache.h"
+
+static struct sample_cache test_cache;
+
+static struct sensor_data_msg make_sample(uint8_t id, uint16_t sequence)
+{
+    return (struct sensor_data_msg){
+        .timestamp = 1000U * sequence,
+        .sequence = sequence,
+        .temperature_centi_c = (int16_t)(2000 + sequence),
+        .humidity_deci_pct = 450,
+        .pressure_pa_off = 51325,
+        .flags = SENSOR_SOURCE_INTERNAL | sensor_id_flags(id),
+    };
+}
+
+// Test setup function
+static void test_cache_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    sample_cache_init(&test_cache);
+}
+
+/* Test cases for the latest-value cache */
+
+static void test_cache_empty(void)
+{
+    struct sensor_data_msg msg;
+
+    zassert_equal(sample_cache_latest(&test_cache, &msg), -ENODATA, "Empty cache");
+    zassert_equal(sample_cache_get(&test_cache, 0, &msg), -ENODATA, "No sample for sensor 0");
+    zassert_equal(sample_cache_get(&test_cache, SENSOR_ID_MAX + 1, &msg), -EINVAL,
+                  "Id past the maximum");
+    zassert_equal(sample_cache_sensors(&test_cache), 0, "No sensors yet");
+}
+
+static void test_cache_per_sensor(void)
+{
+    struct sensor_data_msg in;
+    struct sensor_data_msg msg;
+
+    in = make_sample(2, 1);
+    sample_cache_put(&test_cache, &in);
+    in = make_sample(5, 2);
+    sample_cache_put(&test_cache, &in);
+    in = make_sample(2, 3);
+    sample_cache_put(&test_cache, &in);
+
+    zassert_equal(sample_cache_sensors(&test_cache), BIT(2) | BIT(5), "Sensors 2 and 5");
+
+    zassert_equal(sample_cache_get(&test_cache, 2, &msg), 0, "Sensor 2 has a sample");
+    zassert_equal(msg.sequence, 3, "Newest sample of sensor 2");
+    zassert_equal(sample_cache_get(&test_cache, 5, &msg), 0, "Sensor 5 has a sample");
+    zassert_equal(msg.sequence, 2, "Newest sample of sensor 5");
+    zassert_equal(sample_cache_get(&test_cache, 3, &msg), -ENODATA, "Sensor 3 has none");
+
+    zassert_equal(sample_cache_latest(&test_cache, &msg), 0, "Latest sample");
+    zassert_mem_equal(&msg, &in, sizeof(msg), "Latest is the last put");
+}
+
+static void test_cache_read_retry(void)
+{
+    struct sensor_data_msg in = make_sample(0, 1);
+    struct sensor_data_msg msg;
+
+    sample_cache_put(&test_cache, &in);
+
+    // A put between begin and retry invalidates the read
+    uint32_t seq = seqlock_read_begin(&test_cache.lock);
+
+    zassert_false(seqlock_read_retry(&test_cache.lock, seq), "Nothing written yet");
+    in = make_sample(0, 2);
+    sample_cache_put(&test_cache, &in);
+    zassert_true(seqlock_read_retry(&test_cache.lock, seq), "Write during the read");
+
+    // A writer stopped halfway leaves readers a complete older sample
+    seqlock_write_switch(&test_cache.lock);
+    test_cache.copies[0].samples[0].temperature_centi_c = -1;
+
+    zassert_equal(sample_cache_get(&test_cache, 0, &msg), 0, "Reader should not wait");
+    zassert_equal(msg.sequence, 2, "Previous sample should be returned");
+    zassert_equal(msg.temperature_centi_c, 2002, "Sample should not be torn");
+}
+
+/* ZTEST definitions */
+
+ZTEST(sample_cache, test_empty)
+{
+    test_cache_empty();
+}
+
+ZTEST(sample_cache, test_per_sensor)
+{
+    test_cache_per_sensor();
+}
+
+ZTEST(sample_cache, test_read_retry)
+{
+    test_cache_read_retry();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(sample_cache, NULL, NULL, test_cache_setup, NULL, NULL);
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include <string.h>
+#include "messages.h"
+#include "sample_codec.h"
+
+#define TEST_SAMPLES 64
+
+static uint8_t test_block[1024];
+static struct sample_record test_records[TEST_SAMPLES];
+
+/* Slowly changing samples every 10 s, like a real weather sensor */
+static void make_samples(uint32_t count)
+{
+    uint32_t state = 1;
+
+    for (uint32_t i = 0; i < count; i++) {
+        state = state * 1103515245U + 12345U;
+
+        test_records[i] = (struct sample_record){
+            .time = 5000 + i * 10000 + ((i == 7) ? 3 : 0),
+            .temperature_centi_c = (int16_t)(2150 + (int32_t)((state >> 16) % 7) - 3 - i),
+            .humidity_deci_pct = (uint16_t)(450 + (i / 8)),
+            .pressure_pa_off = (uint16_t)(51325 + (int32_t)((state >> 8) % 5) - 2),
+            .flags = SENSOR_SOURCE_INTERNAL,
+        };
+    }
+}
+
+static uint32_t encode_samples(uint32_t count)
+{
+    struct sample_codec_encoder enc;
+
+    sample_codec_encoder_init(&enc, test_block, sizeof(test_block));
+    for (uint32_t i = 0; i < count; i++) {
+        zassert_equal(sample_codec_encode(&enc, &test_records[i]), 0, "Sample should fit");
+    }
+
+    return sample_codec_finish(&enc);
+}
+
+// Test setup function
+static void test_codec_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    memset(test_block, 0xAA, sizeof(test_block));
+    make_samples(TEST_SAMPLES);
+}
+
+/* Test cases for the sample block codec */
+
+static void test_codec_roundtrip(void)
+{
+    struct sample_codec_decoder dec;
+    struct sample_record rec;
+    uint32_t len = encode_samples(TEST_SAMPLES);
+
+    zassert_equal(sample_codec_decoder_init(&dec, test_block, len), 0, "Header should be valid");
+    zassert_equal(dec.count, TEST_SAMPLES, "Header should hold the count");
+
+    for (uint32_t i = 0; i < TEST_SAMPLES; i++) {
+        zassert_equal(sample_codec_decode(&dec, &rec), 0, "Sample %u should decode", i);
+        zassert_mem_equal(&rec, &test_records[i], sizeof(rec), "Sample %u should match", i);
+    }
+
+    zassert_equal(sample_codec_decode(&dec, &rec), -ENOENT, "Block should end");
+}
+
+static void test_codec_ratio(void)
+{
+    uint32_t len = encode_samples(TEST_SAMPLES);
+
+    // At least 5x smaller than the messages the samples came from
+    zassert_true(len * 5 <= TEST_SAMPLES * sizeof(struct sensor_data_msg),
+                 "Block of %u bytes is too large", len);
+}
+
+static void test_codec_extremes(void)
+{
+    struct sample_codec_encoder enc;
+    struct sample_codec_decoder dec;
+    struct sample_record rec;
+    // Across 32 bits of log time, then the widest steps back and forth
+    const struct sample_record samples[] = {
+        {UINT32_MAX - 5ULL, INT16_MAX, 0, 0, 0},
+        {UINT32_MAX + 10ULL, INT16_MIN, UINT16_MAX, UINT16_MAX, UINT16_MAX},
+        {UINT32_MAX + 9ULL, 0, 1000, 0, SENSOR_FLAG_ERROR},
+        {UINT32_MAX + 9ULL + INT32_MAX, INT16_MAX, 0, UINT16_MAX, 0},
+        {UINT32_MAX + 9ULL, INT16_MIN, 0, 0, 0},
+    };
+
+    sample_codec_encoder_init(&enc, test_block, sizeof(test_block));
+    for (size_t i = 0; i < ARRAY_SIZE(samples); i++) {
+        zassert_equal(sample_codec_encode(&enc, &samples[i]), 0, "Sample should fit");
+    }
+
+    uint32_t len = sample_codec_finish(&enc);
+
+    zassert_equal(sample_codec_decoder_init(&dec, test_block, len), 0, "Header should be valid");
+    for (size_t i = 0; i < ARRAY_SIZE(samples); i++) {
+        zassert_equal(sample_codec_decode(&dec, &rec), 0, "Sample should decode");
+        zassert_mem_equal(&rec, &samples[i], sizeof(rec), "Sample %u should match", i);
+    }
+}
+
+static void test_codec_full_block(void)
+{
+    struct sample_codec_encoder enc;
+    struct sample_codec_decoder dec;
+    struct sample_record rec;
+    uint32_t encoded = 0;
+
+    // Too small for the header
+    sample_codec_encoder_init(&enc, test_block, SAMPLE_CODEC_HDR_SIZE - 1);
+    zassert_equal(sample_codec_encode(&enc, &test_records[0]), -ENOSPC, "Header should not fit");
+    zassert_equal(sample_codec_finish(&enc), 0, "Empty block has no length");
+
+    sample_codec_encoder_init(&enc, test_block, 64);
+    while (encoded < TEST_SAMPLES && sample_codec_encode(&enc, &test_records[encoded]) == 0) {
+        encoded++;
+    }
+
+    zassert_true(encoded > 1 && encoded < TEST_SAMPLES, "Block should fill up");
+
+    uint32_t len = sample_codec_finish(&enc);
+
+    zassert_true(len <= 64, "Block should not overflow");
+    zassert_equal(sample_codec_decoder_init(&dec, test_block, len), 0, "Header should be valid");
+    for (uint32_t i = 0; i < encoded; i++) {
+        zassert_equal(sample_codec_decode(&dec, &rec), 0, "Sample should decode");
+        zassert_equal(rec.time, test_records[i].time, "Time should match");
+    }
+}
+
+static void test_codec_corrupt(void)
+{
+    struct sample_codec_decoder dec;
+    struct sample_record rec;
+    uint32_t len = encode_samples(TEST_SAMPLES);
+
+    zassert_equal(sample_codec_decoder_init(&dec, test_block, SAMPLE_CODEC_HDR_SIZE - 1),
+                  -EBADMSG, "Short buffer should be rejected");
+    zassert_equal(sample_codec_decoder_init(&dec, test_block, len - 1), -EBADMSG,
+                  "Truncated block should be rejected");
+
+    test_block[0] ^= 0xFF;
+    zassert_equal(sample_codec_decoder_init(&dec, test_block, len), -EBADMSG,
+                  "Bad magic should be rejected");
+    test_block[0] ^= 0xFF;
+
+    // Claim more samples than the block holds
+    test_block[2] = 0xFF;
+    test_block[3] = 0x7F;
+    zassert_equal(sample_codec_decoder_init(&dec, test_block, len), 0, "Header should parse");
+
+    int rc;
+
+    do {
+        rc = sample_codec_decode(&dec, &rec);
+    } while (rc == 0);
+    zassert_equal(rc, -EBADMSG, "Reading past the block should fail");
+}
+
+/* ZTEST definitions */
+
+ZTEST(sample_codec, test_roundtrip)
+{
+    test_codec_roundtrip();
+}
+
+ZTEST(sample_codec, test_ratio)
+{
+    test_codec_ratio();
+}
+
+ZTEST(sample_codec, test_extremes)
+{
+    test_codec_extremes();
+}
+
+ZTEST(sample_codec, test_full_block)
+{
+    test_codec_full_block();
+}
+
+ZTEST(sample_codec, test_corrupt)
+{
+    test_codec_corrupt();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(sample_codec, NULL, NULL, test_codec_setup, NULL, NULL);
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <string.h>
+#include "messages.h"
+#include "sample_export.h"
+
+#define TEST_CHUNK_SIZE 64
+#define TEST_SAMPLES 20
+
+static uint8_t test_chunk[TEST_CHUNK_SIZE];
+
+/* Everything written, chunks back to back */
+static struct {
+    uint8_t data[2048];
+    size_t len;
+    uint32_t chunks;
+    size_t max_chunk;
+    int fail_at;            /* Chunk number to fail, 0 never */
+} test_out;
+
+static int collect_chunk(const uint8_t *data, size_t len, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    test_out.chunks++;
+    if (test_out.chunks == (uint32_t)test_out.fail_at) {
+        return -EIO;
+    }
+
+    zassert_true(test_out.len + len <= sizeof(test_out.data), "Output too long");
+    memcpy(&test_out.data[test_out.len], data, len);
+    test_out.len += len;
+    test_out.max_chunk = MAX(test_out.max_chunk, len);
+    return 0;
+}
+
+static struct sample_record test_sample(uint32_t n)
+{
+    return (struct sample_record){
+        .time = 1000 * n,
+        .temperature_centi_c = (int16_t)(n * 10 - 50),
+        .humidity_deci_pct = (uint16_t)(450 + n),
+        .pressure_pa_off = 51325,
+        .flags = SENSOR_SOURCE_INTERNAL,
+    };
+}
+
+static int export_samples(enum sample_export_format format, uint32_t count)
+{
+    struct sample_export exp;
+
+    int rc = sample_export_init(&exp, format, test_chunk, sizeof(test_chunk), 0, 99999,
+                                collect_chunk, NULL);
+
+    for (uint32_t n = 0; rc == 0 && n < count; n++) {
+        struct sample_record rec = test_sample(n);
+
+        rc = sample_export_add(&exp, &rec);
+    }
+
+    return (rc == 0) ? sample_export_finish(&exp) : rc;
+}
+
+/* Check the frame at pos and return its payload length */
+static uint16_t check_frame(size_t pos, enum sample_export_frame type)
+{
+    const uint8_t *frame = &test_out.data[pos];
+    uint16_t len = sys_get_le16(&frame[2]);
+
+    zassert_equal(frame[0], SAMPLE_EXPORT_SYNC, "Bad sync at %u", (uint32_t)pos);
+    zassert_equal(frame[1], type, "Bad frame type at %u", (uint32_t)pos);
+    zassert_true(pos + len + SAMPLE_EXPORT_FRAME_OVERHEAD <= test_out.len, "Short frame");
+    zassert_equal(sys_get_le32(&frame[SAMPLE_EXPORT_FRAME_HDR_SIZE + len]),
+                  crc32_ieee(&frame[1], len + 3), "Bad CRC at %u", (uint32_t)pos);
+    return len;
+}
+
+// Test setup function
+static void test_export_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    memset(&test_out, 0, sizeof(test_out));
+}
+
+/* Test cases for the sample export */
+
+static void test_export_bin(void)
+{
+    uint32_t records = 0;
+    size_t pos = 0;
+
+    zassert_equal(export_samples(SAMPLE_EXPORT_BIN, TEST_SAMPLES), 0, "Export failed");
+    zassert_true(test_out.max_chunk <= TEST_CHUNK_SIZE, "Chunk larger than the buffer");
+
+    uint16_t len = check_frame(pos, SAMPLE_EXPORT_FRAME_START);
+    const uint8_t *start = &test_out.data[SAMPLE_EXPORT_FRAME_HDR_SIZE];
+
+    zassert_equal(start[0], SAMPLE_EXPORT_VERSION, "Version");
+    zassert_equal(start[1], SAMPLE_EXPORT_RECORD_SIZE, "Record size");
+    zassert_equal(sys_get_le64(&start[12]), 99999, "Range end");
+    pos += len + SAMPLE_EXPORT_FRAME_OVERHEAD;
+
+    while (test_out.data[pos + 1] == SAMPLE_EXPORT_FRAME_DATA) {
+        len = check_frame(pos, SAMPLE_EXPORT_FRAME_DATA);
+        zassert_equal(len % SAMPLE_EXPORT_RECORD_SIZE, 0, "Frames hold whole records");
+
+        for (uint16_t off = 0; off < len; off += SAMPLE_EXPORT_RECORD_SIZE) {
+            const uint8_t *rec = &test_out.data[pos + SAMPLE_EXPORT_FRAME_HDR_SIZE + off];
+            struct sample_record expected = test_sample(records++);
+
+            zassert_equal(sys_get_le64(&rec[0]), expected.time, "Time");
+            zassert_equal((int16_t)sys_get_le16(&rec[8]), expected.temperature_centi_c,
+                          "Temperature");
+            zassert_equal(sys_get_le16(&rec[10]), expected.humidity_deci_pct, "Humidity");
+            zassert_equal(sys_get_le16(&rec[12]), expected.pressure_pa_off, "Pressure");
+            zassert_equal(sys_get_le16(&rec[14]), expected.flags, "Flags");
+        }
+        pos += len + SAMPLE_EXPORT_FRAME_OVERHEAD;
+    }
+
+    len = check_frame(pos, SAMPLE_EXPORT_FRAME_END);
+    zassert_equal(len, 4, "End frame holds the count");
+    zassert_equal(sys_get_le32(&test_out.data[pos + SAMPLE_EXPORT_FRAME_HDR_SIZE]),
+                  TEST_SAMPLES, "Record count");
+    zassert_equal(records, TEST_SAMPLES, "All records framed");
+    zassert_equal(pos + len + SAMPLE_EXPORT_FRAME_OVERHEAD, test_out.len, "Trailing data");
+}
+
+static void test_export_csv(void)
+{
+    zassert_equal(export_samples(SAMPLE_EXPORT_CSV, TEST_SAMPLES), 0, "Export failed");
+    zassert_true(test_out.chunks > 1, "Output should span several chunks");
+    zassert_true(test_out.max_chunk <= TEST_CHUNK_SIZE, "Chunk larger than the buffer");
+
+    test_out.data[test_out.len] = '\0';
+    const char *text = (const char *)test_out.data;
+
+    zassert_true(strncmp(text, "time_ms,", 8) == 0, "Header line first");
+    zassert_not_null(strstr(text, "\n0,-0.50,45.0,101325,0x0001\n"), "Negative temperature");
+    zassert_not_null(strstr(text, "\n19000,1.40,46.9,101325,0x0001\n"), "Last sample");
+
+    uint32_t lines = 0;
+
+    for (size_t i = 0; i < test_out.len; i++) {
+        lines += (test_out.data[i] == '\n');
+    }
+    zassert_equal(lines, TEST_SAMPLES + 1, "One line per sample");
+}
+
+static void test_export_csv_invalid(void)
+{
+    struct sample_export exp;
+    struct sample_record rec = test_sample(3);
+
+    rec.flags |= SENSOR_FLAG_HUMIDITY_INVALID | SENSOR_FLAG_PRESSURE_INVALID;
+
+    zassert_equal(sample_export_init(&exp, SAMPLE_EXPORT_CSV, test_chunk, sizeof(test_chunk),
+                                     0, 10000, collect_chunk, NULL), 0, "Init failed");
+    zassert_equal(sample_export_add(&exp, &rec), 0, "Add failed");
+    zassert_equal(sample_export_finish(&exp), 0, "Finish failed");
+
+    test_out.data[test_out.len] = '\0';
+    zassert_not_null(strstr((const char *)test_out.data, "\n3000,-0.20,,,0x"),
+                     "Invalid fields should be empty");
+}
+
+static void test_export_write_error(void)
+{
+    struct sample_export exp;
+
+    test_out.fail_at = 2;
+    zassert_equal(export_samples(SAMPLE_EXPORT_BIN, TEST_SAMPLES), -EIO,
+                  "Write error should abort");
+    zassert_equal(test_out.chunks, 2, "No writes after the error");
+
+    zassert_equal(sample_export_init(&exp, SAMPLE_EXPORT_BIN, test_chunk, 16, 0, 1,
+                                     collect_chunk, NULL), -EINVAL, "Chunk too small");
+}
+
+/* ZTEST definitions */
+
+ZTEST(sample_export, test_bin)
+{
+    test_export_bin();
+}
+
+ZTEST(sample_export, test_csv)
+{
+    test_export_csv();
+}
+
+ZTEST(sample_export, test_csv_invalid)
+{
+    test_export_csv_invalid();
+}
+
+ZTEST(sample_export, test_write_error)
+{
+    test_export_write_error();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(sample_export, NULL, NULL, test_export_setup, NULL, NULL);
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include "sample_filter.h"
+
+/* Test cases for the sample filter chain */
+
+static const struct sample_filter_config test_filter_off = {
+    .median_size = 1,
+    .ema_alpha_pct = 100,
+};
+
+static struct sample_filter test_filter;
+
+static struct sensor_data_msg test_filter_sample(int16_t temp)
+{
+    return (struct sensor_data_msg){
+        .temperature_centi_c = temp,
+        .humidity_deci_pct = 500,
+        .pressure_pa_off = 51325,
+        .flags = SENSOR_SOURCE_INTERNAL,
+    };
+}
+
+static int16_t test_filter_temp(int16_t temp)
+{
+    struct sensor_data_msg msg = test_filter_sample(temp);
+
+    sample_filter_apply(&test_filter, &msg);
+    return msg.temperature_centi_c;
+}
+
+static void test_filter_passthrough(void)
+{
+    sample_filter_init(&test_filter, &test_filter_off);
+
+    zassert_equal(test_filter_temp(2150), 2150, "First sample");
+    zassert_equal(test_filter_temp(-730), -730, "Disabled stages change nothing");
+}
+
+static void test_filter_median(void)
+{
+    struct sample_filter_config config = test_filter_off;
+
+    config.median_size = 3;
+    sample_filter_init(&test_filter, &config);
+
+    zassert_equal(test_filter_temp(2000), 2000, "One value");
+    zassert_equal(test_filter_temp(2010), 2010, "Upper median of two");
+    zassert_equal(test_filter_temp(9000), 2010, "Spike removed");
+    zassert_equal(test_filter_temp(2020), 2020, "Spike still removed");
+    zassert_equal(test_filter_temp(2030), 2030, "Spike left the window");
+
+    config.median_size = 20;
+    sample_filter_init(&test_filter, &config);
+    zassert_equal(test_filter.config.median_size, SAMPLE_FILTER_MEDIAN_MAX, "Window clamped");
+}
+
+static void test_filter_ema(void)
+{
+    struct sample_filter_config config = test_filter_off;
+
+    config.ema_alpha_pct = 50;
+    sample_filter_init(&test_filter, &config);
+
+    zassert_equal(test_filter_temp(0), 0, "First value primes the average");
+    zassert_equal(test_filter_temp(1000), 500, "Half way");
+    zassert_equal(test_filter_temp(1000), 750, "Three quarters");
+    zassert_equal(test_filter_temp(-1000), -125, "Negative values");
+}
+
+static void test_filter_kalman(void)
+{
+    struct sample_filter_config config = test_filter_off;
+    int16_t out = 0;
+
+    config.kalman_q[0] = 5;
+    config.kalman_r[0] = 50;
+    sample_filter_init(&test_filter, &config);
+
+    // Noise of +-50 around a constant is mostly removed once the gain settles
+    for (int i = 0; i < 40; i++) {
+        out = test_filter_temp((i % 2) ? 2050 : 1950);
+    }
+    zassert_within(out, 2000, 10, "Noise removed: %d", out);
+
+    // A real step is followed, at the settled gain of about q / r per sample
+    for (int i = 0; i < 60; i++) {
+        out = test_filter_temp(3000);
+    }
+    zassert_within(out, 3000, 10, "Step followed: %d", out);
+
+    // Other channels have no Kalman stage configured
+    struct sensor_data_msg msg = test_filter_sample(3000);
+
+    msg.humidity_deci_pct = 800;
+    sample_filter_apply(&test_filter, &msg);
+    zassert_equal(msg.humidity_deci_pct, 800, "Humidity not filtered");
+}
+
+static void test_filter_invalid(void)
+{
+    struct sample_filter_config config = test_filter_off;
+
+    config.ema_alpha_pct = 50;
+    sample_filter_init(&test_filter, &config);
+
+    struct sensor_data_msg msg = test_filter_sample(1000);
+
+    msg.flags |= SENSOR_FLAG_TEMP_INVALID;
+    sample_filter_apply(&test_filter, &msg);
+    zassert_equal(msg.temperature_centi_c, 1000, "Invalid field passed through");
+    zassert_false(test_filter.channels[0].primed, "State untouched");
+
+    zassert_equal(test_filter_temp(2000), 2000, "First valid value primes the average");
+}
+
+/* ZTEST definitions */
+
+ZTEST(sample_filter, test_passthrough)
+{
+    test_filter_passthrough();
+}
+
+ZTEST(sample_filter, test_median)
+{
+    test_filter_median();
+}
+
+ZTEST(sample_filter, test_ema)
+{
+    test_filter_ema();
+}
+
+ZTEST(sample_filter, test_kalman)
+{
+    test_filter_kalman();
+}
+
+ZTEST(sample_filter, test_invalid)
+{
+    test_filter_invalid();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(sample_filter, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include <math.h>
+#include "sample_history.h"
+
+static struct sample_history test_history;
+
+static void append_sample(uint32_t timestamp, float temp, float humidity, float pressure)
+{
+    struct sensor_data_msg msg = {
+        .timestamp = timestamp,
+        .flags = SENSOR_SOURCE_INTERNAL
+    };
+
+    sensor_data_from_float(&msg, temp, humidity, pressure);
+    sample_history_append(&test_history, &msg);
+}
+
+// Test setup function
+static void test_history_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    sample_history_init(&test_history);
+}
+
+/* Test cases for the sample history ring buffer */
+
+static void test_history_empty(void)
+{
+    struct sample_history_cursor cursor;
+    struct sample_history_entry entry;
+
+    zassert_equal(sample_history_count(&test_history), 0, "History should start empty");
+
+    sample_history_cursor_init(&test_history, &cursor, 10);
+    zassert_equal(sample_history_prev(&test_history, &cursor, &entry), -ENOENT,
+                  "Empty history should not return entries");
+}
+
+static void test_history_fixed_point_round_trip(void)
+{
+    struct sample_history_cursor cursor;
+    struct sample_history_entry entry;
+
+    append_sample(1000, -3.456f, 45.04f, 101325.0f);
+
+    sample_history_cursor_init(&test_history, &cursor, 1);
+    zassert_equal(sample_history_prev(&test_history, &cursor, &entry), 0, "Should read entry");
+    zassert_equal(entry.timestamp, 1000, "Timestamp should match");
+    zassert_equal(entry.temperature_centi_c, -346, "Temperature should round to centi-degrees");
+    zassert_equal(entry.humidity_deci_pct, 450, "Humidity should round to deci-percent");
+    zassert_equal(entry.pressure_pa, 101325, "Pressure should match");
+}
+
+static void test_history_invalid_values(void)
+{
+    struct sample_history_cursor cursor;
+    struct sample_history_entry entry;
+
+    append_sample(1000, NAN, NAN, NAN);
+
+    sample_history_cursor_init(&test_history, &cursor, 1);
+    zassert_equal(sample_history_prev(&test_history, &cursor, &entry), 0, "Should read entry");
+    zassert_equal(entry.temperature_centi_c, SAMPLE_HISTORY_TEMP_INVALID, "Temperature invalid");
+    zassert_equal(entry.humidity_deci_pct, SAMPLE_HISTORY_HUMIDITY_INVALID, "Humidity invalid");
+    zassert_equal(entry.pressure_pa, 0, "Pressure invalid");
+}
+
+static void test_history_timestamps_rebuilt(void)
+{
+    struct sample_history_cursor cursor;
+    struct sample_history_entry entry;
+
+    append_sample(1000, 20.0f, 50.0f, 100000.0f);
+    append_sample(1500, 20.0f, 50.0f, 100000.0f);
+    append_sample(61500, 20.0f, 50.0f, 100000.0f);  // Gap stored in seconds
+
+    sample_history_cursor_init(&test_history, &cursor, 3);
+    zassert_equal(sample_history_prev(&test_history, &cursor, &entry), 0, "Should read entry");
+    zassert_equal(entry.timestamp, 61500, "Newest timestamp should be exact");
+    zassert_equal(sample_history_prev(&test_history, &cursor, &entry), 0, "Should read entry");
+    zassert_equal(entry.timestamp, 1500, "Long gap should be rebuilt");
+    zassert_equal(sample_history_prev(&test_history, &cursor, &entry), 0, "Should read entry");
+    zassert_equal(entry.timestamp, 1000, "Short gap should be exact");
+    zassert_equal(sample_history_prev(&test_history, &cursor, &entry), -ENOENT,
+                  "Cursor should stop after the oldest entry");
+}
+
+static void test_history_wraps(void)
+{
+    struct sample_history_cursor cursor;
+    struct sample_history_entry entry;
+    uint32_t read = 0;
+
+    for (uint32_t i = 0; i < SAMPLE_HISTORY_SIZE + 5; i++) {
+        append_sample(i * 10, (float)i / 100.0f, 50.0f, 100000.0f);
+    }
+
+    zassert_equal(sample_history_count(&test_history), SAMPLE_HISTORY_SIZE,
+                  "Count should saturate at capacity");
+
+    sample_history_cursor_init(&test_history, &cursor, UINT32_MAX);
+    while (sample_history_prev(&test_history, &cursor, &entry) == 0) {
+        uint32_t expected = SAMPLE_HISTORY_SIZE + 4 - read;
+
+        zassert_equal(entry.temperature_centi_c, expected, "Entries should be newest first");
+        zassert_equal(entry.timestamp, expected * 10, "Timestamp should match entry");
+        read++;
+    }
+
+    zassert_equal(read, SAMPLE_HISTORY_SIZE, "Should read every retained entry");
+}
+
+static void test_history_cursor_overwritten(void)
+{
+    struct sample_history_cursor cursor;
+    struct sample_history_entry entry;
+
+    for (uint32_t i = 0; i < SAMPLE_HISTORY_SIZE; i++) {
+        append_sample(i, 20.0f, 50.0f, 100000.0f);
+    }
+
+    sample_history_cursor_init(&test_history, &cursor, UINT32_MAX);
+
+    // Overwrite the whole ring behind the reader's back
+    for (uint32_t i = 0; i < SAMPLE_HISTORY_SIZE; i++) {
+        append_sample(SAMPLE_HISTORY_SIZE + i, 20.0f, 50.0f, 100000.0f);
+    }
+
+    zassert_equal(sample_history_prev(&test_history, &cursor, &entry), -ENOENT,
+                  "Overwritten entries must not be returned");
+}
+
+static void test_history_oldest(void)
+{
+    struct sample_history_cursor cursor;
+    struct sample_history_entry entry;
+    uint32_t oldest = 0;
+    uint32_t walked = 0;
+
+    zassert_false(sample_history_oldest(&test_history, &oldest), "Empty history has no oldest");
+
+    // Wrap the ring, with one gap long enough to be stored in seconds
+    for (uint32_t i = 0; i < SAMPLE_HISTORY_SIZE + 5; i++) {
+        append_sample(1000 + i * 100 + ((i > 8) ? 40050 : 0), 20.0f, 50.0f, 101325.0f);
+    }
+
+    sample_history_cursor_init(&test_history, &cursor, SAMPLE_HISTORY_SIZE);
+    while (sample_history_prev(&test_history, &cursor, &entry) == 0) {
+        walked = entry.timestamp;
+    }
+
+    zassert_true(sample_history_oldest(&test_history, &oldest), "History should have an oldest");
+    zassert_equal(oldest, walked, "Oldest should match the cursor walk");
+}
+
+/* ZTEST definitions */
+
+ZTEST(sample_history, test_empty)
+{
+    test_history_empty();
+}
+
+ZTEST(sample_history, test_fixed_point_round_trip)
+{
+    test_history_fixed_point_round_trip();
+}
+
+ZTEST(sample_history, test_invalid_values)
+{
+    test_history_invalid_values();
+}
+
+ZTEST(sample_history, test_timestamps_rebuilt)
+{
+    test_history_timestamps_rebuilt();
+}
+
+ZTEST(sample_history, test_wraps)
+{
+    test_history_wraps();
+}
+
+ZTEST(sample_history, test_cursor_overwritten)
+{
+    test_history_cursor_overwritten();
+}
+
+ZTEST(sample_history, test_oldest)
+{
+    test_history_oldest();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(sample_history, NULL, NULL, test_history_setup, NULL, NULL);
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include "sample_query.h"
+
+struct query_result {
+    uint32_t count;
+    uint32_t stop_after;
+    struct sample_bucket buckets[8];
+};
+
+static struct query_result test_result;
+
+static bool collect_bucket(const struct sample_bucket *bucket, void *user_data)
+{
+    struct query_result *result = user_data;
+
+    if (result->count < ARRAY_SIZE(result->buckets)) {
+        result->buckets[result->count] = *bucket;
+    }
+    result->count++;
+    return result->count != result->stop_after;
+}
+
+/* Temperature 2000 + time / 100 centi-degrees, one sample per second */
+static void run_query(uint32_t from, uint32_t to, uint32_t step, enum sample_agg agg)
+{
+    struct sample_query q;
+
+    sample_query_init(&q, from, to, step, agg, collect_bucket, &test_result);
+
+    for (uint32_t t = 0; t < 20000; t += 1000) {
+        struct sample_record rec = {
+            .time = t,
+            .temperature_centi_c = (int16_t)(2000 + t / 100),
+            .humidity_deci_pct = 500,
+            .flags = SENSOR_SOURCE_INTERNAL | SENSOR_FLAG_PRESSURE_INVALID,
+        };
+
+        if (!sample_query_add(&q, &rec)) {
+            break;
+        }
+    }
+
+    zassert_equal(sample_query_finish(&q), test_result.count, "Bucket count should match");
+}
+
+// Test setup function
+static void test_query_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    memset(&test_result, 0, sizeof(test_result));
+}
+
+/* Test cases for the streaming aggregation */
+
+static void test_query_buckets(void)
+{
+    // Samples at 2..9 s: buckets at 2, 5 and 8 s
+    run_query(2000, 9000, 3000, SAMPLE_AGG_AVG);
+
+    zassert_equal(test_result.count, 3, "Three buckets expected");
+    zassert_equal(test_result.buckets[0].start, 2000, "Buckets start at from");
+    zassert_equal(test_result.buckets[0].count, 3, "Full bucket");
+    zassert_equal(test_result.buckets[0].values[STATS_TEMPERATURE], 2030, "Average of 20-40");
+    zassert_equal(test_result.buckets[2].start, 8000, "Last bucket start");
+    zassert_equal(test_result.buckets[2].count, 2, "Range end cuts the last bucket");
+
+    zassert_true(test_result.buckets[0].valid & BIT(STATS_HUMIDITY), "Humidity is valid");
+    zassert_false(test_result.buckets[0].valid & BIT(STATS_PRESSURE), "Pressure is invalid");
+}
+
+static void test_query_aggregates(void)
+{
+    run_query(0, 4000, 5000, SAMPLE_AGG_MIN);
+    zassert_equal(test_result.buckets[0].values[STATS_TEMPERATURE], 2000, "Minimum");
+
+    test_query_setup(NULL);
+    run_query(0, 4000, 5000, SAMPLE_AGG_MAX);
+    zassert_equal(test_result.buckets[0].values[STATS_TEMPERATURE], 2040, "Maximum");
+
+    test_query_setup(NULL);
+    run_query(0, 3000, 5000, SAMPLE_AGG_LAST);
+    zassert_equal(test_result.buckets[0].values[STATS_TEMPERATURE], 2030, "Last value");
+}
+
+static void test_query_raw(void)
+{
+    run_query(5000, 7000, 0, SAMPLE_AGG_AVG);
+
+    zassert_equal(test_result.count, 3, "Every sample is a bucket");
+    zassert_equal(test_result.buckets[1].start, 6000, "Bucket starts at the sample");
+    zassert_equal(test_result.buckets[1].count, 1, "One sample per bucket");
+}
+
+static void test_query_stop(void)
+{
+    test_result.stop_after = 2;
+    run_query(0, 19000, 1000, SAMPLE_AGG_AVG);
+
+    zassert_equal(test_result.count, 2, "Callback should stop the query");
+}
+
+/* ZTEST definitions */
+
+ZTEST(sample_query, test_buckets)
+{
+    test_query_buckets();
+}
+
+ZTEST(sample_query, test_aggregates)
+{
+    test_query_aggregates();
+}
+
+ZTEST(sample_query, test_raw)
+{
+    test_query_raw();
+}
+
+ZTEST(sample_query, test_stop)
+{
+    test_query_stop();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(sample_query, NULL, NULL, test_query_setup, NULL, NULL);
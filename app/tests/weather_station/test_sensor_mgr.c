@@ -24,15 +24,17 @@ static void mock_sensor_mgr_trigger_handler(const struct zbus_channel *chan)
 
     // Create mock sensor data
     struct sensor_data_msg sensor_data = {
-        .timestamp = k_uptime_get(),
-        .temperature_c = 22.5f + (msg->sequence * 0.1f),  // Vary by sequence
-        .humidity_percent = 45.0f + (msg->sequence * 0.5f),
-        .pressure_pa = 101325.0f + (msg->sequence * 10.0f),
-        .source_flags = SENSOR_SOURCE_INTERNAL,
+        .timestamp = k_uptime_get_32(),
         .sequence = msg->sequence,  // Use trigger sequence for simplicity
-        .status = 0
+        .trigger_seq = msg->sequence,
+        .flags = SENSOR_SOURCE_INTERNAL
     };
 
+    sensor_data_from_float(&sensor_data,
+                           22.5f + (msg->sequence * 0.1f),  // Vary by sequence
+                           45.0f + (msg->sequence * 0.5f),
+                           101325.0f + (msg->sequence * 10.0f));
+
     // Publish sensor data
     int rc = zbus_chan_pub(ZBUS_REF(ws_sensor_data), &sensor_data, K_MSEC(100));
     if (rc == 0) {
@@ -99,8 +101,8 @@ static void test_sensor_trigger_handling(void)
     zassert_equal(trigger_received_count, 1, "Should have received exactly one trigger");
     zassert_equal(sensor_data_published_count, 1, "Should have published exactly one sensor data message");
     zassert_equal(last_published_data.sequence, test_trigger.sequence, "Sensor data sequence should match trigger sequence");
-    zassert_equal(last_published_data.source_flags, SENSOR_SOURCE_INTERNAL, "Should use internal source flag");
-    zassert_equal(last_published_data.status, 0, "Status should be success");
+    zassert_equal(last_published_data.flags, SENSOR_SOURCE_INTERNAL, "Should use internal source flag");
+    zassert_false(last_published_data.flags & SENSOR_FLAG_ERROR, "Status should be success");
 }
 
 static void test_sensor_multiple_triggers(void)
@@ -156,11 +158,12 @@ static void test_sensor_data_variation(void)
     // Verify sensor data has expected values with variation
     zassert_equal(sensor_data_published_count, 1, "Should have published sensor data");
     zassert_equal(last_published_data.sequence, test_trigger.sequence, "Sequence should match trigger");
-    zassert_true(last_published_data.temperature_c > 22.0f && last_published_data.temperature_c < 23.0f,
+    zassert_true(last_published_data.temperature_centi_c > 3200 && last_published_data.temperature_centi_c < 3300,
                 "Temperature should be in expected range");
-    zassert_true(last_published_data.humidity_percent > 45.0f && last_published_data.humidity_percent < 50.0f,
+    zassert_true(last_published_data.humidity_deci_pct > 900 && last_published_data.humidity_deci_pct < 1000,
                 "Humidity should be in expected range");
-    zassert_true(last_published_data.pressure_pa > 101325.0f && last_published_data.pressure_pa < 101335.0f,
+    zassert_true(sensor_data_pressure(&last_published_data) > 102300 &&
+                 sensor_data_pressure(&last_published_data) < 102400,
                 "Pressure should be in expected range");
 }
 
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include "stats_window.h"
+
+/* 4 buckets of 1 s, the window covers 3 to 4 s */
+STATS_WINDOW_DEFINE(test_window, 1000, 4);
+
+static void add_temperature(int64_t now_ms, int32_t value)
+{
+    int32_t values[STATS_CHANNEL_COUNT] = {value, 0, 0};
+
+    stats_window_add(&test_window, now_ms, values, BIT(STATS_TEMPERATURE));
+}
+
+// Test setup function
+static void test_stats_setup(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    stats_window_reset(&test_window);
+}
+
+/* Test cases for the streaming statistics */
+
+static void test_stats_acc_summary(void)
+{
+    struct stats_acc acc;
+    struct aggregate_stats summary;
+    const int32_t values[] = {2, 4, 4, 4, 5, 5, 7, 9};
+
+    stats_acc_reset(&acc);
+    for (size_t i = 0; i < ARRAY_SIZE(values); i++) {
+        stats_acc_add(&acc, values[i]);
+    }
+
+    stats_acc_summary(&acc, &summary);
+    zassert_equal(summary.count, 8, "Count should match");
+    zassert_equal(summary.min, 2, "Min should match");
+    zassert_equal(summary.max, 9, "Max should match");
+    zassert_equal(summary.mean, 5, "Mean should match");
+    // Sample variance 32/7, truncated square root
+    zassert_equal(summary.stddev, 2, "Stddev should match");
+}
+
+static void test_stats_acc_large_values(void)
+{
+    struct stats_acc acc;
+    struct aggregate_stats summary;
+
+    stats_acc_reset(&acc);
+
+    // A day of pressure samples, sum^2 alone would not fit in 64 bits
+    for (int32_t i = 0; i < 86400; i++) {
+        stats_acc_add(&acc, (i % 2 == 0) ? 101300 : 101320);
+    }
+
+    stats_acc_summary(&acc, &summary);
+    zassert_equal(summary.mean, 101310, "Mean should match");
+    zassert_equal(summary.stddev, 10, "Stddev should match");
+
+    // Halves round away from zero
+    stats_acc_reset(&acc);
+    stats_acc_add(&acc, -1);
+    stats_acc_add(&acc, -2);
+    stats_acc_summary(&acc, &summary);
+    zassert_equal(summary.mean, -2, "Negative mean should round away from zero");
+}
+
+static void test_stats_running_matches_acc(void)
+{
+    struct stats_running run;
+    struct stats_acc acc;
+    struct aggregate_stats a, b;
+
+    stats_running_reset(&run);
+    stats_acc_reset(&acc);
+
+    // Large offset, small spread
+    for (int32_t i = 0; i < 1000; i++) {
+        int32_t value = 101000 + (i % 50) * 10;
+
+        stats_running_add(&run, value);
+        stats_acc_add(&acc, value);
+    }
+
+    stats_running_summary(&run, &a);
+    stats_acc_summary(&acc, &b);
+    zassert_equal(a.count, b.count, "Counts should match");
+    zassert_equal(a.min, b.min, "Min should match");
+    zassert_equal(a.max, b.max, "Max should match");
+    zassert_equal(a.mean, b.mean, "Means should match");
+    zassert_within(a.stddev, b.stddev, 1, "Stddev should match");
+}
+
+static void test_stats_window_expires(void)
+{
+    struct aggregate_stats summary;
+
+    add_temperature(0, 100);
+    add_temperature(1500, 200);
+    add_temperature(3200, 300);
+
+    stats_window_summary(&test_window, 3200, STATS_TEMPERATURE, &summary);
+    zassert_equal(summary.count, 3, "All samples should be in the window");
+    zassert_equal(summary.min, 100, "Min should match");
+    zassert_equal(summary.max, 300, "Max should match");
+
+    // The bucket holding t=0 expires when t=4000 starts a new one
+    stats_window_summary(&test_window, 4000, STATS_TEMPERATURE, &summary);
+    zassert_equal(summary.count, 2, "Oldest bucket should have expired");
+    zassert_equal(summary.min, 200, "Min should come from the remaining buckets");
+    zassert_equal(summary.mean, 250, "Mean should come from the remaining buckets");
+
+    stats_window_summary(&test_window, 60000, STATS_TEMPERATURE, &summary);
+    zassert_equal(summary.count, 0, "Long gap should empty the window");
+}
+
+static void test_stats_window_invalid_channels(void)
+{
+    struct sensor_data_msg msg = {
+        .flags = SENSOR_SOURCE_INTERNAL | SENSOR_FLAG_HUMIDITY_INVALID,
+        .temperature_centi_c = 2150,
+        .pressure_pa_off = 51325
+    };
+    int32_t values[STATS_CHANNEL_COUNT];
+    struct aggregate_stats summary;
+    uint32_t valid = stats_sample_values(&msg, values);
+
+    zassert_equal(valid, BIT(STATS_TEMPERATURE) | BIT(STATS_PRESSURE),
+                  "Invalid humidity should be masked");
+    zassert_equal(values[STATS_PRESSURE], 101325, "Pressure should be in Pa");
+
+    stats_window_add(&test_window, 0, values, valid);
+    stats_window_summary(&test_window, 0, STATS_HUMIDITY, &summary);
+    zassert_equal(summary.count, 0, "Invalid channel should not be counted");
+    stats_window_summary(&test_window, 0, STATS_PRESSURE, &summary);
+    zassert_equal(summary.mean, 101325, "Valid channel should be counted");
+}
+
+/* ZTEST definitions */
+
+ZTEST(stats_window, test_acc_summary)
+{
+    test_stats_acc_summary();
+}
+
+ZTEST(stats_window, test_acc_large_values)
+{
+    test_stats_acc_large_values();
+}
+
+ZTEST(stats_window, test_running_matches_acc)
+{
+    test_stats_running_matches_acc();
+}
+
+ZTEST(stats_window, test_window_expires)
+{
+    test_stats_window_expires();
+}
+
+ZTEST(stats_window, test_window_invalid_channels)
+{
+    test_stats_window_invalid_channels();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(stats_window, NULL, NULL, test_stats_setup, NULL, NULL);
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2024 Zephyr Weather Station
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include <string.h>
+#include "value_fmt.h"
+
+/* Test cases for the fixed-point value formatter */
+
+static void test_fmt_fixed(void)
+{
+    static const struct {
+        int32_t value;
+        unsigned int decimals;
+        const char *text;
+    } cases[] = {
+        {2150, 2, "21.50"},
+        {-5, 2, "-0.05"},
+        {-1234, 1, "-123.4"},
+        {0, 2, "0.00"},
+        {101325, 0, "101325"},
+        {7, 3, "0.007"},
+        {INT32_MIN, 0, "-2147483648"},
+        {INT32_MAX, 9, "2.147483647"},
+    };
+    char buf[VALUE_FMT_LEN];
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        size_t len = value_fmt_fixed(buf, sizeof(buf), cases[i].value, cases[i].decimals);
+
+        zassert_str_equal(buf, cases[i].text, "Case %zu", i);
+        zassert_equal(len, strlen(cases[i].text), "Length of case %zu", i);
+    }
+}
+
+static void test_fmt_truncate(void)
+{
+    char buf[4];
+
+    zassert_equal(value_fmt_fixed(buf, sizeof(buf), -2150, 2), 3, "Truncated length");
+    zassert_str_equal(buf, "-21", "Truncated text");
+
+    zassert_equal(value_fmt_fixed(buf, sizeof(buf), 1234, 1), 3, "Truncated at the point");
+    zassert_str_equal(buf, "123", "No dangling point");
+
+    zassert_equal(value_fmt_fixed(buf, 1, 5, 0), 0, "Room for the NUL only");
+    zassert_equal(buf[0], '\0', "Empty text");
+}
+
+static void test_fmt_sample(void)
+{
+    struct sensor_data_msg msg = {
+        .temperature_centi_c = -1205,
+        .humidity_deci_pct = 455,
+        .pressure_pa_off = 51325,
+        .flags = SENSOR_SOURCE_INTERNAL,
+    };
+    char buf[VALUE_FMT_LEN];
+
+    value_fmt_temperature(buf, sizeof(buf), &msg);
+    zassert_str_equal(buf, "-12.05", "Temperature in °C");
+    value_fmt_humidity(buf, sizeof(buf), &msg);
+    zassert_str_equal(buf, "45.5", "Humidity in %");
+    value_fmt_pressure(buf, sizeof(buf), &msg);
+    zassert_str_equal(buf, "101325", "Pressure in Pa");
+
+    msg.flags |= SENSOR_FLAG_HUMIDITY_INVALID;
+    value_fmt_humidity(buf, sizeof(buf), &msg);
+    zassert_str_equal(buf, "n/a", "Invalid humidity");
+}
+
+/* ZTEST definitions */
+
+ZTEST(value_fmt, test_fixed)
+{
+    test_fmt_fixed();
+}
+
+ZTEST(value_fmt, test_truncate)
+{
+    test_fmt_truncate();
+}
+
+ZTEST(value_fmt, test_sample)
+{
+    test_fmt_sample();
+}
+
+/* Define the test suite */
+ZTEST_SUITE(value_fmt, NULL, NULL, NULL, NULL, NULL);
@@ -16,23 +16,123 @@ static void test_message_structures(void)
 
     struct sensor_data_msg sensor_data = {
         .timestamp = 123456,
-        .temperature_c = 22.5f,
-        .humidity_percent = 45.0f,
-        .pressure_pa = 101325.0f,
-        .source_flags = SENSOR_SOURCE_INTERNAL,
-        .sequence = 1,
-        .status = 0
+        .temperature_centi_c = 2250,
+        .humidity_deci_pct = 450,
+        .pressure_pa_off = 101325 - SENSOR_PRESSURE_BASE_PA,
+        .flags = SENSOR_SOURCE_INTERNAL,
+        .sequence = 1
     };
 
     zassert_equal(trigger.source, TRIGGER_MANUAL, "Trigger source should be manual");
     zassert_equal(trigger.sequence, 42, "Trigger sequence should be 42");
 
-    zassert_equal(sensor_data.temperature_c, 22.5f, "Temperature should be 22.5°C");
-    zassert_equal(sensor_data.humidity_percent, 45.0f, "Humidity should be 45.0%");
-    zassert_equal(sensor_data.pressure_pa, 101325.0f, "Pressure should be 101325.0 Pa");
-    zassert_true(sensor_data.source_flags & SENSOR_SOURCE_INTERNAL, "Should have internal source flag");
+    zassert_equal(sensor_data_temperature_c(&sensor_data), 22.5f, "Temperature should be 22.5°C");
+    zassert_equal(sensor_data_humidity_percent(&sensor_data), 45.0f, "Humidity should be 45.0%");
+    zassert_equal(sensor_data_pressure(&sensor_data), 101325, "Pressure should be 101325 Pa");
+    zassert_true(sensor_data.flags & SENSOR_SOURCE_INTERNAL, "Should have internal source flag");
     zassert_equal(sensor_data.sequence, 1, "Sequence should be 1");
-    zassert_equal(sensor_data.status, 0, "Status should be 0");
+    zassert_false(sensor_data.flags & SENSOR_FLAG_ERROR, "Status should be OK");
+}
+
+static void test_sensor_data_compact(void)
+{
+    zassert_true(sizeof(struct sensor_data_msg) <= 16, "Sensor data message should be compact");
+}
+
+static void test_sensor_data_conversion(void)
+{
+    struct sensor_data_msg sensor_data = {
+        .flags = SENSOR_SOURCE_INTERNAL
+    };
+
+    sensor_data_from_float(&sensor_data, -3.456f, 45.04f, 101325.4f);
+    zassert_equal(sensor_data.temperature_centi_c, -346, "Temperature should round to centi-degrees");
+    zassert_equal(sensor_data.humidity_deci_pct, 450, "Humidity should round to deci-percent");
+    zassert_equal(sensor_data_pressure(&sensor_data), 101325, "Pressure should round to Pa");
+    zassert_equal(sensor_data.flags, SENSOR_SOURCE_INTERNAL, "No field should be invalid");
+
+    sensor_data_from_float(&sensor_data, NAN, 150.0f, 20000.0f);
+    zassert_true(sensor_data.flags & SENSOR_FLAG_TEMP_INVALID, "NaN should mark temperature invalid");
+    zassert_true(isnan(sensor_data_temperature_c(&sensor_data)), "Invalid temperature reads as NaN");
+    zassert_equal(sensor_data.humidity_deci_pct, 1000, "Humidity should clamp to 100%");
+    zassert_equal(sensor_data_pressure(&sensor_data), SENSOR_PRESSURE_BASE_PA,
+                  "Pressure should clamp to the offset base");
+}
+
+static void test_sensor_id(void)
+{
+    struct sensor_data_msg sensor_data = {
+        .flags = SENSOR_SOURCE_INTERNAL | sensor_id_flags(5)
+    };
+
+    zassert_equal(sensor_data_id(&sensor_data), 5, "Sensor id should round trip");
+    zassert_true(sensor_data.flags & SENSOR_SOURCE_INTERNAL, "Source bits should be kept");
+
+    sensor_data_from_float(&sensor_data, 20.0f, NAN, 100000.0f);
+    zassert_equal(sensor_data_id(&sensor_data), 5, "Conversion should keep the sensor id");
+
+    sensor_data.flags = sensor_id_flags(SENSOR_ID_MAX) | SENSOR_FLAG_ERROR;
+    zassert_equal(sensor_data_id(&sensor_data), SENSOR_ID_MAX, "Largest id should fit");
+    zassert_true(sensor_data.flags & SENSOR_FLAG_ERROR, "Id should not touch status bits");
+    zassert_equal(sensor_id_flags(SENSOR_ID_MAX + 1), 0, "Ids past the maximum are masked");
+
+    zassert_false(sensor_data_synthetic(&sensor_data), "Samples are real by default");
+    sensor_data.flags |= SENSOR_FLAG_SYNTHETIC;
+    zassert_true(sensor_data_synthetic(&sensor_data), "Synthetic flag should be seen");
+    zassert_equal(sensor_data_id(&sensor_data), SENSOR_ID_MAX, "Flag should not touch the id");
+}
+
+static void test_sensor_coalesced(void)
+{
+    struct sensor_data_msg sensor_data = {
+        .flags = SENSOR_SOURCE_INTERNAL | sensor_id_flags(SENSOR_ID_MAX)
+    };
+
+    sensor_data_set_served(&sensor_data, 7, 3);
+    zassert_equal(sensor_data.trigger_seq, 7, "Trigger should round trip");
+    zassert_equal(sensor_data.coalesced, 3, "Count should round trip");
+    zassert_equal(sensor_data_id(&sensor_data), SENSOR_ID_MAX, "Sensor id should be kept");
+
+    // The sequence keeps its low bits, the count saturates
+    sensor_data_set_served(&sensor_data, 0x1FFFE, 100000);
+    zassert_equal(sensor_data.trigger_seq, 0xFE, "Trigger wraps");
+    zassert_equal(sensor_data.coalesced, SENSOR_COALESCED_MAX, "Count saturates");
+}
+
+/* Flags of a read started for first, with the triggers of folded folded into it */
+static uint16_t read_flags(enum trigger_source first, const enum trigger_source *folded,
+                           size_t count)
+{
+    uint16_t flags = trigger_sample_flags(first);
+
+    for (size_t i = 0; i < count; i++) {
+        flags &= trigger_sample_flags(folded[i]);
+    }
+
+    return SENSOR_SOURCE_INTERNAL | flags;
+}
+
+static void test_bench_trigger_synthetic(void)
+{
+    const enum trigger_source bench[] = {TRIGGER_BENCH, TRIGGER_BENCH};
+    const enum trigger_source mixed[] = {TRIGGER_BENCH, TRIGGER_TIMER};
+    struct sensor_data_msg sensor_data = {0};
+
+    // Storage, the cache and the statistics drop synthetic samples
+    sensor_data.flags = read_flags(TRIGGER_BENCH, NULL, 0);
+    zassert_true(sensor_data_synthetic(&sensor_data), "Bench read should not be stored");
+    sensor_data.flags = read_flags(TRIGGER_BENCH, bench, ARRAY_SIZE(bench));
+    zassert_true(sensor_data_synthetic(&sensor_data), "Folded bench triggers stay synthetic");
+
+    // A real trigger served by the read keeps its sample
+    sensor_data.flags = read_flags(TRIGGER_BENCH, mixed, ARRAY_SIZE(mixed));
+    zassert_false(sensor_data_synthetic(&sensor_data), "Timer trigger folded in keeps it");
+    sensor_data.flags = read_flags(TRIGGER_MANUAL, bench, ARRAY_SIZE(bench));
+    zassert_false(sensor_data_synthetic(&sensor_data), "Shell read with bench folded in");
+    sensor_data.flags = read_flags(TRIGGER_TIMER, NULL, 0);
+    zassert_false(sensor_data_synthetic(&sensor_data), "Timer read is stored");
+    sensor_data.flags = read_flags(TRIGGER_EXTERNAL, NULL, 0);
+    zassert_false(sensor_data_synthetic(&sensor_data), "External read is stored");
 }
 
 ZTEST(weather_station, test_message_structures)
@@ -40,4 +140,29 @@ ZTEST(weather_station, test_message_structures)
     test_message_structures();
 }
 
+ZTEST(weather_station, test_sensor_data_compact)
+{
+    test_sensor_data_compact();
+}
+
+ZTEST(weather_station, test_sensor_data_conversion)
+{
+    test_sensor_data_conversion();
+}
+
+ZTEST(weather_station, test_sensor_id)
+{
+    test_sensor_id();
+}
+
+ZTEST(weather_station, test_sensor_coalesced)
+{
+    test_sensor_coalesced();
+}
+
+ZTEST(weather_station, test_bench_trigger_synthetic)
+{
+    test_bench_trigger_synthetic();
+}
+
 ZTEST_SUITE(weather_station, NULL, NULL, NULL, NULL, NULL);
\ No newline at end of file